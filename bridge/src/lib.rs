@@ -4,9 +4,10 @@ mod model_downloader;
 
 use std::collections::HashMap;
 use std::ffi::CStr;
-use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
 use std::sync::{Arc, Mutex, OnceLock};
 use std::thread::JoinHandle;
+use std::time::Instant;
 
 use glam::Mat4;
 use stardust_xr_asteroids as ast; // alias for brevity
@@ -29,26 +30,63 @@ static MODEL_DOWNLOADER: OnceLock<ModelDownloader> = OnceLock::new();
 #[derive(Clone, serde::Serialize, serde::Deserialize)]
 struct BridgeState {
     nodes: HashMap<u64, Node>,
+    // child id -> parent id; node transforms are relative to their parent
+    parents: HashMap<u64, u64>,
 }
 
 impl Default for BridgeState {
     fn default() -> Self {
-        Self { nodes: HashMap::new() }
+        Self { nodes: HashMap::new(), parents: HashMap::new() }
+    }
+}
+
+impl BridgeState {
+    // Compose the parent chain so moving a parent moves its whole subtree.
+    fn world_transform(&self, id: u64) -> Mat4 {
+        let mut world = self.nodes.get(&id).map(|n| n.transform).unwrap_or(Mat4::IDENTITY);
+        let mut cur = id;
+        // Depth cap guards against a cycle slipping in through the C ABI
+        for _ in 0..64 {
+            let Some(&parent) = self.parents.get(&cur) else { break };
+            let Some(p) = self.nodes.get(&parent) else { break };
+            world = p.transform * world;
+            cur = parent;
+        }
+        world
     }
 }
 
 enum Command {
     Create { c_id: u64, name: String, transform: Mat4 },
+    CreateBatch { nodes: Vec<Node> },
     Update { c_id: u64, transform: Mat4 },
     SetModel { c_id: u64, model_url: String },
     SetTexture { c_id: u64, texture_url: String },
     SetColor { c_id: u64, color: [f32; 4] }, // RGBA
     SetDimensions { c_id: u64, dimensions: [f32; 3] },
     SetEntityType { c_id: u64, entity_type: u8 },
+    SetParent { c_id: u64, parent: u64 }, // parent 0 = root
     Remove { c_id: u64 },
     Shutdown,
 }
 
+// Timing of the most recent compositor frame, recorded in on_frame
+#[derive(Clone, Copy)]
+struct FrameTiming {
+    received: Instant,
+    delta: f32,
+    elapsed: f32,
+    count: u64,
+}
+static FRAME_TIMING: Mutex<Option<FrameTiming>> = Mutex::new(None);
+
+// Backpressure (sdxr_queue_status): commands queued through the C ABI, applied
+// to the shared state by the command task, and applied as of the last
+// compositor frame that picked the state up.
+static CMDS_SUBMITTED: AtomicU64 = AtomicU64::new(0);
+static CMDS_APPLIED: AtomicU64 = AtomicU64::new(0);
+static CMDS_PRESENTED: AtomicU64 = AtomicU64::new(0);
+
 // Connection status for startup
 static CONNECTION_SUCCESS: AtomicBool = AtomicBool::new(false);
 static CONNECTION_FAILED: AtomicBool = AtomicBool::new(false);
@@ -59,13 +97,18 @@ impl ClientState for BridgeState {
     const APP_ID: &'static str = "org.stardustxr.starworld";
     fn initial_state_update(&mut self) {}
     
-    fn on_frame(&mut self, _info: &stardust_xr_fusion::root::FrameInfo) {
+    fn on_frame(&mut self, info: &stardust_xr_fusion::root::FrameInfo) {
+        if let Ok(mut timing) = FRAME_TIMING.lock() {
+            let count = timing.map(|t| t.count + 1).unwrap_or(1);
+            *timing = Some(FrameTiming { received: Instant::now(), delta: info.delta, elapsed: info.elapsed, count });
+        }
         // Sync from the global shared state on each frame
         if let Ok(ctrl) = CTRL.lock() {
             if let Some(shared) = &ctrl.shared_state {
                 if let Ok(shared_state) = shared.lock() {
                     eprintln!("[bridge/on_frame] Syncing {} nodes from shared_state", shared_state.nodes.len());
                     self.nodes = shared_state.nodes.clone();
+                    self.parents = shared_state.parents.clone();
                 } else {
                     eprintln!("[bridge/on_frame] Failed to lock shared_state");
                 }
@@ -141,7 +184,7 @@ impl Reify for BridgeState {
                 return None;
             }
             
-            let (scale, rot, trans) = node.transform.to_scale_rotation_translation();
+            let (scale, rot, trans) = self.world_transform(*id).to_scale_rotation_translation();
             let vis_scale = if dims.length() > 0.001 { dims } else { scale };
             
             let trans_array = [trans.x, trans.y, trans.z];
@@ -289,6 +332,16 @@ struct Node {
                                 println!("[bridge] create node id={} name={} (state nodes={})", c_id, name, state.nodes.len());
                             }
                         }
+                        Command::CreateBatch { nodes } => {
+                            // One lock and one log line for the whole initial-load batch
+                            if let Ok(mut state) = shared_for_commands.lock() {
+                                let count = nodes.len();
+                                for node in nodes {
+                                    state.nodes.insert(node.id, node);
+                                }
+                                println!("[bridge] create batch of {} nodes (state nodes={})", count, state.nodes.len());
+                            }
+                        }
                         Command::Update { c_id, transform } => {
                             if let Ok(mut state) = shared_for_commands.lock() {
                                 if let Some(n) = state.nodes.get_mut(&c_id) {
@@ -340,8 +393,34 @@ struct Node {
                                 }
                             }
                         }
+                        Command::SetParent { c_id, parent } => {
+                            if let Ok(mut state) = shared_for_commands.lock() {
+                                if parent == 0 {
+                                    state.parents.remove(&c_id);
+                                } else {
+                                    state.parents.insert(c_id, parent);
+                                }
+                            }
+                        }
                         Command::Remove { c_id } => {
                             if let Ok(mut state) = shared_for_commands.lock() {
+                                // Hand the children to the removed node's parent (or the root),
+                                // folding its transform into theirs so they stay where they were.
+                                let grandparent = state.parents.remove(&c_id);
+                                let local = state.nodes.get(&c_id).map(|n| n.transform).unwrap_or(Mat4::IDENTITY);
+                                let children: Vec<u64> = state.parents.iter()
+                                    .filter(|&(_, &p)| p == c_id)
+                                    .map(|(&child, _)| child)
+                                    .collect();
+                                for child in children {
+                                    match grandparent {
+                                        Some(gp) => { state.parents.insert(child, gp); }
+                                        None => { state.parents.remove(&child); }
+                                    }
+                                    if let Some(n) = state.nodes.get_mut(&child) {
+                                        n.transform = local * n.transform;
+                                    }
+                                }
                                 if state.nodes.remove(&c_id).is_some() {
                                     println!("[bridge] remove node id={} (remaining={})", c_id, state.nodes.len());
                                 }
@@ -349,6 +428,7 @@ struct Node {
                         }
                         Command::Shutdown => { STOP_REQUESTED.store(true, Ordering::SeqCst); break; }
                     }
+                    CMDS_APPLIED.fetch_add(1, Ordering::SeqCst);
                 }
             });
             println!("[bridge] Connecting to Stardust server...");
@@ -430,6 +510,8 @@ struct Node {
                 
                 // Lock shared_state and work with it
                 if let Ok(mut state) = shared_for_event_loop.lock() {
+                    // Everything applied so far is in the state this frame shows
+                    CMDS_PRESENTED.store(CMDS_APPLIED.load(Ordering::SeqCst), Ordering::SeqCst);
                     eprintln!("[bridge/event_loop] Processing {} frames, state has {} nodes", frames.len(), state.nodes.len());
                     for frame in frames {
                         state.on_frame(&frame);
@@ -477,6 +559,16 @@ struct Node {
     0 // Assume success to maintain backwards compatibility if status isn't set
 }
 
+// Queue a command for the command task, counted for sdxr_queue_status.
+fn send_command(ctrl: &Ctrl, cmd: Command) {
+    let Some(tx) = &ctrl.tx else { return };
+    // Counted first so `applied` can never overtake `submitted`
+    CMDS_SUBMITTED.fetch_add(1, Ordering::SeqCst);
+    if tx.send(cmd).is_err() {
+        CMDS_SUBMITTED.fetch_sub(1, Ordering::SeqCst);
+    }
+}
+
 #[no_mangle]
 pub extern "C" fn sdxr_poll() -> i32 { if !STARTED.load(Ordering::SeqCst) { -1 } else { 0 } }
 
@@ -503,10 +595,55 @@ pub extern "C" fn sdxr_create_node(name: *const std::os::raw::c_char, mat4: *con
 
     let mut ctrl = CTRL.lock().unwrap();
     let c_id = ctrl.next_id; ctrl.next_id += 1;
-    if let Some(tx) = &ctrl.tx { let _ = tx.send(Command::Create { c_id, name, transform: mat }); }
+    send_command(&ctrl, Command::Create { c_id, name, transform: mat });
     c_id
 }
 
+/// Node description for `sdxr_create_nodes`; layout matches `SdxrNodeDesc` in StardustBridge.hpp.
+#[repr(C)]
+pub struct SdxrNodeDesc {
+    pub name: *const std::os::raw::c_char,
+    pub transform: [f32; 16],
+    pub color: [f32; 4],
+    pub dimensions: [f32; 3],
+    pub entity_type: u8,
+}
+
+/// Create `count` nodes with their visual properties in a single command.
+/// Writes the assigned ids to `out_ids`. Returns 0 on success.
+#[no_mangle]
+pub extern "C" fn sdxr_create_nodes(descs: *const SdxrNodeDesc, count: usize, out_ids: *mut u64) -> i32 {
+    if !STARTED.load(Ordering::SeqCst) { return -1; }
+    if count == 0 { return 0; }
+    if descs.is_null() || out_ids.is_null() { return -1; }
+    let descs = unsafe { std::slice::from_raw_parts(descs, count) };
+    let out_ids = unsafe { std::slice::from_raw_parts_mut(out_ids, count) };
+
+    let mut ctrl = CTRL.lock().unwrap();
+    let mut nodes = Vec::with_capacity(count);
+    for (desc, out_id) in descs.iter().zip(out_ids.iter_mut()) {
+        let c_id = ctrl.next_id; ctrl.next_id += 1;
+        *out_id = c_id;
+        let name = if desc.name.is_null() {
+            String::new()
+        } else {
+            unsafe { CStr::from_ptr(desc.name) }.to_string_lossy().to_string()
+        };
+        nodes.push(Node {
+            id: c_id,
+            name,
+            transform: Mat4::from_cols_array(&desc.transform),
+            entity_type: desc.entity_type,
+            model_url: String::new(),
+            texture_url: String::new(),
+            color: desc.color,
+            dimensions: desc.dimensions,
+        });
+    }
+    send_command(&ctrl, Command::CreateBatch { nodes });
+    0
+}
+
 #[no_mangle]
 pub extern "C" fn sdxr_update_node(id: u64, mat4: *const f32) -> i32 {
     if !STARTED.load(Ordering::SeqCst) { return -1; }
@@ -515,7 +652,7 @@ pub extern "C" fn sdxr_update_node(id: u64, mat4: *const f32) -> i32 {
     arr.copy_from_slice(m);
     let mat = Mat4::from_cols_array(&arr);
     let ctrl = CTRL.lock().unwrap();
-    if let Some(tx) = &ctrl.tx { let _ = tx.send(Command::Update { c_id: id, transform: mat }); }
+    send_command(&ctrl, Command::Update { c_id: id, transform: mat });
     0
 }
 
@@ -523,7 +660,7 @@ pub extern "C" fn sdxr_update_node(id: u64, mat4: *const f32) -> i32 {
 pub extern "C" fn sdxr_remove_node(id: u64) -> i32 {
     if !STARTED.load(Ordering::SeqCst) { return -1; }
     let ctrl = CTRL.lock().unwrap();
-    if let Some(tx) = &ctrl.tx { let _ = tx.send(Command::Remove { c_id: id }); }
+    send_command(&ctrl, Command::Remove { c_id: id });
     0
 }
 
@@ -540,9 +677,7 @@ pub extern "C" fn sdxr_set_node_model(id: u64, model_url: *const std::os::raw::c
     if !STARTED.load(Ordering::SeqCst) { return -1; }
     let url = unsafe { CStr::from_ptr(model_url) }.to_string_lossy().to_string();
     let ctrl = CTRL.lock().unwrap();
-    if let Some(tx) = &ctrl.tx {
-        let _ = tx.send(Command::SetModel { c_id: id, model_url: url });
-    }
+    send_command(&ctrl, Command::SetModel { c_id: id, model_url: url });
     0
 }
 
@@ -551,9 +686,7 @@ pub extern "C" fn sdxr_set_node_texture(id: u64, texture_url: *const std::os::ra
     if !STARTED.load(Ordering::SeqCst) { return -1; }
     let url = unsafe { CStr::from_ptr(texture_url) }.to_string_lossy().to_string();
     let ctrl = CTRL.lock().unwrap();
-    if let Some(tx) = &ctrl.tx {
-        let _ = tx.send(Command::SetTexture { c_id: id, texture_url: url });
-    }
+    send_command(&ctrl, Command::SetTexture { c_id: id, texture_url: url });
     0
 }
 
@@ -561,9 +694,7 @@ pub extern "C" fn sdxr_set_node_texture(id: u64, texture_url: *const std::os::ra
 pub extern "C" fn sdxr_set_node_color(id: u64, r: f32, g: f32, b: f32, a: f32) -> i32 {
     if !STARTED.load(Ordering::SeqCst) { return -1; }
     let ctrl = CTRL.lock().unwrap();
-    if let Some(tx) = &ctrl.tx {
-        let _ = tx.send(Command::SetColor { c_id: id, color: [r, g, b, a] });
-    }
+    send_command(&ctrl, Command::SetColor { c_id: id, color: [r, g, b, a] });
     0
 }
 
@@ -571,9 +702,7 @@ pub extern "C" fn sdxr_set_node_color(id: u64, r: f32, g: f32, b: f32, a: f32) -
 pub extern "C" fn sdxr_set_node_dimensions(id: u64, x: f32, y: f32, z: f32) -> i32 {
     if !STARTED.load(Ordering::SeqCst) { return -1; }
     let ctrl = CTRL.lock().unwrap();
-    if let Some(tx) = &ctrl.tx {
-        let _ = tx.send(Command::SetDimensions { c_id: id, dimensions: [x, y, z] });
-    }
+    send_command(&ctrl, Command::SetDimensions { c_id: id, dimensions: [x, y, z] });
     0
 }
 
@@ -581,8 +710,70 @@ pub extern "C" fn sdxr_set_node_dimensions(id: u64, x: f32, y: f32, z: f32) -> i
 pub extern "C" fn sdxr_set_node_entity_type(id: u64, entity_type: u8) -> i32 {
     if !STARTED.load(Ordering::SeqCst) { return -1; }
     let ctrl = CTRL.lock().unwrap();
-    if let Some(tx) = &ctrl.tx {
-        let _ = tx.send(Command::SetEntityType { c_id: id, entity_type });
+    send_command(&ctrl, Command::SetEntityType { c_id: id, entity_type });
+    0
+}
+
+// Parent `id` under `parent` (0 = root). The node's transform becomes relative
+// to the parent, so moving the parent moves the whole subtree.
+#[no_mangle]
+pub extern "C" fn sdxr_set_node_parent(id: u64, parent: u64) -> i32 {
+    if !STARTED.load(Ordering::SeqCst) { return -1; }
+    let ctrl = CTRL.lock().unwrap();
+    send_command(&ctrl, Command::SetParent { c_id: id, parent });
+    0
+}
+
+// Must match StardustBridge::SdxrFrameTiming on the C++ side.
+#[repr(C)]
+pub struct SdxrFrameTiming {
+    pub frame_count: u64,
+    pub since_frame_ns: u64,   // time since the last frame event, measured now
+    pub predicted_next_ns: u64, // time until the next frame is expected (0 if overdue)
+    pub delta: f32,            // compositor frame delta in seconds
+    pub elapsed: f32,          // compositor time since start in seconds
+}
+
+// Latest compositor frame timing. Times are relative to the moment of the
+// call so the caller needn't share a clock with the bridge. Returns -1 before
+// the first frame.
+#[no_mangle]
+pub extern "C" fn sdxr_frame_timing(out: *mut SdxrFrameTiming) -> i32 {
+    if out.is_null() { return -1; }
+    let Some(t) = FRAME_TIMING.lock().ok().and_then(|t| *t) else { return -1 };
+    let since = t.received.elapsed();
+    let period = std::time::Duration::from_secs_f32(t.delta.max(0.0));
+    let until_next = period.saturating_sub(since);
+    unsafe {
+        *out = SdxrFrameTiming {
+            frame_count: t.count,
+            since_frame_ns: since.as_nanos() as u64,
+            predicted_next_ns: until_next.as_nanos() as u64,
+            delta: t.delta,
+            elapsed: t.elapsed,
+        };
     }
     0
 }
+
+// Must match StardustBridge::SdxrQueueStatus on the C++ side.
+#[repr(C)]
+pub struct SdxrQueueStatus {
+    pub submitted: u64,  // commands queued through this ABI
+    pub applied: u64,    // of those, applied to the scene state
+    pub presented: u64,  // `applied` as of the last compositor frame
+}
+
+// Command queue depth (submitted - applied) and how far the compositor's
+// frames trail the applied state (applied - presented). Counters are
+// cumulative since the library was loaded.
+#[no_mangle]
+pub extern "C" fn sdxr_queue_status(out: *mut SdxrQueueStatus) -> i32 {
+    if out.is_null() { return -1; }
+    // Read back to front so a concurrent update can't make the view inconsistent
+    let presented = CMDS_PRESENTED.load(Ordering::SeqCst);
+    let applied = CMDS_APPLIED.load(Ordering::SeqCst);
+    let submitted = CMDS_SUBMITTED.load(Ordering::SeqCst);
+    unsafe { *out = SdxrQueueStatus { submitted, applied, presented }; }
+    0
+}
@@ -0,0 +1,548 @@
+// AssetClient.cpp
+#include "AssetClient.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+
+using Overte::NLPacket;
+using Overte::PacketType;
+
+namespace {
+
+constexpr std::uint8_t kMappingGet = 0;  // AssetMappingOperationType::Get
+
+// Asset payloads are Qt writePrimitive() values: little-endian
+template <typename T>
+void putLE(std::vector<std::uint8_t>& out, T value) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (8 * i)));
+    }
+}
+
+template <typename T>
+T getLE(const std::uint8_t* p) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) value |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    return static_cast<T>(value);
+}
+
+bool isHex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+struct DigestFree {
+    void operator()(EVP_MD_CTX* ctx) const { EVP_MD_CTX_free(ctx); }
+};
+
+const char* errorName(AssetClient::ServerError error) {
+    switch (error) {
+        case AssetClient::ServerError::NoError: return "no error";
+        case AssetClient::ServerError::AssetNotFound: return "asset not found";
+        case AssetClient::ServerError::InvalidByteRange: return "invalid byte range";
+        case AssetClient::ServerError::AssetTooLarge: return "asset too large";
+        case AssetClient::ServerError::PermissionDenied: return "permission denied";
+        case AssetClient::ServerError::MappingOperationFailed: return "mapping operation failed";
+        case AssetClient::ServerError::FileOperationFailed: return "file operation failed";
+        case AssetClient::ServerError::NoAssetServer: return "no asset server";
+        case AssetClient::ServerError::LostConnection: return "lost connection";
+    }
+    return "unknown error";
+}
+
+} // namespace
+
+struct AssetClient::Asset {
+    std::string url;    // URL that started the download
+    std::string path;   // Mapping path; empty for atp://<hash>
+    std::string ext;
+    Hash hash{};
+    Stage stage{Stage::Mapping};
+    std::int64_t size{0};
+    std::int64_t nextOffset{0};  // Start of the next range to request
+    std::int64_t received{0};
+    unsigned inFlight{0};        // Byte ranges requested, not complete
+    int fd{-1};
+    // SHA-256 of the file so far. Bytes are hashed as they are written when
+    // they continue the hashed prefix; ranges finished ahead of it wait in
+    // `unhashed` (start -> end) and are read back once the gap closes.
+    std::unique_ptr<EVP_MD_CTX, DigestFree> digest;
+    std::int64_t hashedTo{0};
+    std::map<std::int64_t, std::int64_t> unhashed;
+    std::filesystem::path partPath;
+    std::filesystem::path finalPath;
+    Clock::time_point started{};
+    std::vector<std::pair<std::string, Completion>> waiters;
+};
+
+AssetClient::AssetClient(Config config, Send send) : m_config(std::move(config)), m_send(std::move(send)) {
+    m_config.chunkSize = std::max<std::int64_t>(m_config.chunkSize, 1);
+    m_config.window = std::max(m_config.window, 1u);
+    m_config.maxInFlight = std::max(m_config.maxInFlight, 1u);
+    std::error_code ec;
+    std::filesystem::create_directories(m_config.storeDir, ec);
+}
+
+AssetClient::~AssetClient() {
+    for (auto& asset : m_assets) {
+        if (asset->fd != -1) ::close(asset->fd);
+        std::error_code ec;
+        std::filesystem::remove(asset->partPath, ec);
+    }
+}
+
+bool AssetClient::parseUrl(const std::string& url, std::string& path, Hash& hash, bool& direct, std::string& ext) {
+    if (url.rfind("atp:", 0) != 0) return false;
+    std::string rest = url.substr(4);
+    rest = rest.substr(0, rest.find_first_of("?#"));
+    if (rest.rfind("//", 0) == 0) rest.erase(0, 2);
+
+    direct = rest.size() >= 64 && std::all_of(rest.begin(), rest.begin() + 64, isHex) &&
+             (rest.size() == 64 || rest[64] == '.');
+    if (direct) {
+        fromHex(rest.substr(0, 64), hash);
+        ext = rest.substr(64);
+        path.clear();
+        return true;
+    }
+    while (!rest.empty() && rest.front() == '/') rest.erase(0, 1);
+    if (rest.empty()) return false;
+    path = "/" + rest;
+    const auto slash = path.rfind('/');
+    const auto dot = path.rfind('.');
+    ext = dot != std::string::npos && dot > slash ? path.substr(dot) : std::string();
+    return true;
+}
+
+std::string AssetClient::toHex(const Hash& hash) {
+    static const char* digits = "0123456789abcdef";
+    std::string hex(hash.size() * 2, '0');
+    for (std::size_t i = 0; i < hash.size(); ++i) {
+        hex[2 * i] = digits[hash[i] >> 4];
+        hex[2 * i + 1] = digits[hash[i] & 0xF];
+    }
+    return hex;
+}
+
+bool AssetClient::fromHex(const std::string& hex, Hash& hash) {
+    if (hex.size() != hash.size() * 2 || !std::all_of(hex.begin(), hex.end(), isHex)) return false;
+    auto nibble = [](char c) -> std::uint8_t {
+        if (c <= '9') return static_cast<std::uint8_t>(c - '0');
+        return static_cast<std::uint8_t>((c | 0x20) - 'a' + 10);
+    };
+    for (std::size_t i = 0; i < hash.size(); ++i) {
+        hash[i] = static_cast<std::uint8_t>(nibble(hex[2 * i]) << 4 | nibble(hex[2 * i + 1]));
+    }
+    return true;
+}
+
+void AssetClient::request(const std::string& url, Completion done) {
+    std::string path, ext;
+    Hash hash{};
+    bool direct = false;
+    if (!parseUrl(url, path, hash, direct, ext)) {
+        std::cerr << "[AssetClient] Not an atp: URL: " << url << std::endl;
+        if (done) done(url, false, "");
+        return;
+    }
+
+    if (direct) {
+        const auto stored = m_config.storeDir / (toHex(hash) + ext);
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(stored, ec)) {
+            if (done) done(url, true, stored.string());
+            return;
+        }
+    }
+
+    // Join a download of the same URL or content
+    for (auto& asset : m_assets) {
+        const bool sameContent = direct && asset->stage != Stage::Mapping && asset->hash == hash && asset->ext == ext;
+        if (asset->url == url || sameContent) {
+            asset->waiters.emplace_back(url, std::move(done));
+            return;
+        }
+    }
+
+    auto asset = std::make_unique<Asset>();
+    asset->url = url;
+    asset->path = path;
+    asset->ext = ext;
+    asset->hash = hash;
+    asset->started = Clock::now();
+    asset->waiters.emplace_back(url, std::move(done));
+    Asset& a = *asset;
+    m_assets.push_back(std::move(asset));
+    if (direct) {
+        a.stage = Stage::Info;
+        issue(a, PacketType::AssetGetInfo);
+    } else {
+        issue(a, PacketType::AssetMappingOperation);
+    }
+}
+
+void AssetClient::issue(Asset& asset, PacketType type, std::int64_t start, std::int64_t end) {
+    const std::uint32_t id = m_nextId++;
+    if (m_nextId == 0) m_nextId = 1;
+    Request& request = m_requests[id];
+    request.asset = &asset;
+    request.type = type;
+    request.start = start;
+    request.end = end;
+    send(id, request);
+}
+
+void AssetClient::send(std::uint32_t id, Request& request) {
+    std::vector<std::uint8_t> payload;
+    putLE<std::uint32_t>(payload, id);
+    const Asset& asset = *request.asset;
+    switch (request.type) {
+        case PacketType::AssetMappingOperation:
+            payload.push_back(kMappingGet);
+            putLE<std::uint32_t>(payload, static_cast<std::uint32_t>(asset.path.size()));
+            payload.insert(payload.end(), asset.path.begin(), asset.path.end());
+            break;
+        case PacketType::AssetGetInfo:
+            payload.insert(payload.end(), asset.hash.begin(), asset.hash.end());
+            break;
+        case PacketType::AssetGet:
+            payload.insert(payload.end(), asset.hash.begin(), asset.hash.end());
+            putLE<std::int64_t>(payload, request.start);
+            putLE<std::int64_t>(payload, request.end);
+            break;
+        default:
+            return;
+    }
+    request.sent = Clock::now();
+    ++request.attempts;
+    m_send(request.type, payload);
+}
+
+void AssetClient::pump() {
+    for (auto& owned : m_assets) {
+        Asset& asset = *owned;
+        if (asset.stage != Stage::Data) continue;
+        while (asset.inFlight < m_config.window && m_requests.size() < m_config.maxInFlight &&
+               asset.nextOffset < asset.size) {
+            const std::int64_t start = asset.nextOffset;
+            const std::int64_t end = std::min(asset.size, start + m_config.chunkSize);
+            asset.nextOffset = end;
+            ++asset.inFlight;
+            issue(asset, PacketType::AssetGet, start, end);
+        }
+    }
+}
+
+void AssetClient::handlePacket(const std::uint8_t* data, std::size_t len) {
+    NLPacket::Header header;
+    if (!NLPacket::parseHeader(data, len, header)) return;
+    // Asset server packets are sourced and verified
+    const std::size_t offset = header.size + sizeof(Overte::LocalID) + NLPacket::VERIFICATION_HASH_SIZE;
+    if (len < offset) return;
+    const std::uint8_t* p = data + offset;
+    const std::size_t n = len - offset;
+    switch (header.type) {
+        case PacketType::AssetMappingOperationReply: handleMappingReply(p, n); break;
+        case PacketType::AssetGetInfoReply: handleInfoReply(p, n); break;
+        case PacketType::AssetGetReply: handleGetPart(header, p, n); break;
+        default: break;
+    }
+}
+
+void AssetClient::handleMappingReply(const std::uint8_t* p, std::size_t n) {
+    if (n < 5) return;
+    const auto id = getLE<std::uint32_t>(p);
+    auto it = m_requests.find(id);
+    if (it == m_requests.end() || it->second.type != PacketType::AssetMappingOperation) return;
+    Asset& asset = *it->second.asset;
+    m_requests.erase(it);
+
+    const auto error = static_cast<ServerError>(p[4]);
+    if (error != ServerError::NoError || n < 5 + asset.hash.size()) {
+        fail(asset, std::string("mapping lookup failed: ") + errorName(error));
+        return;
+    }
+    // Hash of the mapped (or, if the server redirects, baked) content
+    std::memcpy(asset.hash.data(), p + 5, asset.hash.size());
+    asset.finalPath = m_config.storeDir / (toHex(asset.hash) + asset.ext);
+
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(asset.finalPath, ec)) {
+        finish(asset);
+        return;
+    }
+    // Another path to the same content is already downloading
+    for (auto& other : m_assets) {
+        if (other.get() == &asset || other->stage == Stage::Mapping) continue;
+        if (other->hash == asset.hash && other->ext == asset.ext) {
+            for (auto& waiter : asset.waiters) other->waiters.push_back(std::move(waiter));
+            release(asset);
+            return;
+        }
+    }
+    asset.stage = Stage::Info;
+    issue(asset, PacketType::AssetGetInfo);
+}
+
+void AssetClient::handleInfoReply(const std::uint8_t* p, std::size_t n) {
+    if (n < 4 + 32 + 1) return;
+    const auto id = getLE<std::uint32_t>(p);
+    auto it = m_requests.find(id);
+    if (it == m_requests.end() || it->second.type != PacketType::AssetGetInfo) return;
+    Asset& asset = *it->second.asset;
+    m_requests.erase(it);
+
+    const auto error = static_cast<ServerError>(p[36]);
+    if (error != ServerError::NoError || n < 37 + sizeof(std::int64_t)) {
+        fail(asset, std::string("asset info failed: ") + errorName(error));
+        return;
+    }
+    asset.size = getLE<std::int64_t>(p + 37);
+    if (asset.size < 0) {
+        fail(asset, "asset info reported a negative size");
+        return;
+    }
+
+    // Chunks are written in place, so the whole file exists from the start
+    asset.finalPath = m_config.storeDir / (toHex(asset.hash) + asset.ext);
+    asset.partPath = asset.finalPath;
+    asset.partPath += ".part";
+    // Read as well as written: out-of-order ranges are hashed from the file
+    asset.fd = ::open(asset.partPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (asset.fd == -1 || ::ftruncate(asset.fd, asset.size) != 0) {
+        fail(asset, std::string("cannot create ") + asset.partPath.string() + ": " + std::strerror(errno));
+        return;
+    }
+    asset.digest.reset(EVP_MD_CTX_new());
+    if (!asset.digest || EVP_DigestInit_ex(asset.digest.get(), EVP_sha256(), nullptr) != 1) {
+        fail(asset, "cannot start SHA-256");
+        return;
+    }
+    asset.stage = Stage::Data;
+    if (asset.size == 0) {
+        finish(asset);
+        return;
+    }
+    pump();
+}
+
+void AssetClient::handleGetPart(const NLPacket::Header& header, const std::uint8_t* p, std::size_t n) {
+    if (!header.isMessage) {
+        // The whole reply fits one packet
+        Stream single;
+        consumePart(single, p, n);
+        pump();
+        return;
+    }
+    Stream& stream = m_streams[header.messageNumber];
+    stream.touched = Clock::now();
+    if (header.messagePart < stream.nextPart) return;  // Duplicate
+    if (header.messagePart != stream.nextPart) {
+        stream.early.emplace(header.messagePart, std::vector<std::uint8_t>(p, p + n));
+        return;
+    }
+    bool open = consumePart(stream, p, n);
+    while (open) {
+        auto next = stream.early.find(stream.nextPart);
+        if (next == stream.early.end()) break;
+        const std::vector<std::uint8_t> part = std::move(next->second);
+        stream.early.erase(next);
+        open = consumePart(stream, part.data(), part.size());
+    }
+    if (!open) m_streams.erase(header.messageNumber);
+    pump();
+}
+
+bool AssetClient::consumePart(Stream& stream, const std::uint8_t* p, std::size_t n) {
+    ++stream.nextPart;
+    if (stream.requestId == 0) {
+        // First part: hash, message ID, error, size, then data
+        constexpr std::size_t kHead = 32 + 4 + 1;
+        if (n < kHead) return false;
+        stream.requestId = getLE<std::uint32_t>(p + 32);
+        const auto error = static_cast<ServerError>(p[36]);
+        auto it = m_requests.find(stream.requestId);
+        const bool known = it != m_requests.end() && it->second.type == PacketType::AssetGet;
+        if (error != ServerError::NoError) {
+            if (known) fail(*it->second.asset, std::string("asset download failed: ") + errorName(error));
+            return false;
+        }
+        if (n < kHead + sizeof(std::int64_t)) return false;
+        stream.remaining = getLE<std::int64_t>(p + kHead);
+        if (known) {
+            const Request& request = it->second;
+            if (stream.remaining != request.end - request.start) {
+                fail(*request.asset, "asset server returned a different range than requested");
+                return false;
+            }
+            stream.offset = request.start;
+        }
+        p += kHead + sizeof(std::int64_t);
+        n -= kHead + sizeof(std::int64_t);
+    }
+
+    const std::size_t take = static_cast<std::size_t>(std::min<std::int64_t>(stream.remaining, static_cast<std::int64_t>(n)));
+    // A retried or failed request's late reply is read to its end, not written
+    auto it = m_requests.find(stream.requestId);
+    if (take > 0 && it != m_requests.end()) {
+        Asset& asset = *it->second.asset;
+        std::size_t written = 0;
+        while (written < take) {
+            const ssize_t w = ::pwrite(asset.fd, p + written, take - written, stream.offset + static_cast<std::int64_t>(written));
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) {
+                fail(asset, std::string("write failed: ") + std::strerror(errno));
+                return false;
+            }
+            written += static_cast<std::size_t>(w);
+        }
+        hashWritten(asset, stream.offset, p, take);
+    }
+    stream.offset += static_cast<std::int64_t>(take);
+    stream.remaining -= static_cast<std::int64_t>(take);
+    if (stream.remaining > 0) return true;
+    rangeDone(stream.requestId);
+    return false;
+}
+
+void AssetClient::rangeDone(std::uint32_t requestId) {
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end()) return;
+    Asset& asset = *it->second.asset;
+    asset.received += it->second.end - it->second.start;
+    --asset.inFlight;
+    if (it->second.end > asset.hashedTo) asset.unhashed[it->second.start] = it->second.end;
+    m_requests.erase(it);
+    if (!catchUpHash(asset)) return;
+    if (asset.received == asset.size) finish(asset);
+}
+
+void AssetClient::hashWritten(Asset& asset, std::int64_t offset, const std::uint8_t* p, std::size_t n) {
+    // Only bytes that extend the hashed prefix; a retried range rewrites
+    // bytes that are already in the digest
+    const std::int64_t end = offset + static_cast<std::int64_t>(n);
+    if (offset > asset.hashedTo || end <= asset.hashedTo) return;
+    const std::size_t skip = static_cast<std::size_t>(asset.hashedTo - offset);
+    EVP_DigestUpdate(asset.digest.get(), p + skip, n - skip);
+    asset.hashedTo = end;
+}
+
+bool AssetClient::catchUpHash(Asset& asset) {
+    std::vector<std::uint8_t> buf;
+    while (!asset.unhashed.empty()) {
+        auto first = asset.unhashed.begin();
+        if (first->first > asset.hashedTo) break;
+        const std::int64_t end = first->second;
+        asset.unhashed.erase(first);
+        if (end <= asset.hashedTo) continue;
+        buf.resize(static_cast<std::size_t>(end - asset.hashedTo));
+        std::size_t read = 0;
+        while (read < buf.size()) {
+            const ssize_t r = ::pread(asset.fd, buf.data() + read, buf.size() - read, asset.hashedTo + static_cast<std::int64_t>(read));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) {
+                fail(asset, std::string("read failed: ") + std::strerror(errno));
+                return false;
+            }
+            read += static_cast<std::size_t>(r);
+        }
+        hashWritten(asset, asset.hashedTo, buf.data(), buf.size());
+    }
+    return true;
+}
+
+void AssetClient::poll(Clock::time_point now) {
+    std::vector<std::uint32_t> expired;
+    for (const auto& [id, request] : m_requests) {
+        if (now - request.sent >= m_config.timeout) expired.push_back(id);
+    }
+    for (std::uint32_t id : expired) {
+        auto it = m_requests.find(id);
+        if (it == m_requests.end()) continue;  // Asset failed meanwhile
+        Request request = it->second;
+        m_requests.erase(it);
+        if (request.attempts > m_config.retries) {
+            fail(*request.asset, "asset server did not answer");
+            continue;
+        }
+        // Resent under a new ID; a late reply to the old one is ignored
+        const std::uint32_t newId = m_nextId++;
+        if (m_nextId == 0) m_nextId = 1;
+        send(newId, m_requests[newId] = request);
+    }
+
+    // Streams whose first part never came
+    for (auto it = m_streams.begin(); it != m_streams.end();) {
+        if (now - it->second.touched >= m_config.timeout) {
+            it = m_streams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    pump();
+}
+
+void AssetClient::finish(Asset& asset) {
+    if (asset.fd != -1) {
+        ::close(asset.fd);
+        asset.fd = -1;
+        // Every range has been hashed by now (see rangeDone)
+        Hash actual{};
+        unsigned int len = 0;
+        const bool hashed = asset.hashedTo == asset.size &&
+            EVP_DigestFinal_ex(asset.digest.get(), actual.data(), &len) == 1 && len == actual.size();
+        if (!hashed || actual != asset.hash) {
+            fail(asset, "content does not match its hash");
+            return;
+        }
+        std::error_code ec;
+        std::filesystem::rename(asset.partPath, asset.finalPath, ec);
+        if (ec) {
+            fail(asset, "cannot store " + asset.finalPath.string() + ": " + ec.message());
+            return;
+        }
+        const auto ms = std::chrono::duration<float, std::milli>(Clock::now() - asset.started).count();
+        std::cout << "[AssetClient] " << asset.url << ": " << asset.size << " bytes in " << ms << " ms" << std::endl;
+    }
+    auto waiters = std::move(asset.waiters);
+    const std::string path = asset.finalPath.string();
+    release(asset);
+    for (auto& [url, done] : waiters) {
+        if (done) done(url, true, path);
+    }
+}
+
+void AssetClient::fail(Asset& asset, const std::string& why) {
+    std::cerr << "[AssetClient] " << asset.url << ": " << why << std::endl;
+    if (asset.fd != -1) {
+        ::close(asset.fd);
+        asset.fd = -1;
+    }
+    std::error_code ec;
+    if (!asset.partPath.empty()) std::filesystem::remove(asset.partPath, ec);
+    auto waiters = std::move(asset.waiters);
+    release(asset);
+    for (auto& [url, done] : waiters) {
+        if (done) done(url, false, "");
+    }
+}
+
+void AssetClient::release(Asset& asset) {
+    for (auto it = m_requests.begin(); it != m_requests.end();) {
+        if (it->second.asset == &asset) {
+            it = m_requests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (asset.fd != -1) ::close(asset.fd);
+    m_assets.erase(std::remove_if(m_assets.begin(), m_assets.end(),
+                                  [&](const std::unique_ptr<Asset>& a) { return a.get() == &asset; }),
+                   m_assets.end());
+}
@@ -0,0 +1,146 @@
+// AssetClient.hpp
+// Downloads atp:// assets from a domain's asset server.
+//
+// atp:/path/to/model.fbx is first resolved to a SHA-256 content hash with an
+// AssetMappingOperation (Get); atp://<hash>.<ext> names the hash directly.
+// AssetGetInfo then gives the size, and the content is fetched as fixed-size
+// byte ranges (AssetGet): up to Config::window ranges in flight per asset and
+// Config::maxInFlight overall, so several assets download at once and each
+// keeps the link busy instead of waiting out one round trip per chunk.
+//
+// Reply packets are written straight into <storeDir>/<hash><ext>.part at
+// their offset (parts of a reply that arrive early are held until the gap
+// before them is filled). The content is hashed as it arrives, in file order,
+// so the finished file is checked against its hash without reading it again
+// and renamed, so the store is content addressed: every URL that maps to the
+// same content shares one file, and a later request finds it without any
+// transfer.
+//
+// The client is transport agnostic. Requests leave through the Send callback
+// as payloads; the owner adds the NLPacket header (source ID, verification
+// hash) and sends them to the asset server. Reply datagrams come back in
+// whole through handlePacket(). Everything runs on the caller's thread.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "NLPacketCodec.hpp"
+
+class AssetClient {
+public:
+	using Clock = std::chrono::steady_clock;
+	using Hash = std::array<std::uint8_t, 32>;  // SHA-256
+
+	// `payload` goes out as one packet of `type` to the asset server.
+	using Send = std::function<void(Overte::PacketType type, const std::vector<std::uint8_t>& payload)>;
+	// `localPath` is the verified file in the store (empty on failure).
+	using Completion = std::function<void(const std::string& url, bool success, const std::string& localPath)>;
+
+	struct Config {
+		std::filesystem::path storeDir;
+		std::int64_t chunkSize{256 * 1024};  // Bytes per AssetGet
+		unsigned window{4};                  // Ranges in flight per asset
+		unsigned maxInFlight{16};            // Requests in flight overall
+		Clock::duration timeout{std::chrono::seconds(5)};
+		unsigned retries{3};                 // Per request, before the asset fails
+	};
+
+	// Server error codes (AssetUtils::AssetServerError)
+	enum class ServerError : std::uint8_t {
+		NoError,
+		AssetNotFound,
+		InvalidByteRange,
+		AssetTooLarge,
+		PermissionDenied,
+		MappingOperationFailed,
+		FileOperationFailed,
+		NoAssetServer,
+		LostConnection
+	};
+
+	AssetClient(Config config, Send send);
+	~AssetClient();
+
+	AssetClient(const AssetClient&) = delete;
+	AssetClient& operator=(const AssetClient&) = delete;
+
+	// Start fetching an atp: URL. `done` runs from request() itself when the
+	// content is already in the store, else from handlePacket() or poll().
+	void request(const std::string& url, Completion done);
+
+	// An AssetMappingOperationReply, AssetGetInfoReply or AssetGetReply
+	// datagram, header included.
+	void handlePacket(const std::uint8_t* data, std::size_t len);
+
+	// Retry timed-out requests and issue new ranges. Call every frame.
+	void poll(Clock::time_point now);
+
+	std::size_t activeAssets() const { return m_assets.size(); }
+	std::size_t inFlight() const { return m_requests.size(); }
+
+	// Parse "atp:/path" or "atp://<64 hex>.<ext>"; false if not an atp: URL.
+	// `hash` is set only for the direct form.
+	static bool parseUrl(const std::string& url, std::string& path, Hash& hash, bool& direct, std::string& ext);
+	static std::string toHex(const Hash& hash);
+	static bool fromHex(const std::string& hex, Hash& hash);
+
+private:
+	struct Asset;
+	enum class Stage : std::uint8_t { Mapping, Info, Data };
+
+	// One request on the wire (mapping, info or a byte range)
+	struct Request {
+		Asset* asset{nullptr};
+		Overte::PacketType type{Overte::PacketType::Unknown};
+		std::int64_t start{0};
+		std::int64_t end{0};
+		Clock::time_point sent{};
+		unsigned attempts{0};
+	};
+
+	// An AssetGetReply spread over several packets of one message
+	struct Stream {
+		std::uint32_t requestId{0};   // 0 until the first part was read
+		std::int64_t offset{0};       // File offset of the next data byte
+		std::int64_t remaining{0};    // Data bytes still to come
+		std::uint32_t nextPart{0};
+		Clock::time_point touched{};
+		std::map<std::uint32_t, std::vector<std::uint8_t>> early;  // Parts past a gap
+	};
+
+	void send(std::uint32_t id, Request& request);
+	void issue(Asset& asset, Overte::PacketType type, std::int64_t start = 0, std::int64_t end = 0);
+	void pump();
+	void fail(Asset& asset, const std::string& why);
+	void finish(Asset& asset);
+	void release(Asset& asset);  // Forget the asset and its requests
+
+	void handleMappingReply(const std::uint8_t* p, std::size_t n);
+	void handleInfoReply(const std::uint8_t* p, std::size_t n);
+	void handleGetPart(const Overte::NLPacket::Header& header, const std::uint8_t* p, std::size_t n);
+	// Apply the next part of a reply stream; false once the stream is done.
+	bool consumePart(Stream& stream, const std::uint8_t* p, std::size_t n);
+	void rangeDone(std::uint32_t requestId);
+	// Feed bytes written at `offset` to the asset's digest if they extend
+	// the hashed prefix.
+	void hashWritten(Asset& asset, std::int64_t offset, const std::uint8_t* p, std::size_t n);
+	// Hash finished ranges the prefix has reached; false if the asset failed.
+	bool catchUpHash(Asset& asset);
+
+	Config m_config;
+	Send m_send;
+	std::uint32_t m_nextId{1};
+	std::vector<std::unique_ptr<Asset>> m_assets;
+	std::unordered_map<std::uint32_t, Request> m_requests;  // By message ID
+	std::unordered_map<std::uint32_t, Stream> m_streams;    // By transport message number
+};
@@ -0,0 +1,75 @@
+// ClockSync.cpp
+#include "ClockSync.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Anything longer is a lost reply answered late or a clock step
+constexpr std::int64_t kMaxRttUs = 30'000'000;
+
+} // anonymous namespace
+
+bool PeerClock::addSample(std::int64_t sentUs, std::int64_t receivedUs, std::int64_t peerUs) {
+    const std::int64_t rtt = receivedUs - sentUs;
+    if (rtt < 0 || rtt > kMaxRttUs) return false;
+
+    // RFC 6298 smoothing
+    if (m_samples == 0) {
+        m_srttUs = rtt;
+        m_rttVarUs = rtt / 2;
+    } else {
+        m_rttVarUs = (3 * m_rttVarUs + std::abs(m_srttUs - rtt)) / 4;
+        m_srttUs = (7 * m_srttUs + rtt) / 8;
+    }
+    m_lastRttUs = rtt;
+    m_lastReplyUs = receivedUs;
+    ++m_samples;
+
+    if (peerUs != 0) {
+        // The peer stamped its reply somewhere in the round trip; assume the
+        // middle: offset = peer - (sent + received) / 2
+        m_filter[m_filterNext] = Sample{rtt, peerUs - (sentUs + rtt / 2)};
+        m_filterNext = (m_filterNext + 1) % kFilterSize;
+        m_offsetSamples = std::min(m_offsetSamples + 1, kFilterSize);
+    }
+    return true;
+}
+
+std::chrono::microseconds PeerClock::minRtt() const {
+    if (m_offsetSamples == 0) return std::chrono::microseconds(m_srttUs);
+    std::int64_t best = m_filter[0].rttUs;
+    for (std::size_t i = 1; i < m_offsetSamples; ++i) best = std::min(best, m_filter[i].rttUs);
+    return std::chrono::microseconds(best);
+}
+
+std::chrono::microseconds PeerClock::rto() const {
+    using std::chrono::microseconds;
+    if (m_samples == 0) return microseconds(1'000'000);
+    const std::int64_t rto = m_srttUs + std::max<std::int64_t>(1000, 4 * m_rttVarUs);
+    return microseconds(std::clamp<std::int64_t>(rto, 200'000, 60'000'000));
+}
+
+std::chrono::microseconds PeerClock::offset() const {
+    if (m_offsetSamples == 0) return std::chrono::microseconds(0);
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < m_offsetSamples; ++i) {
+        if (m_filter[i].rttUs < m_filter[best].rttUs) best = i;
+    }
+    return std::chrono::microseconds(m_filter[best].offsetUs);
+}
+
+std::chrono::microseconds PeerClock::offsetError() const {
+    return hasOffset() ? minRtt() / 2 : std::chrono::microseconds(0);
+}
+
+const PeerClock* ClockSync::find(char nodeType) const {
+    auto it = m_peers.find(nodeType);
+    return it != m_peers.end() && it->second.valid() ? &it->second : nullptr;
+}
+
+std::int64_t ClockSync::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
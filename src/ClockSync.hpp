@@ -0,0 +1,86 @@
+// ClockSync.hpp
+// Round-trip time and clock offset per peer, from Ping/PingReply.
+//
+// Each PingReply echoes the local send time of our Ping and carries the
+// peer's own clock when it replied. From those the peer keeps:
+//   - smoothed RTT and RTT variance (RFC 6298), and the retransmit timeout
+//     derived from them
+//   - an NTP-style offset of the peer's clock: over the last few replies the
+//     one with the smallest RTT wins, since it had the least room for
+//     asymmetric queueing; its half-RTT bounds the error
+// All timestamps are microseconds since the Unix epoch (system clock), the
+// same base Overte uses on the wire.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+class PeerClock {
+public:
+	static constexpr std::size_t kFilterSize = 8;  // Replies considered for the offset
+
+	// `sentUs`: our Ping timestamp echoed back; `receivedUs`: when the reply
+	// arrived; `peerUs`: the peer's clock in the reply (0 = not reported).
+	// Returns false (and ignores the sample) for an impossible RTT, e.g.
+	// after a local clock step.
+	bool addSample(std::int64_t sentUs, std::int64_t receivedUs, std::int64_t peerUs = 0);
+
+	bool valid() const { return m_samples > 0; }
+	std::uint32_t samples() const { return m_samples; }
+
+	std::chrono::microseconds srtt() const { return std::chrono::microseconds(m_srttUs); }
+	std::chrono::microseconds rttVar() const { return std::chrono::microseconds(m_rttVarUs); }
+	std::chrono::microseconds lastRtt() const { return std::chrono::microseconds(m_lastRttUs); }
+	// Smallest RTT among the filtered replies
+	std::chrono::microseconds minRtt() const;
+	// srtt + 4 * rttvar, clamped to [200 ms, 60 s]; 1 s before the first sample
+	std::chrono::microseconds rto() const;
+
+	// Peer clock minus ours. Only meaningful if hasOffset().
+	bool hasOffset() const { return m_offsetSamples > 0; }
+	std::chrono::microseconds offset() const;
+	std::chrono::microseconds offsetError() const;  // Half the RTT of the chosen reply
+	std::int64_t toPeerTime(std::int64_t localUs) const { return localUs + offset().count(); }
+	std::int64_t toLocalTime(std::int64_t peerUs) const { return peerUs - offset().count(); }
+
+	// Local time of the last accepted reply (0 if none)
+	std::int64_t lastReplyUs() const { return m_lastReplyUs; }
+
+	void reset() { *this = PeerClock{}; }
+
+private:
+	struct Sample {
+		std::int64_t rttUs;
+		std::int64_t offsetUs;
+	};
+
+	std::int64_t m_srttUs{0};
+	std::int64_t m_rttVarUs{0};
+	std::int64_t m_lastRttUs{0};
+	std::int64_t m_lastReplyUs{0};
+	std::uint32_t m_samples{0};
+
+	// Ring of recent replies that carried a peer timestamp
+	std::array<Sample, kFilterSize> m_filter{};
+	std::size_t m_filterNext{0};
+	std::size_t m_offsetSamples{0};
+};
+
+// PeerClock per Overte node type ('D' domain server, 'W' avatar mixer,
+// 'o' entity server, ...).
+class ClockSync {
+public:
+	PeerClock& peer(char nodeType) { return m_peers[nodeType]; }
+	// nullptr until a reply from that peer was seen
+	const PeerClock* find(char nodeType) const;
+	void clear() { m_peers.clear(); }
+
+	// Microseconds since the Unix epoch, the timestamp base of Ping packets.
+	static std::int64_t nowUs();
+
+private:
+	std::unordered_map<char, PeerClock> m_peers;
+};
@@ -0,0 +1,164 @@
+// EntityHierarchy.cpp
+#include "EntityHierarchy.hpp"
+
+#include <algorithm>
+
+namespace {
+
+void removeValue(std::vector<std::uint32_t>& v, std::uint32_t value) {
+    auto it = std::find(v.begin(), v.end(), value);
+    if (it == v.end()) return;
+    *it = v.back();
+    v.pop_back();
+}
+
+} // anonymous namespace
+
+void EntityHierarchy::ensureSlot(std::uint32_t slot) {
+    if (slot >= m_children.size()) {
+        m_children.resize(slot + 1);
+        m_dirty.resize(slot + 1, 0);
+    }
+}
+
+void EntityHierarchy::link(EntityStore& store, std::uint32_t slot, std::uint32_t parentSlot) {
+    ensureSlot(parentSlot);
+    store.at(slot).parentSlot = parentSlot;
+    m_children[parentSlot].push_back(slot);
+}
+
+void EntityHierarchy::unlink(EntityStore& store, std::uint32_t slot) {
+    auto& e = store.at(slot);
+    if (e.parentSlot == npos) return;
+    if (e.parentSlot < m_children.size()) removeValue(m_children[e.parentSlot], slot);
+    e.parentSlot = npos;
+}
+
+void EntityHierarchy::stopWaiting(std::uint32_t slot, const EntityUuid& parentId) {
+    auto it = m_waiting.find(parentId);
+    if (it == m_waiting.end()) return;
+    removeValue(it->second, slot);
+    if (it->second.empty()) m_waiting.erase(it);
+}
+
+bool EntityHierarchy::setParent(EntityStore& store, std::uint32_t slot, const EntityUuid& parentId, std::uint16_t joint) {
+    ensureSlot(slot);
+    auto& e = store.at(slot);
+    const std::uint32_t newParent = parentId.isNull() ? npos : store.find(parentId);
+
+    // Reject cycles: the new parent must not be `slot` or below it.
+    for (std::uint32_t p = newParent; p != npos; p = store.at(p).parentSlot) {
+        if (p == slot) return false;
+    }
+
+    if (e.parentSlot == npos && !e.parentId.isNull()) stopWaiting(slot, e.parentId);
+    e.parentId = parentId;
+    e.parentJoint = joint;
+
+    if (newParent != e.parentSlot) {
+        unlink(store, slot);
+        if (newParent != npos) link(store, slot, newParent);
+        markDirty(slot);
+    }
+    if (newParent == npos && !parentId.isNull()) m_waiting[parentId].push_back(slot);
+    return true;
+}
+
+void EntityHierarchy::onAdded(EntityStore& store, std::uint32_t slot, std::vector<std::uint32_t>& adopted) {
+    ensureSlot(slot);
+    const EntityUuid id = store.at(slot).id;
+    auto it = m_waiting.find(id);
+    if (it == m_waiting.end()) return;
+    std::vector<std::uint32_t> waiting = std::move(it->second);
+    m_waiting.erase(it);
+
+    for (auto child : waiting) {
+        if (!store.isLive(child)) continue;
+        auto& c = store.at(child);
+        if (c.parentId != id || c.parentSlot != npos) continue;
+        link(store, child, slot);
+        markDirty(child);
+        adopted.push_back(child);
+    }
+}
+
+void EntityHierarchy::onErased(EntityStore& store, std::uint32_t slot, std::vector<std::uint32_t>& orphaned) {
+    ensureSlot(slot);
+    auto& e = store.at(slot);
+    if (e.parentSlot == npos && !e.parentId.isNull()) stopWaiting(slot, e.parentId);
+    unlink(store, slot);
+
+    auto& kids = m_children[slot];
+    if (!kids.empty()) {
+        auto& waiting = m_waiting[e.id];
+        for (auto child : kids) {
+            store.at(child).parentSlot = npos;
+            waiting.push_back(child);
+            markDirty(child);
+            orphaned.push_back(child);
+        }
+        kids.clear();
+    }
+}
+
+void EntityHierarchy::markDirty(std::uint32_t slot) {
+    ensureSlot(slot);
+    if (m_dirty[slot]) return;
+    m_dirty[slot] = 1;
+    m_dirtyList.push_back(slot);
+}
+
+std::size_t EntityHierarchy::propagate(EntityStore& store) {
+    if (m_dirtyList.empty()) return 0;
+
+    // Subtree roots: dirty entities with no dirty ancestor. Everything below
+    // them is recomputed anyway, so nested dirty entries are skipped.
+    m_level.clear();
+    for (auto slot : m_dirtyList) {
+        if (!store.isLive(slot)) continue;
+        bool covered = false;
+        for (std::uint32_t p = store.at(slot).parentSlot; p != npos; p = store.at(p).parentSlot) {
+            if (m_dirty[p]) {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered) m_level.push_back(slot);
+    }
+    for (auto slot : m_dirtyList) m_dirty[slot] = 0;
+    m_dirtyList.clear();
+
+    // Breadth-first, one level per batch: parents of the current level were
+    // all finished in the previous one.
+    std::size_t count = 0;
+    while (!m_level.empty()) {
+        m_nextLevel.clear();
+        for (auto slot : m_level) {
+            auto& e = store.at(slot);
+            e.worldTransform = e.parentSlot == npos
+                ? e.transform
+                : store.at(e.parentSlot).worldTransform * e.transform;
+            ++count;
+            if (slot < m_children.size()) {
+                const auto& kids = m_children[slot];
+                m_nextLevel.insert(m_nextLevel.end(), kids.begin(), kids.end());
+            }
+        }
+        m_level.swap(m_nextLevel);
+    }
+    return count;
+}
+
+const std::vector<std::uint32_t>& EntityHierarchy::children(std::uint32_t slot) const {
+    static const std::vector<std::uint32_t> kNone;
+    return slot < m_children.size() ? m_children[slot] : kNone;
+}
+
+void EntityHierarchy::clear() {
+    m_children.clear();
+    m_dirty.clear();
+    m_dirtyList.clear();
+    m_waiting.clear();
+    m_level.clear();
+    m_nextLevel.clear();
+}
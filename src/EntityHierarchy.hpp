@@ -0,0 +1,63 @@
+// EntityHierarchy.hpp
+// Parent/child links between entities and incremental world transforms.
+//
+// Each OverteEntity carries its local transform (relative to its parent) and a
+// cached worldTransform. Edits mark the touched entity dirty; propagate()
+// recomputes world transforms only for dirty subtrees, one tree level at a
+// time so every parent is final before its children read it.
+//
+// Children may arrive before their parent. Until the parent UUID shows up the
+// child is treated as a root (parentSlot == npos) and parked in a waiting
+// list keyed by that UUID.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "EntityStore.hpp"
+
+class EntityHierarchy {
+public:
+	static constexpr std::uint32_t npos = EntityStore::npos;
+
+	// Points `slot` at `parentId` (null detaches). Returns false and keeps the
+	// previous link if the new parent is `slot` itself or one of its
+	// descendants. Marks `slot` dirty when the resolved parent changes.
+	bool setParent(EntityStore& store, std::uint32_t slot, const EntityUuid& parentId, std::uint16_t joint);
+
+	// A new entity occupies `slot`: adopt children that were waiting for its
+	// UUID. Adopted slots are appended to `adopted` (their compositor parent
+	// link needs updating).
+	void onAdded(EntityStore& store, std::uint32_t slot, std::vector<std::uint32_t>& adopted);
+
+	// `slot` is about to be erased. Its children become roots again and wait
+	// for the UUID to reappear; they are appended to `orphaned`.
+	void onErased(EntityStore& store, std::uint32_t slot, std::vector<std::uint32_t>& orphaned);
+
+	void markDirty(std::uint32_t slot);
+	bool hasDirty() const { return !m_dirtyList.empty(); }
+
+	// Recompute worldTransform for every dirty entity and its descendants.
+	// Returns the number of entities recomputed.
+	std::size_t propagate(EntityStore& store);
+
+	const std::vector<std::uint32_t>& children(std::uint32_t slot) const;
+	void clear();
+
+private:
+	void link(EntityStore& store, std::uint32_t slot, std::uint32_t parentSlot);
+	void unlink(EntityStore& store, std::uint32_t slot);
+	void stopWaiting(std::uint32_t slot, const EntityUuid& parentId);
+	void ensureSlot(std::uint32_t slot);
+
+	std::vector<std::vector<std::uint32_t>> m_children;  // Indexed by slot
+	std::vector<std::uint8_t> m_dirty;
+	std::vector<std::uint32_t> m_dirtyList;
+	std::unordered_map<EntityUuid, std::vector<std::uint32_t>, EntityUuidHash> m_waiting;
+
+	// Scratch for propagate() (reused between frames)
+	std::vector<std::uint32_t> m_level;
+	std::vector<std::uint32_t> m_nextLevel;
+};
@@ -0,0 +1,276 @@
+// EntityParsePipeline.cpp
+#include "EntityParsePipeline.hpp"
+#include "WireSchema.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+// Entity server layouts are little-endian
+using Vec3 = Wire::Vec3<Wire::F32LE>;
+using Quat = Wire::QuatXYZW<Wire::F32LE>;
+
+// [parent_id:uuid(16)][parent_joint:u16], all or nothing
+bool readParent(Wire::Reader& reader, EntityUuid& id, std::uint16_t& joint) {
+    Wire::Uuid::value_type bytes;
+    std::uint16_t j = 0;
+    if (!reader.read<Wire::Uuid, Wire::U16LE>(bytes, j)) return false;
+    id = EntityUuid::fromBytes(bytes.data());
+    joint = j;
+    return true;
+}
+
+bool isEntityPacket(std::uint8_t type) {
+    return type == EntityPacket::Add || type == EntityPacket::Data ||
+           type == EntityPacket::Edit || type == EntityPacket::Erase;
+}
+
+} // anonymous namespace
+
+bool decodeEntityPacket(const char* data, std::size_t len, EntityOp& out) {
+    out.kind = EntityOp::Kind::Invalid;
+    if (len < 1) return false;
+    out.packetType = static_cast<std::uint8_t>(data[0]);
+
+    switch (out.packetType) {
+        case EntityPacket::Data:
+        case EntityPacket::Add: {
+            // [type:u8][id:uuid(16)][name:cstr][position:3xf32][rotation:4xf32][dimensions:3xf32]
+            // [model_url:cstr][texture_url:cstr][color:3xf32][entity_type:u8]
+            // [parent_id:uuid(16)][parent_joint:u16]
+            // Trailing fields are optional and keep their defaults when absent.
+            if (len < 17) return false;
+            out.id = EntityUuid::fromBytes(data + 1);
+            Wire::Reader reader(data + 17, len - 17);
+            std::string_view text;
+            reader.read<Wire::CString>(text);
+            out.name.assign(text);
+            if (out.name.empty()) {
+                out.name = "Entity_";
+                out.name.append(std::string_view(out.id.toString()).substr(0, 8));
+            }
+            reader.read<Vec3>(out.position);
+            reader.read<Quat>(out.rotation);
+            reader.read<Vec3>(out.dimensions);
+            reader.read<Wire::CString>(text);
+            out.modelUrl.assign(text);
+            reader.read<Wire::CString>(text);
+            out.textureUrl.assign(text);
+            reader.read<Vec3>(out.color);
+            // 0=Unknown, 1=Box, 2=Sphere, 3=Model, ... (Overte EntityTypes.h)
+            std::uint8_t typeCode = 0;
+            if (reader.read<Wire::U8>(typeCode) && typeCode <= static_cast<std::uint8_t>(EntityType::Material)) {
+                out.type = static_cast<EntityType>(typeCode);
+            }
+            readParent(reader, out.parentId, out.parentJoint);
+            out.kind = EntityOp::Kind::Add;
+            return true;
+        }
+
+        case EntityPacket::Edit: {
+            // [type:u8][id:uuid(16)][flags:u8][property data...]
+            if (len < 18) return false;
+            out.id = EntityUuid::fromBytes(data + 1);
+            const auto flags = static_cast<std::uint8_t>(data[17]);
+            Wire::Reader reader(data + 18, len - 18);
+            // Flags whose data is truncated are dropped so they don't apply defaults.
+            out.editFlags = 0;
+            if ((flags & EntityPacket::HasPosition) && reader.read<Vec3>(out.position))
+                out.editFlags |= EntityPacket::HasPosition;
+            if ((flags & EntityPacket::HasRotation) && reader.read<Quat>(out.rotation))
+                out.editFlags |= EntityPacket::HasRotation;
+            if ((flags & EntityPacket::HasDimensions) && reader.read<Vec3>(out.dimensions))
+                out.editFlags |= EntityPacket::HasDimensions;
+            if ((flags & EntityPacket::HasParent) && readParent(reader, out.parentId, out.parentJoint))
+                out.editFlags |= EntityPacket::HasParent;
+            out.kind = EntityOp::Kind::Edit;
+            return true;
+        }
+
+        case EntityPacket::Erase:
+            // [type:u8][id:uuid(16)]
+            if (len < 17) return false;
+            out.id = EntityUuid::fromBytes(data + 1);
+            out.kind = EntityOp::Kind::Erase;
+            return true;
+
+        case EntityPacket::OctreeStats:
+            // [type:u8][packets:u32][elapsed_us:u32]
+            Wire::Schema<Wire::U32LE, Wire::U32LE>::decode(data + 1, len - 1, out.statsPackets, out.statsElapsedUs);
+            out.kind = EntityOp::Kind::OctreeStats;
+            return true;
+
+        default:
+            out.kind = EntityOp::Kind::Unknown;
+            return true;
+    }
+}
+
+// ============================================================================
+// EntityParsePipeline
+// ============================================================================
+
+unsigned EntityParsePipeline::defaultWorkerCount() {
+    if (const char* env = std::getenv("STARWORLD_PARSE_THREADS")) {
+        return static_cast<unsigned>(std::max(0, std::atoi(env)));
+    }
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw > 1 ? std::min(hw - 1, 4u) : 0u;
+}
+
+std::pmr::memory_resource* EntityParsePipeline::memory() {
+    // Pools up to the largest datagram, so whole packets are pooled too
+    static auto* pool = new std::pmr::synchronized_pool_resource(std::pmr::pool_options{0, 64 * 1024});
+    return pool;
+}
+
+struct EntityParsePipeline::WorkerPool::Sink {
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::vector<EntityOp> done;
+    std::uint64_t decoded{0};
+};
+
+EntityParsePipeline::WorkerPool::WorkerPool(unsigned workers) {
+    m_shards.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        m_shards.push_back(std::make_unique<Shard>());
+    }
+    for (auto& shard : m_shards) {
+        Shard* s = shard.get();
+        s->thread = std::thread([this, s] { workerLoop(*s); });
+    }
+}
+
+EntityParsePipeline::WorkerPool::~WorkerPool() {
+    for (auto& shard : m_shards) {
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->stop = true;
+        }
+        shard->wake.notify_one();
+    }
+    for (auto& shard : m_shards) {
+        if (shard->thread.joinable()) shard->thread.join();
+    }
+}
+
+void EntityParsePipeline::WorkerPool::workerLoop(Shard& shard) {
+    std::vector<EntityOp> local;
+    std::pmr::deque<Job> batch(memory());
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    while (true) {
+        shard.wake.wait(lock, [&] { return shard.stop || !shard.jobs.empty(); });
+        if (shard.jobs.empty()) return; // stop requested and nothing left
+
+        // Take the whole backlog and decode it without holding the lock.
+        batch.clear();
+        batch.swap(shard.jobs);
+        lock.unlock();
+
+        local.clear();
+        local.reserve(batch.size());
+        for (auto& job : batch) {
+            EntityOp op(memory());
+            decodeEntityPacket(job.bytes.data(), job.bytes.size(), op);
+            op.seq = job.seq;
+            op.rxTime = job.rxTime;
+            local.push_back(std::move(op));
+        }
+
+        // Hand each run of ops to the pipeline it came from
+        for (std::size_t i = 0; i < local.size();) {
+            Sink* sink = batch[i].sink;
+            std::size_t end = i;
+            {
+                std::lock_guard<std::mutex> sinkLock(sink->mutex);
+                for (; end < local.size() && batch[end].sink == sink; ++end) {
+                    sink->done.push_back(std::move(local[end]));
+                }
+                sink->decoded += end - i;
+                // Under the lock: the pipeline may be destroyed once it sees this
+                sink->idle.notify_all();
+            }
+            i = end;
+        }
+
+        lock.lock();
+    }
+}
+
+EntityParsePipeline::EntityParsePipeline(unsigned workers)
+    : EntityParsePipeline(workers > 0 ? std::make_shared<WorkerPool>(workers) : nullptr) {}
+
+EntityParsePipeline::EntityParsePipeline(std::shared_ptr<WorkerPool> pool)
+    : m_pool(pool && pool->size() > 0 ? std::move(pool) : nullptr),
+      m_sink(std::make_unique<WorkerPool::Sink>()) {}
+
+EntityParsePipeline::~EntityParsePipeline() {
+    // Workers of a shared pool may still hold jobs pointing at our sink
+    waitIdle();
+}
+
+void EntityParsePipeline::submit(const char* data, std::size_t len, std::chrono::steady_clock::time_point rxTime) {
+    const std::uint64_t seq = m_nextSeq++;
+
+    if (!m_pool) {
+        EntityOp op(memory());
+        decodeEntityPacket(data, len, op);
+        op.seq = seq;
+        op.rxTime = rxTime;
+        m_inlineDone.push_back(std::move(op));
+        return;
+    }
+
+    // Header peek: route by entity UUID so per-entity order is preserved.
+    auto& shards = m_pool->m_shards;
+    std::size_t shardIndex = 0;
+    if (len >= 17 && isEntityPacket(static_cast<std::uint8_t>(data[0]))) {
+        shardIndex = EntityUuid::fromBytes(data + 1).hash() % shards.size();
+    }
+
+    WorkerPool::Shard& shard = *shards[shardIndex];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.jobs.push_back(WorkerPool::Job{m_sink.get(), seq, rxTime, std::pmr::vector<char>(data, data + len, memory())});
+    }
+    shard.wake.notify_one();
+}
+
+void EntityParsePipeline::drain(std::vector<EntityOp>& out) {
+    if (!m_pool) {
+        for (auto& op : m_inlineDone) out.push_back(std::move(op));
+        m_inlineDone.clear();
+        m_nextCommit = m_nextSeq;
+        return;
+    }
+
+    const std::size_t before = m_pending.size();
+    {
+        std::lock_guard<std::mutex> lock(m_sink->mutex);
+        for (auto& op : m_sink->done) m_pending.push_back(std::move(op));
+        m_sink->done.clear();
+    }
+    if (m_pending.empty()) return;
+    if (m_pending.size() != before) {
+        std::sort(m_pending.begin(), m_pending.end(),
+                  [](const EntityOp& a, const EntityOp& b) { return a.seq < b.seq; });
+    }
+
+    // Release the contiguous prefix; later ops wait for slower shards.
+    std::size_t n = 0;
+    while (n < m_pending.size() && m_pending[n].seq == m_nextCommit) {
+        out.push_back(std::move(m_pending[n]));
+        ++m_nextCommit;
+        ++n;
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(n));
+}
+
+void EntityParsePipeline::waitIdle() {
+    if (!m_pool) return;
+    std::unique_lock<std::mutex> lock(m_sink->mutex);
+    m_sink->idle.wait(lock, [&] { return m_sink->decoded == m_nextSeq; });
+}
@@ -0,0 +1,174 @@
+// EntityParsePipeline.hpp
+// Multi-threaded decoding of entity server packets.
+//
+// submit() peeks the packet type and entity UUID and hands a copy of the
+// payload to one of N worker threads, sharded by UUID hash so every packet for
+// a given entity is decoded by the same worker in arrival order. Workers
+// decode into per-shard output buffers; drain() returns the decoded ops in
+// submission order so the caller can apply them to the EntityStore exactly as
+// if they had been parsed serially.
+//
+// Queued packet bytes, the job queues and the strings of decoded ops come
+// from one process-wide pool (EntityParsePipeline::memory()), so once the
+// pools have warmed up a packet's trip through the pipeline makes no heap
+// allocation.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "EntityStore.hpp"
+
+// Entity packet types (first payload byte)
+namespace EntityPacket {
+	constexpr std::uint8_t Add = 0x10;
+	constexpr std::uint8_t Edit = 0x11;
+	constexpr std::uint8_t Erase = 0x12;
+	constexpr std::uint8_t Query = 0x15;
+	constexpr std::uint8_t OctreeStats = 0x16; // [packets:u32][elapsed_us:u32] (optional)
+	constexpr std::uint8_t Data = 0x41; // Bulk entity data response (same layout as Add)
+
+	// EntityEdit property flags
+	constexpr std::uint8_t HasPosition = 0x01;
+	constexpr std::uint8_t HasRotation = 0x02;
+	constexpr std::uint8_t HasDimensions = 0x04;
+	constexpr std::uint8_t HasParent = 0x08;     // [parent_id:uuid(16)][parent_joint:u16]
+
+	constexpr std::uint16_t NoJoint = 0xFFFF;
+}
+
+// One decoded entity packet.
+struct EntityOp {
+	enum class Kind : std::uint8_t {
+		Invalid,     // Truncated/malformed entity packet
+		Add,         // EntityAdd / EntityData: all fields below are set
+		Edit,        // EntityEdit: only fields named by editFlags are set
+		Erase,
+		OctreeStats,
+		Unknown      // Unrecognized packet type (packetType holds it)
+	};
+
+	Kind kind{Kind::Invalid};
+	std::uint8_t packetType{0};
+	std::uint8_t editFlags{0};
+	std::uint64_t seq{0};      // Submission order, assigned by the pipeline
+	std::chrono::steady_clock::time_point rxTime{}; // When the packet was received (latency tracing)
+	EntityUuid id;
+
+	std::pmr::string name;
+	glm::vec3 position{0.0f, 1.5f, -2.0f};
+	glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+	glm::vec3 dimensions{0.1f, 0.1f, 0.1f};
+	std::pmr::string modelUrl;
+	std::pmr::string textureUrl;
+	glm::vec3 color{1.0f, 1.0f, 1.0f};
+	EntityType type{EntityType::Box};
+	EntityUuid parentId;       // Null = no parent
+	std::uint16_t parentJoint{EntityPacket::NoJoint};
+
+	// OctreeStats: packets the server sent over elapsedUs (0 if not reported)
+	std::uint32_t statsPackets{0};
+	std::uint32_t statsElapsedUs{0};
+
+	EntityOp() = default;
+	explicit EntityOp(std::pmr::memory_resource* memory) : name(memory), modelUrl(memory), textureUrl(memory) {}
+};
+
+// Decode one entity packet. Pure function; safe to call from any thread.
+// Returns false (and sets kind = Invalid) for truncated entity packets.
+bool decodeEntityPacket(const char* data, std::size_t len, EntityOp& out);
+
+class EntityParsePipeline {
+public:
+	// Decoder threads. One pool can serve several pipelines (one per domain
+	// session); each pipeline still routes a given UUID to one worker, so
+	// per-entity order holds within every session.
+	class WorkerPool {
+	public:
+		explicit WorkerPool(unsigned workers = defaultWorkerCount());
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		unsigned size() const { return static_cast<unsigned>(m_shards.size()); }
+
+	private:
+		friend class EntityParsePipeline;
+
+		struct Sink;
+		struct Job {
+			Sink* sink;
+			std::uint64_t seq;
+			std::chrono::steady_clock::time_point rxTime;
+			std::pmr::vector<char> bytes;
+		};
+
+		struct Shard {
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::pmr::deque<Job> jobs{memory()};
+			bool stop{false};
+			std::thread thread;
+		};
+
+		void workerLoop(Shard& shard);
+
+		std::vector<std::unique_ptr<Shard>> m_shards;
+	};
+
+	// workers == 0 decodes inline on the calling thread inside submit().
+	explicit EntityParsePipeline(unsigned workers = defaultWorkerCount());
+	// Decode on a shared pool (nullptr or an empty pool: inline).
+	explicit EntityParsePipeline(std::shared_ptr<WorkerPool> pool);
+	~EntityParsePipeline();
+
+	EntityParsePipeline(const EntityParsePipeline&) = delete;
+	EntityParsePipeline& operator=(const EntityParsePipeline&) = delete;
+
+	// Receive stage: header peek + hand-off. Copies `data`. `rxTime` is
+	// carried through to the decoded op.
+	void submit(const char* data, std::size_t len, std::chrono::steady_clock::time_point rxTime = {});
+
+	// Commit stage: append every op whose predecessors have all been decoded,
+	// in submission order. Never blocks on workers.
+	void drain(std::vector<EntityOp>& out);
+
+	// Block until all submitted packets are decoded (tests, shutdown).
+	void waitIdle();
+
+	// Packets submitted but not yet returned by drain().
+	std::size_t backlog() const { return static_cast<std::size_t>(m_nextSeq - m_nextCommit); }
+
+	unsigned workerCount() const { return m_pool ? m_pool->size() : 0; }
+
+	// STARWORLD_PARSE_THREADS if set, else hardware threads - 1 capped at 4.
+	static unsigned defaultWorkerCount();
+
+	// Pool behind queued packets and the strings of decoded ops. Shared by
+	// all pipelines and never destroyed, so ops may outlive their pipeline.
+	static std::pmr::memory_resource* memory();
+
+private:
+	std::shared_ptr<WorkerPool> m_pool;  // null: inline
+
+	// This pipeline's decoded ops, filled by whichever workers ran its jobs
+	std::unique_ptr<WorkerPool::Sink> m_sink;
+
+	std::vector<EntityOp> m_inlineDone;  // no workers
+	std::vector<EntityOp> m_pending;     // decoded, waiting for earlier seqs
+	std::uint64_t m_nextSeq{0};
+	std::uint64_t m_nextCommit{0};
+};
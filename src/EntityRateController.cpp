@@ -0,0 +1,99 @@
+// EntityRateController.cpp
+#include "EntityRateController.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+EntityRateController::Config EntityRateController::configFromEnv() {
+    Config config;
+    if (const char* env = std::getenv("STARWORLD_ENTITY_MAX_PPS")) {
+        const int v = std::atoi(env);
+        if (v > 0) config.maxPps = std::max(v, config.minPps);
+    }
+    if (const char* env = std::getenv("STARWORLD_ENTITY_BUDGET_PCT")) {
+        const double v = std::atof(env);
+        if (v > 0.0) config.budget = std::min(v, 100.0) / 100.0;
+    }
+    config.initialPps = std::clamp(config.initialPps, config.minPps, config.maxPps);
+    return config;
+}
+
+EntityRateController::EntityRateController(Config config)
+    : m_config(config), m_pps(std::clamp(config.initialPps, config.minPps, config.maxPps)) {}
+
+void EntityRateController::recordServerStats(std::uint32_t packets, std::uint32_t elapsedUs) {
+    if (elapsedUs == 0) return;
+    m_serverPackets += packets;
+    m_serverElapsedUs += elapsedUs;
+}
+
+void EntityRateController::decrease() {
+    // From the rate the server is actually held to, not a pending increase
+    const int base = m_sentPps > 0 ? std::min(m_pps, m_sentPps) : m_pps;
+    m_pps = std::max(m_config.minPps, static_cast<int>(base * m_config.decreaseFactor));
+}
+
+bool EntityRateController::update(Clock::time_point now, std::size_t backlog) {
+    if (m_windowStart == Clock::time_point{}) m_windowStart = now;
+    if (m_sentPps == 0) return m_lastFailed == Clock::time_point{} || now - m_lastFailed >= m_config.retryInterval;
+
+    const auto window = now - m_windowStart;
+    if (window < m_config.interval) return false;
+
+    const double seconds = std::chrono::duration<double>(window).count();
+    const double costUs = std::chrono::duration<double, std::micro>(m_cost).count();
+    double perPacket = m_costPerPacketUs;
+    if (m_received > 0) {
+        perPacket = costUs / static_cast<double>(m_received);
+        m_costPerPacketUs = m_costPerPacketUs == 0.0 ? perPacket : m_costPerPacketUs * 0.7 + perPacket * 0.3;
+    }
+
+    // What the server sent: its own count if it reports one, else what arrived
+    const double sentRate = m_serverElapsedUs > 0
+        ? static_cast<double>(m_serverPackets) * 1e6 / static_cast<double>(m_serverElapsedUs)
+        : static_cast<double>(m_received) / seconds;
+    const bool loss = m_serverPackets >= 50 && static_cast<double>(m_received) < 0.8 * static_cast<double>(m_serverPackets);
+    const bool overBudget = costUs * 1e-6 / seconds > m_config.budget;
+
+    if (overBudget || backlog > m_config.maxBacklog || loss) {
+        decrease();
+    } else if (sentRate >= 0.8 * m_sentPps) {
+        // Only raise a cap the server is hitting, and only as far as the
+        // per-packet cost (the worse of this window and the average) says
+        // still fits the budget.
+        const int next = std::min(m_config.maxPps, m_pps + m_config.increaseStep);
+        const double cost = std::max(perPacket, m_costPerPacketUs);
+        if (cost == 0.0 || next * cost * 1e-6 <= m_config.budget) m_pps = next;
+    }
+
+    m_windowStart = now;
+    m_received = 0;
+    m_cost = Clock::duration::zero();
+    m_serverPackets = 0;
+    m_serverElapsedUs = 0;
+
+    const double change = std::abs(m_pps - m_sentPps) / static_cast<double>(m_sentPps);
+    if (change < m_config.resendThreshold) return false;
+    // Back off immediately; probe upwards at most every minResend
+    return m_pps < m_sentPps || now - m_lastSent >= m_config.minResend;
+}
+
+void EntityRateController::markSent(Clock::time_point now) {
+    m_sentPps = m_pps;
+    m_lastSent = now;
+    m_lastFailed = {};
+}
+
+void EntityRateController::reset() {
+    m_pps = std::clamp(m_config.initialPps, m_config.minPps, m_config.maxPps);
+    m_sentPps = 0;
+    m_lastSent = {};
+    m_lastFailed = {};
+    m_windowStart = {};
+    m_received = 0;
+    m_cost = Clock::duration::zero();
+    m_serverPackets = 0;
+    m_serverElapsedUs = 0;
+    m_costPerPacketUs = 0.0;
+}
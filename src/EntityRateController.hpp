@@ -0,0 +1,85 @@
+// EntityRateController.hpp
+// Adaptive packet rate (maxOctreePPS) for the EntityQuery.
+//
+// The entity server streams at most the requested number of packets per
+// second. Once per control interval the controller compares what handling
+// them cost on the main thread (receive + commit + SceneSync) against a share
+// of wall time, and adjusts the rate AIMD-style:
+//   - over budget, parse backlog, or loss against OctreeStats: multiply down
+//   - else, if the server is actually using the current allowance and the
+//     measured per-packet cost leaves room for it: add a fixed step
+// A cap the server never reaches is not raised further. The client re-issues
+// the EntityQuery whenever pps() moved far enough from the last sent value.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+class EntityRateController {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Config {
+		int initialPps{3000};
+		int minPps{200};
+		int maxPps{20000};                 // STARWORLD_ENTITY_MAX_PPS
+		int increaseStep{250};
+		double decreaseFactor{0.5};
+		double budget{0.25};               // Share of wall time (STARWORLD_ENTITY_BUDGET_PCT)
+		std::size_t maxBacklog{256};       // Submitted but not yet committed packets
+		Clock::duration interval{std::chrono::milliseconds(500)};
+		Clock::duration minResend{std::chrono::seconds(2)};  // Between increases
+		Clock::duration retryInterval{std::chrono::seconds(1)};  // After a failed send
+		double resendThreshold{0.1};       // Relative change worth a new query
+	};
+
+	// Defaults with the STARWORLD_ENTITY_* overrides applied.
+	static Config configFromEnv();
+
+	explicit EntityRateController(Config config = configFromEnv());
+
+	// Entity packets read from the network.
+	void recordPackets(std::size_t count) { m_received += count; }
+	// Main-thread time spent handling entity packets.
+	void recordCost(Clock::duration cost) { m_cost += cost; }
+	// OctreeStats: the server sent `packets` over `elapsedUs` microseconds.
+	void recordServerStats(std::uint32_t packets, std::uint32_t elapsedUs);
+
+	// Call once per poll. Returns true when a query should be sent with pps()
+	// (the first call always does); the caller then calls markSent(), or
+	// markFailed() if the send did not go out. Until the first query is out,
+	// a failure holds the next attempt off for retryInterval.
+	bool update(Clock::time_point now, std::size_t backlog);
+	void markSent(Clock::time_point now);
+	void markFailed(Clock::time_point now) { m_lastFailed = now; }
+
+	// Share of wall time the entity path may use (Config::budget).
+	void setBudget(double budget) { m_config.budget = budget; }
+	double budget() const { return m_config.budget; }
+
+	int pps() const { return m_pps; }
+	int sentPps() const { return m_sentPps; }  // 0 until the first query
+	double costPerPacketUs() const { return m_costPerPacketUs; }
+
+	// Forget measurements and the sent rate (new entity server).
+	void reset();
+
+private:
+	void decrease();
+
+	Config m_config;
+	int m_pps;
+	int m_sentPps{0};
+	Clock::time_point m_lastSent{};
+	Clock::time_point m_lastFailed{};
+	Clock::time_point m_windowStart{};
+
+	// Current window
+	std::size_t m_received{0};
+	Clock::duration m_cost{};
+	std::uint64_t m_serverPackets{0};
+	std::uint64_t m_serverElapsedUs{0};
+
+	double m_costPerPacketUs{0.0};  // EMA over windows with traffic
+};
@@ -0,0 +1,306 @@
+// EntityStore.cpp
+#include "EntityStore.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ============================================================================
+// EntityUuid
+// ============================================================================
+
+EntityUuid EntityUuid::fromBytes(const void* data) {
+    EntityUuid id;
+    std::memcpy(id.bytes.data(), data, id.bytes.size());
+    return id;
+}
+
+EntityUuid EntityUuid::fromCounter(std::uint64_t counter) {
+    // Version 8 (custom) UUID with the counter in the low bytes
+    EntityUuid id;
+    for (int i = 0; i < 8; ++i) {
+        id.bytes[15 - i] = static_cast<std::uint8_t>((counter >> (i * 8)) & 0xFF);
+    }
+    id.bytes[6] = 0x80;
+    id.bytes[8] = 0x80;
+    return id;
+}
+
+bool EntityUuid::isNull() const {
+    for (auto b : bytes) {
+        if (b != 0) return false;
+    }
+    return true;
+}
+
+std::uint64_t EntityUuid::hash() const {
+    std::uint64_t a, b;
+    std::memcpy(&a, bytes.data(), 8);
+    std::memcpy(&b, bytes.data() + 8, 8);
+    // Random (v4) UUIDs are already well distributed, but locally generated
+    // and sequential ones are not; run both halves through a splitmix finalizer.
+    std::uint64_t h = a ^ (b * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+std::string EntityUuid::toString() const {
+    char buf[37];
+    std::snprintf(buf, sizeof(buf),
+                  "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                  bytes[0], bytes[1], bytes[2], bytes[3],
+                  bytes[4], bytes[5], bytes[6], bytes[7],
+                  bytes[8], bytes[9], bytes[10], bytes[11],
+                  bytes[12], bytes[13], bytes[14], bytes[15]);
+    return buf;
+}
+
+// ============================================================================
+// EntityIndex
+// ============================================================================
+
+namespace {
+
+constexpr std::int8_t kEmpty = -128;   // 0b10000000
+constexpr std::int8_t kDeleted = -2;   // 0b11111110
+constexpr std::size_t kMinCapacity = 16;
+
+inline std::int8_t h2Of(std::uint64_t hash) { return static_cast<std::int8_t>(hash & 0x7F); }
+inline std::size_t h1Of(std::uint64_t hash) { return static_cast<std::size_t>(hash >> 7); }
+
+// Bit i set where group byte i equals `value`.
+inline std::uint32_t matchByte(const std::int8_t* group, std::int8_t value) {
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+    std::uint32_t mask = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (group[i] == value) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+// Bit i set where group byte i is empty or deleted (high bit set).
+inline std::uint32_t matchEmptyOrDeleted(const std::int8_t* group) {
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+    std::uint32_t mask = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (group[i] < 0) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+inline int lowestBit(std::uint32_t mask) { return __builtin_ctz(mask); }
+
+} // anonymous namespace
+
+EntityIndex::EntityIndex() {
+    rehash(kMinCapacity);
+}
+
+std::size_t EntityIndex::findBucket(const EntityUuid& key, std::uint64_t hash) const {
+    const std::size_t groupMask = m_ctrl.size() / kGroupWidth - 1;
+    const std::int8_t h2 = h2Of(hash);
+    std::size_t group = h1Of(hash) & groupMask;
+    // Triangular probing over groups visits every group once.
+    for (std::size_t step = 1; step <= groupMask + 1; ++step) {
+        const std::size_t base = group * kGroupWidth;
+        const std::int8_t* ctrl = m_ctrl.data() + base;
+        std::uint32_t candidates = matchByte(ctrl, h2);
+        while (candidates) {
+            const std::size_t idx = base + lowestBit(candidates);
+            if (m_buckets[idx].key == key) return idx;
+            candidates &= candidates - 1;
+        }
+        // An empty byte means the key was never pushed further along.
+        if (matchByte(ctrl, kEmpty)) return npos;
+        group = (group + step) & groupMask;
+    }
+    return npos;
+}
+
+std::size_t EntityIndex::findInsertBucket(std::uint64_t hash) const {
+    const std::size_t groupMask = m_ctrl.size() / kGroupWidth - 1;
+    std::size_t group = h1Of(hash) & groupMask;
+    for (std::size_t step = 1; step <= groupMask + 1; ++step) {
+        const std::size_t base = group * kGroupWidth;
+        const std::uint32_t free = matchEmptyOrDeleted(m_ctrl.data() + base);
+        if (free) return base + lowestBit(free);
+        group = (group + step) & groupMask;
+    }
+    return npos; // unreachable: load factor keeps free buckets available
+}
+
+std::uint32_t EntityIndex::find(const EntityUuid& key) const {
+    const std::size_t idx = findBucket(key, key.hash());
+    return idx == npos ? npos : m_buckets[idx].value;
+}
+
+bool EntityIndex::insert(const EntityUuid& key, std::uint32_t value) {
+    const std::uint64_t hash = key.hash();
+    const std::size_t existing = findBucket(key, hash);
+    if (existing != npos) {
+        m_buckets[existing].value = value;
+        return false;
+    }
+
+    // Keep load (live + tombstones) at or below 7/8.
+    if ((m_size + m_tombstones + 1) * 8 > m_ctrl.size() * 7) {
+        // Grow only if live entries need it; otherwise just purge tombstones.
+        const std::size_t target = (m_size + 1) * 8 > m_ctrl.size() * 4 ? m_ctrl.size() * 2 : m_ctrl.size();
+        rehash(target);
+    }
+
+    const std::size_t idx = findInsertBucket(hash);
+    if (m_ctrl[idx] == kDeleted) --m_tombstones;
+    m_ctrl[idx] = h2Of(hash);
+    m_buckets[idx].key = key;
+    m_buckets[idx].value = value;
+    ++m_size;
+    return true;
+}
+
+bool EntityIndex::erase(const EntityUuid& key) {
+    const std::size_t idx = findBucket(key, key.hash());
+    if (idx == npos) return false;
+    // If the group still has an empty byte, probes stop here anyway and the
+    // bucket can become empty again instead of a tombstone.
+    const std::size_t base = idx - (idx % kGroupWidth);
+    if (matchByte(m_ctrl.data() + base, kEmpty)) {
+        m_ctrl[idx] = kEmpty;
+    } else {
+        m_ctrl[idx] = kDeleted;
+        ++m_tombstones;
+    }
+    m_buckets[idx].value = npos;
+    --m_size;
+    return true;
+}
+
+void EntityIndex::clear() {
+    std::fill(m_ctrl.begin(), m_ctrl.end(), kEmpty);
+    m_size = 0;
+    m_tombstones = 0;
+}
+
+void EntityIndex::reserve(std::size_t count) {
+    std::size_t cap = kMinCapacity;
+    while (cap * 7 < count * 8) cap *= 2;
+    if (cap > m_ctrl.size()) rehash(cap);
+}
+
+void EntityIndex::shrink() {
+    // Leave the table at most half full, so the inserts that follow do not
+    // grow it straight back
+    std::size_t cap = kMinCapacity;
+    while (cap < m_size * 2) cap *= 2;
+    if (cap < m_ctrl.size()) rehash(cap);
+}
+
+void EntityIndex::rehash(std::size_t newCapacity) {
+    decltype(m_ctrl) oldCtrl;
+    decltype(m_buckets) oldBuckets;
+    oldCtrl.swap(m_ctrl);
+    oldBuckets.swap(m_buckets);
+
+    m_ctrl.assign(newCapacity, kEmpty);
+    m_buckets.assign(newCapacity, Bucket{});
+    m_tombstones = 0;
+
+    for (std::size_t i = 0; i < oldCtrl.size(); ++i) {
+        if (oldCtrl[i] < 0) continue;
+        const std::uint64_t hash = oldBuckets[i].key.hash();
+        const std::size_t idx = findInsertBucket(hash);
+        m_ctrl[idx] = h2Of(hash);
+        m_buckets[idx] = oldBuckets[i];
+    }
+}
+
+// ============================================================================
+// EntityStore
+// ============================================================================
+
+OverteEntity* EntityStore::get(const EntityUuid& id) {
+    const std::uint32_t slot = m_index.find(id);
+    return slot == npos ? nullptr : &m_slots[slot];
+}
+
+const OverteEntity* EntityStore::get(const EntityUuid& id) const {
+    const std::uint32_t slot = m_index.find(id);
+    return slot == npos ? nullptr : &m_slots[slot];
+}
+
+std::uint32_t EntityStore::emplace(const EntityUuid& id, bool* created) {
+    std::uint32_t slot = m_index.find(id);
+    if (slot != npos) {
+        if (created) *created = false;
+        return slot;
+    }
+
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_slots[slot] = OverteEntity{};
+        m_live[slot] = 1;
+    } else {
+        slot = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+        m_live.push_back(1);
+    }
+    m_slots[slot].id = id;
+    m_slots[slot].slot = slot;
+    m_index.insert(id, slot);
+    if (created) *created = true;
+    return slot;
+}
+
+std::uint32_t EntityStore::erase(const EntityUuid& id) {
+    const std::uint32_t slot = m_index.find(id);
+    if (slot == npos) return npos;
+    m_index.erase(id);
+    m_live[slot] = 0;
+    m_retired.push_back(slot);
+    return slot;
+}
+
+void EntityStore::recycleRetired() {
+    for (auto slot : m_retired) {
+        // Release storage held by the dead entity now rather than on reuse.
+        const OverteEntity& dead = m_slots[slot];
+        m_strings.release(dead.name);
+        m_strings.release(dead.modelUrl);
+        m_strings.release(dead.textureUrl);
+        m_slots[slot] = OverteEntity{};
+        m_freeSlots.push_back(slot);
+    }
+    m_retired.clear();
+}
+
+void EntityStore::shrink() {
+    releaseSpare(m_slots);
+    releaseSpare(m_live);
+    releaseSpare(m_freeSlots);
+    releaseSpare(m_retired);
+    m_index.shrink();
+}
+
+void EntityStore::clear() {
+    m_slots.clear();
+    m_live.clear();
+    m_freeSlots.clear();
+    m_retired.clear();
+    m_index.clear();
+    m_strings.clear();
+}
@@ -0,0 +1,191 @@
+// EntityStore.hpp
+// Dense storage for Overte entities keyed by their 16-byte UUID.
+//
+// Entities live in a slot array; an open-addressing (Swiss-table style) index
+// maps UUID -> slot. Control bytes are probed 16 at a time with SSE2, so a
+// lookup normally touches one control group and one key slot.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "MemoryBudget.hpp"
+#include "StringTable.hpp"
+
+// Overte entity types (matching Overte EntityTypes.h)
+enum class EntityType {
+	Unknown,
+	Box,
+	Sphere,
+	Model,
+	Shape,
+	Light,
+	Text,
+	Zone,
+	Web,
+	ParticleEffect,
+	Line,
+	PolyLine,
+	Grid,
+	Gizmo,
+	Material
+};
+
+// RFC 4122 UUID as sent on the wire (QUuid byte order).
+struct EntityUuid {
+	std::array<std::uint8_t, 16> bytes{};
+
+	static EntityUuid fromBytes(const void* data);
+	// Deterministic UUID for locally generated entities (simulation mode).
+	static EntityUuid fromCounter(std::uint64_t counter);
+
+	bool isNull() const;
+	std::uint64_t hash() const;
+	std::string toString() const; // xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+
+	bool operator==(const EntityUuid& other) const { return bytes == other.bytes; }
+	bool operator!=(const EntityUuid& other) const { return bytes != other.bytes; }
+};
+
+struct EntityUuidHash {
+	std::size_t operator()(const EntityUuid& id) const { return static_cast<std::size_t>(id.hash()); }
+};
+
+struct OverteEntity {
+	EntityUuid id;
+	std::uint32_t slot{0};       // Dense index assigned by EntityStore
+	StringId name{StringTable::Empty};  // Interned in EntityStore::strings()
+	glm::mat4 transform{1.0f};   // Local (parent-relative), composed from position/rotation/scale
+	glm::mat4 worldTransform{1.0f}; // parent world * transform (see EntityHierarchy)
+
+	// Hierarchy. parentSlot is maintained by EntityHierarchy and stays npos
+	// while the parent entity is unknown.
+	EntityUuid parentId;
+	std::uint16_t parentJoint{0xFFFF};
+	std::uint32_t parentSlot{0xFFFFFFFFu};
+
+	// Decomposed transform as received from the server
+	glm::vec3 position{0.0f, 0.0f, 0.0f};
+	glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+	glm::vec3 scale{1.0f, 1.0f, 1.0f};
+
+	// Visual properties
+	EntityType type{EntityType::Box};
+	StringId modelUrl{StringTable::Empty};    // For Model type entities
+	StringId textureUrl{StringTable::Empty};  // Texture/material URL
+	glm::vec3 color{1.0f, 1.0f, 1.0f};  // RGB color (0-1 range)
+	glm::vec3 dimensions{0.1f, 0.1f, 0.1f};  // Size/scale in meters
+	float alpha{1.0f};         // Transparency (0-1)
+
+	// Receive time of the oldest network change not yet handed to the
+	// compositor (epoch = none). Used for latency tracing.
+	std::chrono::steady_clock::time_point rxTime{};
+};
+
+// Open-addressing hash index UUID -> uint32 value.
+// Layout follows the Swiss-table scheme: one control byte per bucket
+// (empty / deleted / 7 bits of hash) in groups of 16 that are matched with a
+// single SSE2 compare, plus a parallel array of {key, value} buckets.
+class EntityIndex {
+public:
+	static constexpr std::uint32_t npos = 0xFFFFFFFFu;
+
+	EntityIndex();
+
+	std::uint32_t find(const EntityUuid& key) const;
+	// Inserts or overwrites. Returns true if the key was new.
+	bool insert(const EntityUuid& key, std::uint32_t value);
+	bool erase(const EntityUuid& key);
+	void clear();
+	void reserve(std::size_t count);
+	// Rehash into the smallest table that holds the current keys.
+	void shrink();
+
+	std::size_t size() const { return m_size; }
+	std::size_t capacity() const { return m_ctrl.size(); }
+
+private:
+	static constexpr std::size_t kGroupWidth = 16;
+
+	struct Bucket {
+		EntityUuid key;
+		std::uint32_t value{npos};
+	};
+
+	// Returns bucket index of `key` or npos.
+	std::size_t findBucket(const EntityUuid& key, std::uint64_t hash) const;
+	// First empty or deleted bucket along the probe sequence of `hash`.
+	std::size_t findInsertBucket(std::uint64_t hash) const;
+	void rehash(std::size_t newCapacity);
+
+	TrackedVector<std::int8_t, MemoryBudget::Subsystem::Entities> m_ctrl;
+	TrackedVector<Bucket, MemoryBudget::Subsystem::Entities> m_buckets;
+	std::size_t m_size{0};
+	std::size_t m_tombstones{0};
+};
+
+// Owns all entities of one domain session. Slots are dense and stable while
+// an entity is alive; erased slots are retired and only handed out again after
+// recycleRetired(), so consumers holding slot ids from the same frame never
+// see a slot change identity underneath them.
+class EntityStore {
+public:
+	static constexpr std::uint32_t npos = EntityIndex::npos;
+
+	std::uint32_t find(const EntityUuid& id) const { return m_index.find(id); }
+	OverteEntity* get(const EntityUuid& id);
+	const OverteEntity* get(const EntityUuid& id) const;
+
+	// Returns the slot for `id`, creating a default entity if needed.
+	// `created` is set to true when a new slot was allocated.
+	std::uint32_t emplace(const EntityUuid& id, bool* created = nullptr);
+	// Retires the entity's slot. Returns the retired slot or npos.
+	std::uint32_t erase(const EntityUuid& id);
+	// Make retired slots available for reuse, releasing their strings.
+	void recycleRetired();
+	void clear();
+	// Give spare capacity back (memory pressure). Invalidates pointers from
+	// get() and at(), not slot ids.
+	void shrink();
+
+	bool isLive(std::uint32_t slot) const { return slot < m_live.size() && m_live[slot]; }
+	OverteEntity& at(std::uint32_t slot) { return m_slots[slot]; }
+	const OverteEntity& at(std::uint32_t slot) const { return m_slots[slot]; }
+
+	std::size_t size() const { return m_index.size(); }
+	std::size_t slotCount() const { return m_slots.size(); }
+
+	// Names and URLs of live entities. Each string field of a stored entity
+	// holds one reference; set them with strings().assign().
+	StringTable& strings() { return m_strings; }
+	const StringTable& strings() const { return m_strings; }
+	const std::string& str(StringId id) const { return m_strings.str(id); }
+
+	template <typename Fn>
+	void forEach(Fn&& fn) {
+		for (std::uint32_t s = 0; s < m_slots.size(); ++s) {
+			if (m_live[s]) fn(m_slots[s]);
+		}
+	}
+	template <typename Fn>
+	void forEach(Fn&& fn) const {
+		for (std::uint32_t s = 0; s < m_slots.size(); ++s) {
+			if (m_live[s]) fn(m_slots[s]);
+		}
+	}
+
+private:
+	TrackedVector<OverteEntity, MemoryBudget::Subsystem::Entities> m_slots;
+	TrackedVector<std::uint8_t, MemoryBudget::Subsystem::Entities> m_live;
+	TrackedVector<std::uint32_t, MemoryBudget::Subsystem::Entities> m_freeSlots;
+	TrackedVector<std::uint32_t, MemoryBudget::Subsystem::Entities> m_retired;
+	EntityIndex m_index;
+	StringTable m_strings;
+};
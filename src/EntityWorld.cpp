@@ -0,0 +1,147 @@
+// EntityWorld.cpp
+#include "EntityWorld.hpp"
+
+#include "TransformKernels.hpp"
+
+EntityWorld::Applied EntityWorld::apply(const EntityOp& op, bool queue) {
+    Applied applied;
+    switch (op.kind) {
+        case EntityOp::Kind::Add: {
+            // The transform matrix is composed in batch when the update queue is consumed.
+            applied.slot = m_entities.emplace(op.id, &applied.created);
+            OverteEntity& entity = m_entities.at(applied.slot);
+            if (applied.created) {
+                // Children that arrived first now have their parent
+                m_relinked.clear();
+                m_hierarchy.onAdded(m_entities, applied.slot, m_relinked);
+                m_updateQueue.insert(m_updateQueue.end(), m_relinked.begin(), m_relinked.end());
+            }
+
+            StringTable& strings = m_entities.strings();
+            strings.assign(entity.name, op.name);
+            entity.position = op.position;
+            entity.rotation = op.rotation;
+            entity.scale = op.dimensions;
+            entity.type = op.type;
+            strings.assign(entity.modelUrl, op.modelUrl);
+            strings.assign(entity.textureUrl, op.textureUrl);
+            entity.color = op.color;
+            entity.dimensions = op.dimensions;
+            entity.alpha = 1.0f; // Default fully opaque
+            if (op.parentId != entity.parentId || op.parentJoint != entity.parentJoint) {
+                applied.parentRejected = !setParent(applied.slot, op.parentId, op.parentJoint);
+            }
+            if (queue) markUpdated(applied.slot, op.rxTime);
+            break;
+        }
+
+        case EntityOp::Kind::Edit: {
+            OverteEntity* entity = m_entities.get(op.id);
+            if (!entity) break;
+            applied.slot = entity->slot;
+            // Only the flagged components change; no matrix decomposition needed
+            if (op.editFlags & EntityPacket::HasPosition) entity->position = op.position;
+            if (op.editFlags & EntityPacket::HasRotation) entity->rotation = op.rotation;
+            if (op.editFlags & EntityPacket::HasDimensions) entity->scale = op.dimensions;
+            if (op.editFlags & EntityPacket::HasParent) {
+                applied.parentRejected = !setParent(applied.slot, op.parentId, op.parentJoint);
+            }
+            markUpdated(applied.slot, op.rxTime);
+            break;
+        }
+
+        case EntityOp::Kind::Erase: {
+            const std::uint32_t slot = m_entities.find(op.id);
+            if (slot == EntityStore::npos) break;
+            erase(slot);
+            applied.slot = slot;
+            break;
+        }
+
+        default:
+            break;
+    }
+    return applied;
+}
+
+bool EntityWorld::setParent(std::uint32_t slot, const EntityUuid& parentId, std::uint16_t joint) {
+    return m_hierarchy.setParent(m_entities, slot, parentId, joint);
+}
+
+void EntityWorld::markUpdated(std::uint32_t slot, Clock::time_point rxTime) {
+    m_updateQueue.push_back(slot);
+    OverteEntity& e = m_entities.at(slot);
+    if (e.rxTime == Clock::time_point{}) e.rxTime = rxTime;
+}
+
+void EntityWorld::erase(std::uint32_t slot) {
+    m_relinked.clear();
+    m_hierarchy.onErased(m_entities, slot, m_relinked);
+    m_updateQueue.insert(m_updateQueue.end(), m_relinked.begin(), m_relinked.end());
+    m_entities.erase(m_entities.at(slot).id);
+    m_deleteQueue.push_back(slot);
+}
+
+void EntityWorld::composeQueuedTransforms() {
+    // Gather TRS of every queued entity into contiguous arrays, normalize and
+    // compose them in one kernel call, then scatter the matrices back.
+    m_scratchPositions.clear();
+    m_scratchRotations.clear();
+    m_scratchScales.clear();
+    for (auto slot : m_updateQueue) {
+        if (!m_entities.isLive(slot)) continue;
+        const OverteEntity& e = m_entities.at(slot);
+        m_scratchPositions.push_back(e.position);
+        m_scratchRotations.push_back(e.rotation);
+        m_scratchScales.push_back(e.scale);
+    }
+    const std::size_t count = m_scratchPositions.size();
+    if (count == 0) {
+        m_hierarchy.propagate(m_entities); // orphaned children still need new world transforms
+        return;
+    }
+    m_scratchTransforms.resize(count);
+
+    TransformKernels::normalizeQuats(m_scratchRotations.data(), count);
+    TransformKernels::composeTRS(m_scratchPositions.data(), m_scratchRotations.data(),
+                                 m_scratchScales.data(), m_scratchTransforms.data(), count);
+
+    std::size_t i = 0;
+    for (auto slot : m_updateQueue) {
+        if (!m_entities.isLive(slot)) continue;
+        OverteEntity& e = m_entities.at(slot);
+        e.rotation = m_scratchRotations[i];
+        e.transform = m_scratchTransforms[i];
+        m_hierarchy.markDirty(slot);
+        ++i;
+    }
+
+    // Descendants of moved entities get new world transforms here, but are not
+    // queued: their compositor nodes are parented and follow on their own.
+    m_hierarchy.propagate(m_entities);
+}
+
+std::pmr::vector<OverteEntity> EntityWorld::consumeUpdated(std::pmr::memory_resource* memory) {
+    composeQueuedTransforms();
+
+    std::pmr::vector<OverteEntity> out(memory);
+    out.reserve(m_updateQueue.size());
+    for (auto slot : m_updateQueue) {
+        if (m_entities.isLive(slot)) out.push_back(m_entities.at(slot));
+    }
+    // Cleared after copying: duplicates of a slot all carry the oldest receive time
+    for (auto slot : m_updateQueue) {
+        if (m_entities.isLive(slot)) m_entities.at(slot).rxTime = {};
+    }
+    m_updateQueue.clear();
+    return out;
+}
+
+std::pmr::vector<std::uint32_t> EntityWorld::consumeDeleted(std::pmr::memory_resource* memory) {
+    // Copied rather than swapped out so the queue keeps its capacity
+    std::pmr::vector<std::uint32_t> out(m_deleteQueue.begin(), m_deleteQueue.end(), memory);
+    m_deleteQueue.clear();
+    // Deletions have been handed off; their slots may now be reused
+    m_entities.recycleRetired();
+    return out;
+}
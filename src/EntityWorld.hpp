@@ -0,0 +1,80 @@
+// EntityWorld.hpp
+// The entities of one session: the store, their parent links and the changes
+// the compositor side has not consumed yet.
+//
+// OverteClient commits decoded entity ops through apply() and keeps the
+// protocol around it (snapshot reconcile, initial load, logging); SceneSync
+// consumes the queued changes once per frame. Transforms of queued entities
+// are composed in one batch when they are consumed.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "EntityHierarchy.hpp"
+#include "EntityParsePipeline.hpp"
+#include "EntityStore.hpp"
+
+class EntityWorld {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Applied {
+		std::uint32_t slot{EntityStore::npos};  // npos: the op touched no entity
+		bool created{false};
+		bool parentRejected{false};  // The new parent would have made a cycle
+	};
+	// Commit one decoded op. Add creates or overwrites the entity, Edit
+	// changes the flagged components, Erase retires the slot. `queue` false
+	// keeps an Add out of the update queue (the entity was confirmed
+	// unchanged). Other kinds touch nothing.
+	Applied apply(const EntityOp& op, bool queue = true);
+
+	// Point `slot` at `parentId`; false if that would create a cycle.
+	bool setParent(std::uint32_t slot, const EntityUuid& parentId, std::uint16_t joint);
+	// Queue `slot` for the consumer. The oldest receive time since the last
+	// consume is kept for latency tracing.
+	void markUpdated(std::uint32_t slot, Clock::time_point rxTime = {});
+	// Erase the entity in `slot`; its children become roots and are queued.
+	void erase(std::uint32_t slot);
+
+	// Entities updated since the last call, with composed transforms. Both
+	// consume calls allocate the result from `memory`, typically the
+	// caller's per-frame FrameArena.
+	std::pmr::vector<OverteEntity> consumeUpdated(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+	// Slots of entities erased since the last call. The slots stay retired
+	// until this is called, then become reusable.
+	std::pmr::vector<std::uint32_t> consumeDeleted(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+	std::size_t queuedUpdates() const { return m_updateQueue.size(); }
+
+	EntityStore& store() { return m_entities; }
+	const EntityStore& store() const { return m_entities; }
+	const EntityHierarchy& hierarchy() const { return m_hierarchy; }
+	// Interned names/URLs of store() (non-const so callers can hold references)
+	StringTable& strings() { return m_entities.strings(); }
+
+	// Give spare capacity back (memory pressure). The transform scratch is
+	// left alone: it is refilled every frame.
+	void shrink() { m_entities.shrink(); }
+
+private:
+	void composeQueuedTransforms();
+
+	EntityStore m_entities;
+	EntityHierarchy m_hierarchy;
+	std::vector<std::uint32_t> m_updateQueue; // slots of entities updated since last consume
+	std::vector<std::uint32_t> m_deleteQueue; // retired slots of erased entities
+	std::vector<std::uint32_t> m_relinked;    // scratch: children adopted/orphaned by one op
+
+	// Scratch arrays for batch transform composition (reused between frames)
+	std::vector<glm::vec3> m_scratchPositions;
+	std::vector<glm::quat> m_scratchRotations;
+	std::vector<glm::vec3> m_scratchScales;
+	std::vector<glm::mat4> m_scratchTransforms;
+};
@@ -0,0 +1,69 @@
+// FrameArena.cpp
+#include "FrameArena.hpp"
+
+#include <algorithm>
+
+void* FrameArena::Spill::do_allocate(std::size_t n, std::size_t align) {
+    bytes += n;
+    return std::pmr::new_delete_resource()->allocate(n, align);
+}
+
+void FrameArena::Spill::do_deallocate(void* p, std::size_t n, std::size_t align) {
+    std::pmr::new_delete_resource()->deallocate(p, n, align);
+}
+
+void* FrameArena::Usage::do_allocate(std::size_t n, std::size_t align) {
+    bytes += n;
+    return arena->allocate(n, align);
+}
+
+void FrameArena::Usage::do_deallocate(void* p, std::size_t n, std::size_t align) {
+    arena->deallocate(p, n, align);
+}
+
+FrameArena::FrameArena(std::size_t initialBytes)
+    : m_initial(initialBytes)
+{
+    replaceBuffer(initialBytes);
+}
+
+FrameArena::~FrameArena() {
+    MemoryBudget::sub(MemoryBudget::Subsystem::Arenas, m_capacity);
+}
+
+void FrameArena::replaceBuffer(std::size_t bytes) {
+    m_arena.reset();
+    m_buffer.reset();
+    MemoryBudget::sub(MemoryBudget::Subsystem::Arenas, m_capacity);
+    m_capacity = bytes;
+    m_buffer = std::make_unique<std::byte[]>(m_capacity);
+    MemoryBudget::add(MemoryBudget::Subsystem::Arenas, m_capacity);
+    m_arena.emplace(m_buffer.get(), m_capacity, &m_spill);
+    m_used.arena = &*m_arena;
+}
+
+void FrameArena::reset() {
+    // Hands the spilled chunks back to the heap and rewinds to the buffer
+    m_arena->release();
+    const std::size_t used = m_used.bytes;
+    m_used.bytes = 0;
+
+    if (m_spill.bytes > 0) {
+        // The spill was counted in monotonic chunk sizes, so this leaves headroom
+        const std::size_t grown = std::max(m_capacity * 2, m_capacity + m_spill.bytes);
+        m_spill.bytes = 0;
+        m_quietCycles = 0;
+        ++m_growths;
+        replaceBuffer(grown);
+        return;
+    }
+
+    // A burst is over once cycles keep using under a quarter of the buffer
+    if (m_capacity <= m_initial || used * 4 >= m_capacity) {
+        m_quietCycles = 0;
+        return;
+    }
+    if (++m_quietCycles < kShrinkAfter) return;
+    m_quietCycles = 0;
+    replaceBuffer(std::max(m_initial, m_capacity / 2));
+}
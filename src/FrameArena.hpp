@@ -0,0 +1,97 @@
+// FrameArena.hpp
+// Monotonic std::pmr arena for per-packet and per-frame temporaries.
+//
+// Containers built on resource() allocate by bumping a pointer through a
+// buffer the arena owns, and free nothing until the arena is reset, which
+// drops everything at once. A cycle that outgrows the buffer spills to the
+// heap; the next reset() replaces the buffer with one big enough for that
+// cycle, so once a workload has been seen its later cycles never touch the
+// heap. A buffer grown for a burst is halved again (not below its initial
+// size) after kShrinkAfter cycles in a row that used under a quarter of it.
+// The buffer is booked to MemoryBudget's Arenas subsystem.
+//
+// Cycles are bracketed with a Scope: the arena resets when the outermost
+// Scope ends, so a send that triggers another send does not pull the memory
+// from under its caller. Whatever was built on resource() must be gone by
+// then (declare the Scope first).
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+#include "MemoryBudget.hpp"
+
+class FrameArena {
+public:
+	// Quiet cycles before a grown buffer is halved
+	static constexpr unsigned kShrinkAfter = 600;
+
+	explicit FrameArena(std::size_t initialBytes = 16 * 1024);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	class Scope {
+	public:
+		explicit Scope(FrameArena& arena) : m_arena(arena) { ++m_arena.m_depth; }
+		~Scope() {
+			if (--m_arena.m_depth == 0) m_arena.reset();
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		FrameArena& m_arena;
+	};
+
+	std::pmr::memory_resource* resource() { return &m_used; }
+
+	// Release everything allocated since the last reset, growing the buffer
+	// first if this cycle spilled (or halving it after a quiet stretch).
+	void reset();
+
+	std::size_t capacity() const { return m_capacity; }
+	// Times the buffer had to grow (a steady state stops adding to this)
+	std::size_t growths() const { return m_growths; }
+
+private:
+	// Heap fallback that remembers how much a cycle needed beyond the buffer
+	class Spill : public std::pmr::memory_resource {
+	public:
+		std::size_t bytes{0};
+
+	private:
+		void* do_allocate(std::size_t n, std::size_t align) override;
+		void do_deallocate(void* p, std::size_t n, std::size_t align) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+	};
+
+	// Front of the arena that adds up what a cycle asked for
+	class Usage : public std::pmr::memory_resource {
+	public:
+		std::pmr::memory_resource* arena{nullptr};
+		std::size_t bytes{0};
+
+	private:
+		void* do_allocate(std::size_t n, std::size_t align) override;
+		void do_deallocate(void* p, std::size_t n, std::size_t align) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+	};
+
+	// Swap in a buffer of `bytes` (nothing may be allocated from the old one)
+	void replaceBuffer(std::size_t bytes);
+
+	std::unique_ptr<std::byte[]> m_buffer;
+	std::size_t m_capacity{0};
+	std::size_t m_initial;
+	std::size_t m_growths{0};
+	unsigned m_quietCycles{0};
+	unsigned m_depth{0};
+	Spill m_spill;
+	Usage m_used;
+	std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+};
@@ -0,0 +1,60 @@
+// FramePacer.cpp
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+FramePacer::FramePacer() {
+    double hz = 90.0;
+    if (const char* env = std::getenv("STARWORLD_FRAME_HZ")) {
+        const double v = std::atof(env);
+        if (v > 0.0) hz = v;
+    }
+    m_fallbackPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+    m_period = m_fallbackPeriod;
+}
+
+FramePacer::Clock::duration FramePacer::lead() const {
+    // Expected work plus 1 ms of scheduling slack, never more than half a frame
+    const auto lead = std::chrono::duration_cast<Clock::duration>(m_workEma * 1.5) + std::chrono::milliseconds(1);
+    return std::min<Clock::duration>(lead, m_period / 2);
+}
+
+FramePacer::Clock::time_point FramePacer::nextWake(const StardustBridge::FrameTiming& timing,
+                                                   Clock::time_point lastWake, Clock::duration lead) {
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timing.delta));
+    if (period <= Clock::duration::zero()) return lastWake;
+    auto next = timing.lastFrame + period;
+    if (next - lead <= lastWake) {
+        // Already worked for this frame: skip whole periods past lastWake
+        const auto behind = lastWake - (next - lead);
+        next += period * (behind / period + 1);
+    }
+    return next - lead;
+}
+
+float FramePacer::waitForFrame(const StardustBridge::FrameTiming& timing) {
+    Clock::time_point target;
+    if (timing.valid && timing.delta > 0.0f) {
+        m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timing.delta));
+        target = nextWake(timing, m_lastWake, lead());
+    } else {
+        m_period = m_fallbackPeriod;
+        target = m_lastWake + m_fallbackPeriod;
+    }
+    if (target > Clock::now()) std::this_thread::sleep_until(target);
+
+    const auto wake = Clock::now();
+    const bool first = m_lastWake == Clock::time_point{};
+    const double dt = first ? std::chrono::duration<double>(m_period).count()
+                            : std::chrono::duration<double>(wake - m_lastWake).count();
+    m_lastWake = wake;
+    // A stall (debugger, suspend) shouldn't turn into one huge step
+    return static_cast<float>(std::min(dt, 0.1));
+}
+
+void FramePacer::endFrame() {
+    const std::chrono::duration<double> work = Clock::now() - m_lastWake;
+    m_workEma = m_workEma * 0.9 + work * 0.1;
+}
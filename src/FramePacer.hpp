@@ -0,0 +1,39 @@
+// FramePacer.hpp
+// Paces the main loop against the compositor's frame clock.
+//
+// Each iteration sleeps until just before the compositor's next frame, so the
+// entity state submitted is as fresh as possible when the frame is built. The
+// lead time tracks how long our own frame work takes (EMA + margin). Without
+// compositor timing (no bridge, or before the first frame) it falls back to a
+// fixed nominal rate. Either way callers get the real elapsed dt.
+#pragma once
+
+#include <chrono>
+
+#include "StardustBridge.hpp"
+
+class FramePacer {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// STARWORLD_FRAME_HZ overrides the fallback rate (default 90).
+	FramePacer();
+
+	// Sleep until the next work slot. Returns seconds since the previous slot.
+	float waitForFrame(const StardustBridge::FrameTiming& timing);
+	// Mark the end of this iteration's work (updates the lead estimate).
+	void endFrame();
+
+	// Next time to start work: `lead` before the first compositor frame that
+	// has not been served yet (i.e. whose slot is after `lastWake`).
+	static Clock::time_point nextWake(const StardustBridge::FrameTiming& timing,
+	                                  Clock::time_point lastWake, Clock::duration lead);
+
+	Clock::duration lead() const;
+
+private:
+	Clock::duration m_fallbackPeriod;
+	Clock::time_point m_lastWake{};
+	std::chrono::duration<double> m_workEma{0.002};
+	Clock::duration m_period{};
+};
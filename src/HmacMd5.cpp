@@ -0,0 +1,49 @@
+// HmacMd5.cpp
+// The MD5_* functions are deprecated in OpenSSL 3 in favor of EVP, whose
+// contexts cannot be copied without a heap allocation.
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include "HmacMd5.hpp"
+
+#include <cstring>
+
+namespace {
+
+constexpr std::size_t kBlockSize = 64;
+
+} // anonymous namespace
+
+HmacMd5::HmacMd5(const std::uint8_t* key, std::size_t keyLen) {
+    // Keys longer than a block are hashed first (RFC 2104)
+    std::uint8_t block[kBlockSize] = {};
+    if (keyLen > kBlockSize) {
+        MD5(key, keyLen, block);
+    } else if (keyLen > 0) {
+        std::memcpy(block, key, keyLen);
+    }
+
+    std::uint8_t pad[kBlockSize];
+    for (std::size_t i = 0; i < kBlockSize; ++i) pad[i] = block[i] ^ 0x36;
+    MD5_Init(&m_inner);
+    MD5_Update(&m_inner, pad, kBlockSize);
+    for (std::size_t i = 0; i < kBlockSize; ++i) pad[i] = block[i] ^ 0x5c;
+    MD5_Init(&m_outer);
+    MD5_Update(&m_outer, pad, kBlockSize);
+}
+
+HmacMd5::Digest HmacMd5::sign(const void* data, std::size_t len) const {
+    Digest digest;
+    MD5_CTX ctx = m_inner;
+    MD5_Update(&ctx, data, len);
+    MD5_Final(digest.data(), &ctx);
+    ctx = m_outer;
+    MD5_Update(&ctx, digest.data(), digest.size());
+    MD5_Final(digest.data(), &ctx);
+    return digest;
+}
+
+bool HmacMd5::verify(const void* data, std::size_t len, const std::uint8_t* mac) const {
+    const Digest expected = sign(data, len);
+    std::uint8_t diff = 0;
+    for (std::size_t i = 0; i < kDigestSize; ++i) diff |= expected[i] ^ mac[i];
+    return diff == 0;
+}
@@ -10,7 +10,8 @@ public:
 	InputHandler(StardustBridge& stardust, OverteClient& overte)
 		: m_stardust(stardust), m_overte(overte) {}
 
-	// dt in seconds
+	// dt in seconds. The stick maps straight to a velocity, so nothing here
+	// depends on it yet; it is passed for whatever integrates over time.
 	void update(float dt);
 
 private:
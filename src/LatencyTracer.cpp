@@ -0,0 +1,121 @@
+// LatencyTracer.cpp
+#include "LatencyTracer.hpp"
+
+#include <algorithm>
+#include <bit>
+
+// ============================================================================
+// LatencyHistogram
+// ============================================================================
+
+std::size_t LatencyHistogram::bucketFor(std::uint64_t us) {
+    if (us < kSubBuckets) return static_cast<std::size_t>(us);
+    us = std::min<std::uint64_t>(us, 0xFFFFFFFFull);
+    // Values in [2^k, 2^(k+1)) share 8 linear sub-buckets
+    const unsigned msb = 63u - static_cast<unsigned>(std::countl_zero(us));
+    const std::size_t sub = static_cast<std::size_t>(us >> (msb - 3)) & (kSubBuckets - 1);
+    return (msb - 2) * kSubBuckets + sub;
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const unsigned msb = static_cast<unsigned>(bucket / kSubBuckets) + 2;
+    const std::uint64_t sub = bucket % kSubBuckets;
+    const std::uint64_t width = 1ull << (msb - 3);
+    return ((kSubBuckets + sub) << (msb - 3)) + width - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t us) {
+    ++m_buckets[bucketFor(us)];
+    ++m_count;
+    m_max = std::max(m_max, us);
+}
+
+void LatencyHistogram::reset() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    if (m_count == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(m_count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) return std::min(bucketUpperBound(i), m_max);
+    }
+    return m_max;
+}
+
+// ============================================================================
+// LatencyTracer
+// ============================================================================
+
+namespace {
+
+bool slowerFirst(const LatencyTracer::Sample& a, const LatencyTracer::Sample& b) { return a.us > b.us; }
+
+const char* typeName(EntityType type) {
+    switch (type) {
+        case EntityType::Unknown: return "Unknown";
+        case EntityType::Box: return "Box";
+        case EntityType::Sphere: return "Sphere";
+        case EntityType::Model: return "Model";
+        case EntityType::Shape: return "Shape";
+        case EntityType::Light: return "Light";
+        case EntityType::Text: return "Text";
+        case EntityType::Zone: return "Zone";
+        case EntityType::Web: return "Web";
+        case EntityType::ParticleEffect: return "ParticleEffect";
+        case EntityType::Line: return "Line";
+        case EntityType::PolyLine: return "PolyLine";
+        case EntityType::Grid: return "Grid";
+        case EntityType::Gizmo: return "Gizmo";
+        case EntityType::Material: return "Material";
+    }
+    return "?";
+}
+
+} // anonymous namespace
+
+void LatencyTracer::record(EntityType type, std::chrono::steady_clock::duration latency, const EntityUuid& id) {
+    const auto us = static_cast<std::uint64_t>(
+        std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+    m_byType[static_cast<std::size_t>(type)].record(us);
+
+    // Keep the N slowest: the heap top is the fastest of them
+    if (m_slowest.size() < kSlowestKept) {
+        m_slowest.push_back({us, type, id});
+        std::push_heap(m_slowest.begin(), m_slowest.end(), slowerFirst);
+    } else if (us > m_slowest.front().us) {
+        std::pop_heap(m_slowest.begin(), m_slowest.end(), slowerFirst);
+        m_slowest.back() = {us, type, id};
+        std::push_heap(m_slowest.begin(), m_slowest.end(), slowerFirst);
+    }
+}
+
+std::vector<LatencyTracer::Sample> LatencyTracer::slowest() const {
+    std::vector<Sample> out = m_slowest;
+    std::sort(out.begin(), out.end(), slowerFirst);
+    return out;
+}
+
+void LatencyTracer::report(std::ostream& out) {
+    for (std::size_t t = 0; t < kTypeCount; ++t) {
+        const auto& h = m_byType[t];
+        if (h.count() == 0) continue;
+        out << "[LatencyTrace] " << typeName(static_cast<EntityType>(t)) << ": n=" << h.count()
+            << " p50=" << h.percentile(0.5) << "us p99=" << h.percentile(0.99) << "us max=" << h.max() << "us\n";
+    }
+    for (const auto& s : slowest()) {
+        out << "[LatencyTrace]   slow: " << s.us << "us " << typeName(s.type) << " " << s.id.toString() << "\n";
+    }
+    out.flush();
+    reset();
+}
+
+void LatencyTracer::reset() {
+    for (auto& h : m_byType) h.reset();
+    m_slowest.clear();
+}
@@ -0,0 +1,68 @@
+// LatencyTracer.hpp
+// Network-to-compositor latency of entity updates.
+//
+// Every entity change carries the receive time of its packet (kernel
+// SO_TIMESTAMPNS where available). SceneSync records "now - rxTime" right
+// after handing the change to the bridge. Samples go into a log-linear
+// histogram per entity type (8 sub-buckets per power of two, ~12% relative
+// error) and the slowest few of the current window are kept for logging.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "EntityStore.hpp"
+
+class LatencyHistogram {
+public:
+	void record(std::uint64_t us);
+	void reset();
+
+	std::uint64_t count() const { return m_count; }
+	std::uint64_t max() const { return m_max; }
+	// Upper bound of the bucket holding the p-th percentile (p in [0, 1]),
+	// clamped to the largest sample seen.
+	std::uint64_t percentile(double p) const;
+
+	static std::size_t bucketFor(std::uint64_t us);
+	static std::uint64_t bucketUpperBound(std::size_t bucket);
+
+private:
+	static constexpr std::size_t kSubBuckets = 8;
+	static constexpr std::size_t kBuckets = 30 * kSubBuckets; // up to 2^32 us
+
+	std::array<std::uint32_t, kBuckets> m_buckets{};
+	std::uint64_t m_count{0};
+	std::uint64_t m_max{0};
+};
+
+class LatencyTracer {
+public:
+	static constexpr std::size_t kTypeCount = static_cast<std::size_t>(EntityType::Material) + 1;
+	static constexpr std::size_t kSlowestKept = 10;
+
+	struct Sample {
+		std::uint64_t us;
+		EntityType type;
+		EntityUuid id;
+	};
+
+	void record(EntityType type, std::chrono::steady_clock::duration latency, const EntityUuid& id);
+
+	const LatencyHistogram& histogram(EntityType type) const { return m_byType[static_cast<std::size_t>(type)]; }
+	// Slowest samples of the current window, slowest first.
+	std::vector<Sample> slowest() const;
+
+	// Print p50/p99/max for every type with samples and the slowest updates,
+	// then start a new window.
+	void report(std::ostream& out);
+	void reset();
+
+private:
+	std::array<LatencyHistogram, kTypeCount> m_byType;
+	std::vector<Sample> m_slowest; // min-heap on us, at most kSlowestKept
+};
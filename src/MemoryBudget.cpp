@@ -0,0 +1,153 @@
+// MemoryBudget.cpp
+#include "MemoryBudget.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+std::array<std::atomic<std::int64_t>, static_cast<std::size_t>(MemoryBudget::Subsystem::Count)> MemoryBudget::s_bytes{};
+
+namespace {
+
+constexpr std::chrono::seconds kShedInterval{1};
+constexpr std::chrono::seconds kMaxShedInterval{32};
+
+const char* pressureName(MemoryBudget::Pressure p) {
+    switch (p) {
+        case MemoryBudget::Pressure::None: return "none";
+        case MemoryBudget::Pressure::Soft: return "soft";
+        case MemoryBudget::Pressure::Hard: return "hard";
+    }
+    return "?";
+}
+
+std::string formatBytes(std::size_t bytes) {
+    char buf[32];
+    if (bytes >= 1024 * 1024) {
+        std::snprintf(buf, sizeof(buf), "%.1f MB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    } else {
+        std::snprintf(buf, sizeof(buf), "%zu KB", bytes / 1024);
+    }
+    return buf;
+}
+
+} // namespace
+
+MemoryBudget& MemoryBudget::instance() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+MemoryBudget::MemoryBudget() : m_budget(budgetFromEnv()) {
+    if (m_budget > 0) {
+        std::cout << "[MemoryBudget] Budget " << formatBytes(m_budget) << " (soft watermark "
+                  << formatBytes(softLimit()) << ")" << std::endl;
+    }
+}
+
+std::size_t MemoryBudget::budgetFromEnv() {
+    if (const char* env = std::getenv("STARWORLD_MEMORY_BUDGET_MB")) {
+        const long long mb = std::atoll(env);
+        if (mb > 0) return static_cast<std::size_t>(mb) * 1024 * 1024;
+    }
+    return 0;
+}
+
+std::size_t MemoryBudget::total() {
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < s_bytes.size(); ++i) sum += bytes(static_cast<Subsystem>(i));
+    return sum;
+}
+
+const char* MemoryBudget::name(Subsystem s) {
+    switch (s) {
+        case Subsystem::Entities: return "Entities";
+        case Subsystem::UpdateQueues: return "UpdateQueues";
+        case Subsystem::PacketBuffers: return "PacketBuffers";
+        case Subsystem::ModelCache: return "ModelCache";
+        case Subsystem::BridgeNodes: return "BridgeNodes";
+        case Subsystem::Arenas: return "Arenas";
+        case Subsystem::Count: break;
+    }
+    return "?";
+}
+
+std::string MemoryBudget::report() {
+    std::string out;
+    for (std::size_t i = 0; i < s_bytes.size(); ++i) {
+        const auto s = static_cast<Subsystem>(i);
+        if (!out.empty()) out += ", ";
+        out += name(s);
+        out += ' ';
+        out += formatBytes(bytes(s));
+    }
+    return out;
+}
+
+void MemoryBudget::setBudget(std::size_t bytes) {
+    m_budget = bytes;
+}
+
+MemoryBudget::Pressure MemoryBudget::pressure() const {
+    if (m_budget == 0) return Pressure::None;
+    const std::size_t used = total();
+    if (used > m_budget) return Pressure::Hard;
+    if (used > softLimit()) return Pressure::Soft;
+    return Pressure::None;
+}
+
+int MemoryBudget::addShedder(std::string name, Pressure level, Shedder shedder) {
+    const int id = m_nextId++;
+    m_shedders.push_back(Entry{id, std::move(name), level, std::move(shedder)});
+    return id;
+}
+
+void MemoryBudget::removeShedder(int id) {
+    for (auto it = m_shedders.begin(); it != m_shedders.end(); ++it) {
+        if (it->id == id) {
+            m_shedders.erase(it);
+            return;
+        }
+    }
+}
+
+std::size_t MemoryBudget::relieve(Clock::time_point now) {
+    const Pressure level = pressure();
+    if (level != m_logged) {
+        std::cout << "[MemoryBudget] Pressure " << pressureName(m_logged) << " -> " << pressureName(level) << ": "
+                  << formatBytes(total()) << " of " << formatBytes(m_budget) << " (" << report() << ")" << std::endl;
+        m_logged = level;
+    }
+    if (level == Pressure::None) {
+        m_shedInterval = kShedInterval;
+        return 0;
+    }
+    if (now - m_lastShed < m_shedInterval) return 0;
+    m_lastShed = now;
+
+    const std::size_t before = total();
+    // Cheap shedders first, lossy ones only if those were not enough
+    for (Pressure pass : {Pressure::Soft, Pressure::Hard}) {
+        if (pass > level) break;
+        for (std::size_t i = 0; i < m_shedders.size() && pressure() != Pressure::None; ++i) {
+            if (m_shedders[i].level != pass) continue;
+            const std::size_t start = total();
+            m_shedders[i].shed(level);
+            const std::size_t after = total();
+            if (after < start) {
+                std::cout << "[MemoryBudget] " << m_shedders[i].name << " freed " << formatBytes(start - after) << std::endl;
+            }
+        }
+        if (pressure() == Pressure::None) break;
+    }
+    const std::size_t after = total();
+    const std::size_t freed = before > after ? before - after : 0;
+    // Still over and under 1/16 of the total freed: the owners hold what
+    // they use, so back off rather than copy it all again next second
+    if (pressure() != Pressure::None && freed < before / 16) {
+        m_shedInterval = std::min<Clock::duration>(m_shedInterval * 2, kMaxShedInterval);
+    } else {
+        m_shedInterval = kShedInterval;
+    }
+    return freed;
+}
@@ -0,0 +1,167 @@
+// MemoryBudget.hpp
+// Per-subsystem byte accounting and a process-wide budget with shedders.
+//
+// The big containers of each subsystem (entity store, update queues, packet
+// buffers, ModelCache bookkeeping, the bridge's node table) allocate through
+// TrackingAllocator, which adds every allocation to its subsystem's counter;
+// FrameArena books its buffers itself.
+// Only container storage is counted, not heap memory owned by the elements
+// (e.g. the characters of a std::string key), so the figures are a lower
+// bound that tracks growth with the world.
+//
+// The budget (STARWORLD_MEMORY_BUDGET_MB, unset or 0 = account only) has two
+// watermarks: above the soft one (3/4 of the budget) the cheap shedders run,
+// above the hard one (the budget itself) the lossy ones run too. The only
+// lossy one, SceneSync's far-model unbinding, frees compositor memory that
+// is not tracked here, so it is best effort rather than counted relief. Shedders run
+// from relieve() on the main thread, in registration order within a level,
+// until the tracked total is back under the soft watermark. A round that
+// frees little doubles the wait before the next one (up to half a minute),
+// so shedders whose owners grow straight back are not rerun every second.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MemoryBudget {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Subsystem : std::uint8_t {
+		Entities,       // EntityStore slots and UUID index
+		UpdateQueues,   // SceneSync's carry-over queue
+		PacketBuffers,  // Bulk receive lane
+		ModelCache,     // Download bookkeeping (not the files)
+		BridgeNodes,    // StardustBridge node table
+		Arenas,         // FrameArena buffers
+		Count
+	};
+
+	enum class Pressure : std::uint8_t {
+		None,
+		Soft,  // Over the soft watermark: release what is cheap to rebuild
+		Hard   // Over the budget: also give up detail
+	};
+
+	// Runs on the main thread from relieve(). The budget measures what it
+	// freed from the tracked counters.
+	using Shedder = std::function<void(Pressure)>;
+
+	static MemoryBudget& instance();
+
+	// STARWORLD_MEMORY_BUDGET_MB, in bytes (0 = no budget).
+	static std::size_t budgetFromEnv();
+
+	// Called by TrackingAllocator; safe from any thread.
+	static void add(Subsystem s, std::size_t bytes) {
+		s_bytes[static_cast<std::size_t>(s)].fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+	}
+	static void sub(Subsystem s, std::size_t bytes) {
+		s_bytes[static_cast<std::size_t>(s)].fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+	}
+	static std::size_t bytes(Subsystem s) {
+		return static_cast<std::size_t>(std::max<std::int64_t>(0, s_bytes[static_cast<std::size_t>(s)].load(std::memory_order_relaxed)));
+	}
+	static std::size_t total();
+	static const char* name(Subsystem s);
+
+	// Budget in bytes; 0 disables shedding (accounting continues).
+	void setBudget(std::size_t bytes);
+	std::size_t budget() const { return m_budget; }
+	std::size_t softLimit() const { return m_budget / 4 * 3; }
+	Pressure pressure() const;
+
+	// Register a shedder that runs at `level` and above. Returns a handle for
+	// removeShedder(); owners remove theirs before they go away.
+	int addShedder(std::string name, Pressure level, Shedder shedder);
+	void removeShedder(int id);
+
+	// Call once per frame. Logs pressure changes and runs the shedders while
+	// over the soft watermark (at most once per second, since freed memory
+	// is only seen once the owners have shrunk, and less often after rounds
+	// that freed little). Returns bytes freed.
+	std::size_t relieve(Clock::time_point now);
+
+	// "Entities 1.2 MB, UpdateQueues 40 KB, ..." for logs
+	static std::string report();
+
+private:
+	MemoryBudget();
+
+	struct Entry {
+		int id;
+		std::string name;
+		Pressure level;
+		Shedder shed;
+	};
+
+	static std::array<std::atomic<std::int64_t>, static_cast<std::size_t>(Subsystem::Count)> s_bytes;
+
+	std::size_t m_budget{0};
+	std::vector<Entry> m_shedders;
+	int m_nextId{1};
+	Pressure m_logged{Pressure::None};
+	Clock::time_point m_lastShed{};
+	Clock::duration m_shedInterval{std::chrono::seconds(1)};
+};
+
+// std::allocator that books its allocations to one MemoryBudget subsystem.
+template <typename T, MemoryBudget::Subsystem S>
+struct TrackingAllocator {
+	using value_type = T;
+	template <typename U>
+	struct rebind {
+		using other = TrackingAllocator<U, S>;
+	};
+
+	TrackingAllocator() noexcept = default;
+	template <typename U>
+	TrackingAllocator(const TrackingAllocator<U, S>&) noexcept {}
+
+	T* allocate(std::size_t n) {
+		T* p = std::allocator<T>{}.allocate(n);
+		MemoryBudget::add(S, n * sizeof(T));
+		return p;
+	}
+	void deallocate(T* p, std::size_t n) noexcept {
+		MemoryBudget::sub(S, n * sizeof(T));
+		std::allocator<T>{}.deallocate(p, n);
+	}
+
+	template <typename U>
+	bool operator==(const TrackingAllocator<U, S>&) const noexcept { return true; }
+	template <typename U>
+	bool operator!=(const TrackingAllocator<U, S>&) const noexcept { return false; }
+};
+
+template <typename T, MemoryBudget::Subsystem S>
+using TrackedVector = std::vector<T, TrackingAllocator<T, S>>;
+
+template <typename K, typename V, MemoryBudget::Subsystem S, typename Hash = std::hash<K>>
+using TrackedMap = std::unordered_map<K, V, Hash, std::equal_to<K>, TrackingAllocator<std::pair<const K, V>, S>>;
+
+// Whether a container holding `size` elements in room for `capacity` has
+// enough spare to be worth copying down: more than half its size again, so
+// one that would regrow on its next few inserts is left alone.
+inline bool worthShrinking(std::size_t capacity, std::size_t size) {
+	return capacity * 2 > size * 3;
+}
+
+// Release a tracked (or plain) vector's spare capacity for real; unlike
+// shrink_to_fit this is not just a request. Vectors with little spare are
+// left as they are (see worthShrinking).
+template <typename Vec>
+void releaseSpare(Vec& v) {
+	if (!worthShrinking(v.capacity(), v.size())) return;
+	Vec(std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()), v.get_allocator()).swap(v);
+}
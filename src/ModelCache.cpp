@@ -1,12 +1,15 @@
 // ModelCache.cpp
 #include "ModelCache.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <thread>
+#include <utility>
 
 #include <curl/curl.h>
 #include <openssl/sha.h>
@@ -67,6 +70,9 @@ ModelCache& ModelCache::instance() {
 ModelCache::ModelCache() {
     // Initialize libcurl globally
     curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    MemoryBudget::instance().addShedder("ModelCache metadata", MemoryBudget::Pressure::Soft,
+                                        [this](MemoryBudget::Pressure) { shedMetadata(); });
     
     // Set default cache directory: ~/.cache/starworld/models/
     const char* home = std::getenv("HOME");
@@ -88,6 +94,7 @@ ModelCache::ModelCache() {
 void ModelCache::setCacheDirectory(const fs::path& dir) {
     std::lock_guard<std::mutex> lock(mutex_);
     cacheDir_ = dir;
+    resolved_.clear();
     try {
         fs::create_directories(cacheDir_);
     } catch (const fs::filesystem_error& e) {
@@ -96,31 +103,49 @@ void ModelCache::setCacheDirectory(const fs::path& dir) {
 }
 
 std::string ModelCache::urlToFilename(const std::string& url) const {
+    // atp://<sha256>.<ext> names its content: look in the asset store
+    if (url.rfind("atp:", 0) == 0) {
+        std::string rest = url.substr(4);
+        if (rest.rfind("//", 0) == 0) rest.erase(0, 2);
+        const bool direct = rest.size() >= 64 && (rest.size() == 64 || rest[64] == '.') &&
+            rest.find_first_not_of("0123456789abcdefABCDEF") >= 64;
+        if (direct) {
+            // AssetClient names stored files with lowercase hex
+            std::transform(rest.begin(), rest.begin() + 64, rest.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return (fs::path("atp") / rest).string();
+        }
+    }
+
     // Hash the URL to get a unique filename
     std::string hash = sha256(url);
     std::string ext = getExtensionFromUrl(url);
     return hash + ext;
 }
 
+std::string ModelCache::lookupCachedLocked(const std::string& url) const {
+    std::error_code ec;
+    auto it = resolved_.find(url);
+    if (it != resolved_.end()) {
+        // Still one stat, but no hash; a file removed behind our back
+        // (cache cleanup, another instance) drops out of the memo
+        if (fs::is_regular_file(it->second, ec)) return it->second;
+        resolved_.erase(it);
+    }
+
+    fs::path localPath = cacheDir_ / urlToFilename(url);
+    if (!fs::is_regular_file(localPath, ec)) return "";
+    return resolved_.emplace(url, localPath.string()).first->second;
+}
+
 bool ModelCache::isCached(const std::string& url) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::string filename = urlToFilename(url);
-    fs::path localPath = cacheDir_ / filename;
-    
-    return fs::exists(localPath) && fs::is_regular_file(localPath);
+    return !lookupCachedLocked(url).empty();
 }
 
 std::string ModelCache::getCachedPath(const std::string& url) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::string filename = urlToFilename(url);
-    fs::path localPath = cacheDir_ / filename;
-    
-    if (fs::exists(localPath) && fs::is_regular_file(localPath)) {
-        return localPath.string();
-    }
-    return "";
+    return lookupCachedLocked(url);
 }
 
 ModelCache::State ModelCache::getState(const std::string& url) const {
@@ -135,22 +160,32 @@ ModelCache::State ModelCache::getState(const std::string& url) const {
 
 void ModelCache::requestModel(const std::string& url, 
                               CompletionCallback onComplete,
-                              ProgressCallback onProgress) {
-    // Check if already cached
-    if (isCached(url)) {
-        std::string cachedPath = getCachedPath(url);
-        std::cout << "[ModelCache] Using cached model: " << url << " -> " << cachedPath << std::endl;
-        if (onComplete) {
-            onComplete(url, true, cachedPath);
-        }
-        return;
-    }
-
+                              ProgressCallback onProgress,
+                              const std::string& atpDomain) {
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // Already cached: one memo lookup (first time: one hash + stat)
+        const bool known = resolved_.count(url) != 0;
+        const std::string cachedPath = lookupCachedLocked(url);
+        if (!cachedPath.empty()) {
+            lock.unlock();
+            if (!known) {
+                std::cout << "[ModelCache] Using cached model: " << url << " -> " << cachedPath << std::endl;
+            }
+            if (onComplete) {
+                onComplete(url, true, cachedPath);
+            }
+            return;
+        }
         
-        // Check if download is already in progress
+        // Check if download is already in progress. A finished entry without
+        // a file (it failed, or the file has gone since) is started over.
         auto it = resources_.find(url);
+        if (it != resources_.end() && it->second->state != State::Downloading) {
+            resources_.erase(it);
+            it = resources_.end();
+        }
         if (it != resources_.end()) {
             // Download already in progress, just add callbacks
             if (onComplete) {
@@ -179,6 +214,14 @@ void ModelCache::requestModel(const std::string& url,
         }
     }
 
+    // atp:// goes through the domain's asset server (see AssetClient)
+    if (url.rfind("atp:", 0) == 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        atpPending_[atpDomain].push_back(url);
+        std::cout << "[ModelCache] Queued for the asset server of " << atpDomain << ": " << url << std::endl;
+        return;
+    }
+
     // Start download in background thread
     std::cout << "[ModelCache] Starting download: " << url << std::endl;
     std::thread([this, url]() {
@@ -286,6 +329,9 @@ void ModelCache::onDownloadComplete(const std::string& url, bool success, const
                 it->second->errorMessage = error;
             }
             localPath = it->second->localPath.string();
+            if (success) {
+                resolved_[url] = localPath;
+            }
         }
         
         // Get callbacks
@@ -307,6 +353,46 @@ void ModelCache::onDownloadComplete(const std::string& url, bool success, const
     }
 }
 
+std::vector<std::string> ModelCache::takeAtpRequests(const std::string& domain) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = atpPending_.find(domain);
+    if (it == atpPending_.end()) return {};
+    std::vector<std::string> urls = std::move(it->second);
+    atpPending_.erase(it);
+    return urls;
+}
+
+void ModelCache::completeAtpRequest(const std::string& url, bool success, const std::string& localPath) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = resources_.find(url);
+        if (it != resources_.end() && success) {
+            it->second->localPath = localPath;
+        }
+    }
+    onDownloadComplete(url, success, success ? "" : "asset server download failed");
+}
+
+void ModelCache::shedMetadata() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = resources_.begin(); it != resources_.end();) {
+        const State state = it->second->state;
+        if (state == State::Completed || state == State::Failed) {
+            it = resources_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    decltype(resolved_)().swap(resolved_);
+    // Rehash into a table sized for what is left
+    resources_.rehash(0);
+}
+
+fs::path ModelCache::getAtpStoreDirectory() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cacheDir_ / "atp";
+}
+
 void ModelCache::clearCache() {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -323,6 +409,8 @@ void ModelCache::clearCache() {
     }
     
     resources_.clear();
+    resolved_.clear();
+    atpPending_.clear();
     completionCallbacks_.clear();
     progressCallbacks_.clear();
 }
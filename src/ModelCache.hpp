@@ -1,5 +1,8 @@
 // ModelCache.hpp
-// Manages downloading and caching of 3D models from HTTP/HTTPS URLs
+// Manages downloading and caching of 3D models from HTTP/HTTPS URLs.
+// atp:// URLs are queued for an Overte AssetClient instead (takeAtpRequests /
+// completeAtpRequest), per domain since each has its own asset server; their
+// files live in the content-addressed atp/ store.
 #pragma once
 
 #include <string>
@@ -8,6 +11,9 @@
 #include <memory>
 #include <mutex>
 #include <filesystem>
+#include <vector>
+
+#include "MemoryBudget.hpp"
 
 namespace fs = std::filesystem;
 
@@ -36,9 +42,11 @@ public:
 
     // Request a model from URL. If already cached, returns path immediately via callback.
     // Otherwise, starts download and calls callback when complete.
+    // `atpDomain` names the domain whose asset server serves an atp:// URL.
     void requestModel(const std::string& url, 
                       CompletionCallback onComplete,
-                      ProgressCallback onProgress = nullptr);
+                      ProgressCallback onProgress = nullptr,
+                      const std::string& atpDomain = {});
 
     // Synchronous check if model is already cached
     bool isCached(const std::string& url) const;
@@ -56,6 +64,18 @@ public:
     void setCacheDirectory(const fs::path& dir);
     fs::path getCacheDirectory() const { return cacheDir_; }
 
+    // atp:// downloads: requested URLs wait here until the session of their
+    // domain has an asset server and takes them, and report back through
+    // completeAtpRequest.
+    std::vector<std::string> takeAtpRequests(const std::string& domain);
+    void completeAtpRequest(const std::string& url, bool success, const std::string& localPath);
+    // Content-addressed store for atp:// assets (<cache>/atp/<sha256><ext>)
+    fs::path getAtpStoreDirectory() const;
+
+    // Forget finished requests and the cached-path memo (memory pressure).
+    // Files stay on disk; the next request for them stats the file again.
+    void shedMetadata();
+
 private:
     ModelCache();
     ~ModelCache() = default;
@@ -64,6 +84,12 @@ private:
 
     // Generate cache filename from URL (using hash)
     std::string urlToFilename(const std::string& url) const;
+
+    // Local path of a cached URL, or empty. Answers from resolved_ when the
+    // file is still there (one stat, no hash), dropping the entry if not;
+    // otherwise hashes the URL and stats the file, memoizing a hit. Caller
+    // holds mutex_.
+    std::string lookupCachedLocked(const std::string& url) const;
     
     // Start actual download (runs in background thread)
     void startDownload(const std::string& url);
@@ -73,9 +99,18 @@ private:
 
     mutable std::mutex mutex_;
     fs::path cacheDir_;
-    std::unordered_map<std::string, std::shared_ptr<ModelResource>> resources_;
+    template <typename V>
+    using Map = TrackedMap<std::string, V, MemoryBudget::Subsystem::ModelCache>;
+
+    Map<std::shared_ptr<ModelResource>> resources_;
+
+    // URL -> local path of files known to be in the cache (in-memory memo)
+    mutable Map<std::string> resolved_;
+
+    // Domain -> atp:// URLs not yet taken by its asset client
+    Map<std::vector<std::string>> atpPending_;
     
     // Callbacks stored per URL
-    std::unordered_map<std::string, std::vector<CompletionCallback>> completionCallbacks_;
-    std::unordered_map<std::string, std::vector<ProgressCallback>> progressCallbacks_;
+    Map<std::vector<CompletionCallback>> completionCallbacks_;
+    Map<std::vector<ProgressCallback>> progressCallbacks_;
 };
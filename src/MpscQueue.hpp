@@ -0,0 +1,66 @@
+// MpscQueue.hpp
+// Lock-free multi-producer / single-consumer queue.
+//
+// Producers push with one CAS onto an intrusive stack; the consumer takes the
+// whole stack with one exchange and reverses it, so drain() yields items in
+// push order (per producer) without ever blocking a producer.
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+template <typename T>
+class MpscQueue {
+public:
+	MpscQueue() = default;
+	~MpscQueue() {
+		Node* n = m_head.exchange(nullptr, std::memory_order_acquire);
+		while (n) {
+			Node* next = n->next;
+			delete n;
+			n = next;
+		}
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	// Any thread.
+	void push(T value) {
+		Node* n = new Node{std::move(value), m_head.load(std::memory_order_relaxed)};
+		while (!m_head.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed)) {
+		}
+	}
+
+	// Consumer thread only. Calls fn(T&&) for every item pushed so far, oldest first.
+	template <typename Fn>
+	std::size_t drain(Fn&& fn) {
+		Node* n = m_head.exchange(nullptr, std::memory_order_acquire);
+		Node* reversed = nullptr;
+		while (n) {
+			Node* next = n->next;
+			n->next = reversed;
+			reversed = n;
+			n = next;
+		}
+		std::size_t count = 0;
+		while (reversed) {
+			Node* next = reversed->next;
+			fn(std::move(reversed->value));
+			delete reversed;
+			reversed = next;
+			++count;
+		}
+		return count;
+	}
+
+	bool empty() const { return m_head.load(std::memory_order_acquire) == nullptr; }
+
+private:
+	struct Node {
+		T value;
+		Node* next;
+	};
+
+	std::atomic<Node*> m_head{nullptr};
+};
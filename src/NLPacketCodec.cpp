@@ -3,9 +3,6 @@
 #include <arpa/inet.h>
 #include <cstring>
 #include <string>
-#include <openssl/md5.h>
-#include <openssl/hmac.h>
-#include <openssl/evp.h>
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
@@ -23,12 +20,17 @@ constexpr uint32_t MESSAGE_BIT_MASK = 0x20000000;      // Bit 29
 constexpr uint32_t OBFUSCATION_MASK = 0x18000000;      // Bits 27-28
 constexpr uint32_t SEQUENCE_NUMBER_MASK = 0x07FFFFFF;  // Bits 0-26
 
+// Message number field: position (ONLY/LAST/FIRST/MIDDLE) in bits 30-31
+constexpr uint32_t MESSAGE_POSITION_OFFSET = 30;
+constexpr uint32_t MESSAGE_NUMBER_MASK = 0x3FFFFFFF;
+
 } // anonymous namespace
 
-NLPacket::NLPacket(PacketType type, PacketVersion version, bool isReliable)
+NLPacket::NLPacket(PacketType type, PacketVersion version, bool isReliable, std::pmr::memory_resource* memory)
     : m_type(type)
     , m_version(version)
     , m_isReliable(isReliable)
+    , m_data(memory)
 {
     // Determine header size (sourced packets have LocalID)
     m_isSourced = false;  // Most client packets aren't sourced
@@ -47,11 +49,25 @@ void NLPacket::writeHeader() {
     if (m_isReliable) {
         seqAndFlags |= RELIABLE_BIT_MASK;
     }
+    if (m_isMessage) {
+        seqAndFlags |= MESSAGE_BIT_MASK;
+    }
     // Convert to network byte order
     uint32_t netSeqAndFlags = htonl(seqAndFlags);
     std::memcpy(m_data.data() + offset, &netSeqAndFlags, sizeof(uint32_t));
     offset += sizeof(uint32_t);
     
+    // Message number (position in the top two bits) and part number
+    if (m_isMessage) {
+        uint32_t netNumber = htonl((m_messageNumber & MESSAGE_NUMBER_MASK) |
+                                   (static_cast<uint32_t>(m_messagePosition) << MESSAGE_POSITION_OFFSET));
+        std::memcpy(m_data.data() + offset, &netNumber, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+        uint32_t netPart = htonl(m_messagePart);
+        std::memcpy(m_data.data() + offset, &netPart, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+    }
+    
     // Write packet type
     m_data[offset++] = static_cast<uint8_t>(m_type);
     
@@ -72,6 +88,12 @@ void NLPacket::write(const void* data, size_t size) {
     m_data.insert(m_data.end(), bytes, bytes + size);
 }
 
+uint8_t* NLPacket::extend(size_t size) {
+    const size_t at = m_data.size();
+    m_data.resize(at + size);
+    return m_data.data() + at;
+}
+
 void NLPacket::writeUInt8(uint8_t value) {
     m_data.push_back(value);
 }
@@ -115,51 +137,120 @@ void NLPacket::setSequenceNumber(SequenceNumber seq) {
 void NLPacket::setSourceID(LocalID id) {
     m_sourceID = id;
     m_isSourced = true;
-    // Resize if needed to sourced header (no hash - we don't have HMAC auth)
-    if (m_headerSize != SOURCED_HEADER_SIZE) {
-        m_headerSize = SOURCED_HEADER_SIZE;
+    // Resize if needed to sourced header (the hash is inserted by writeVerificationHash)
+    const size_t headerSize = SOURCED_HEADER_SIZE + (m_isMessage ? MESSAGE_HEADER_SIZE : 0);
+    if (m_headerSize != headerSize) {
+        m_headerSize = headerSize;
         m_data.resize(m_headerSize);
     }
     writeHeader();
 }
 
-void NLPacket::writeVerificationHash(const uint8_t* connectionSecretUUID) {
+void NLPacket::setMessage(uint32_t messageNumber, MessagePosition position, uint32_t part) {
+    m_isMessage = true;
+    m_messageNumber = messageNumber;
+    m_messagePosition = position;
+    m_messagePart = part;
+    const size_t headerSize = (m_isSourced ? SOURCED_HEADER_SIZE : BASE_HEADER_SIZE) + MESSAGE_HEADER_SIZE;
+    if (m_headerSize != headerSize) {
+        m_headerSize = headerSize;
+        m_data.resize(m_headerSize);
+    }
+    writeHeader();
+}
+
+void NLPacket::writeVerificationHash(const HmacMd5& key) {
     // HMAC-MD5 verification hash goes right after source ID
     // Packet structure for verified sourced packet:
-    // [seq+flags(4)] [type(1)] [version(1)] [sourceID(2)] [hash(16)] [payload...]
+    // [seq+flags(4)] [message fields(8), if any] [type(1)] [version(1)] [sourceID(2)] [hash(16)] [payload...]
     
     if (!m_isSourced) {
         std::cerr << "[NLPacket] Warning: Cannot write verification hash for non-sourced packet" << std::endl;
         return;
     }
     
-    const size_t HASH_SIZE = 16;  // MD5 produces 16 bytes
-    const size_t HASH_OFFSET = SOURCED_HEADER_SIZE;  // Hash goes right after source ID (offset 8)
+    const size_t HASH_SIZE = VERIFICATION_HASH_SIZE;  // MD5 produces 16 bytes
+    const size_t HASH_OFFSET = m_headerSize;  // Hash goes right after source ID
     
-    // The current packet structure is: [header(8)] [payload...]
-    // We need to insert 16 bytes for the hash between header and payload
-    // New structure will be: [header(8)] [hash(16)] [payload...]
-    
-    // Get the current payload (everything after the header)
-    std::vector<uint8_t> currentPayload(m_data.begin() + m_headerSize, m_data.end());
-    
-    // Resize packet to make room for hash
-    m_data.resize(m_headerSize + HASH_SIZE + currentPayload.size());
-    
-    // Move payload to after the hash slot
-    if (!currentPayload.empty()) {
-        std::memcpy(m_data.data() + HASH_OFFSET + HASH_SIZE, currentPayload.data(), currentPayload.size());
+    // Grow in place and slide the payload up past the hash slot
+    const size_t payloadSize = m_data.size() - m_headerSize;
+    m_data.resize(m_data.size() + HASH_SIZE);
+    uint8_t* payload = m_data.data() + HASH_OFFSET + HASH_SIZE;
+    if (payloadSize > 0) {
+        std::memmove(payload, m_data.data() + HASH_OFFSET, payloadSize);
     }
     
-    // Calculate HMAC-MD5 hash over the payload data
-    unsigned char hash[HASH_SIZE];
-    unsigned int hashLen = HASH_SIZE;
-    
-    // Use HMAC_MD5 with connection secret UUID as key
-    HMAC(EVP_md5(), connectionSecretUUID, 16, currentPayload.data(), currentPayload.size(), hash, &hashLen);
-    
-    // Write hash into the reserved slot
-    std::memcpy(m_data.data() + HASH_OFFSET, hash, HASH_SIZE);
+    // HMAC-MD5 over the payload, keyed with the connection secret
+    const HmacMd5::Digest hash = key.sign(payload, payloadSize);
+    std::memcpy(m_data.data() + HASH_OFFSET, hash.data(), HASH_SIZE);
+}
+
+void NLPacket::writeVerificationHash(const uint8_t* connectionSecretUUID) {
+    writeVerificationHash(HmacMd5(connectionSecretUUID, 16));
+}
+
+bool NLPacket::isSourcedType(PacketType type) {
+    switch (type) {
+        case PacketType::CreateAssignment:
+        case PacketType::RequestAssignment:
+        case PacketType::DomainServerRequireDTLS:
+        case PacketType::DomainConnectRequest:
+        case PacketType::DomainConnectRequestPending:
+        case PacketType::DomainList:
+        case PacketType::DomainConnectionDenied:
+        case PacketType::DomainServerPathQuery:
+        case PacketType::DomainServerPathResponse:
+        case PacketType::DomainServerAddedNode:
+        case PacketType::DomainServerConnectionToken:
+        case PacketType::DomainSettingsRequest:
+        case PacketType::DomainSettings:
+        case PacketType::OctreeDataFileRequest:
+        case PacketType::OctreeDataFileReply:
+        case PacketType::OctreeDataPersist:
+        case PacketType::DomainContentReplacementFromUrl:
+        case PacketType::ICEServerPeerInformation:
+        case PacketType::ICEServerQuery:
+        case PacketType::ICEServerHeartbeat:
+        case PacketType::ICEServerHeartbeatACK:
+        case PacketType::ICEServerHeartbeatDenied:
+        case PacketType::ICEPing:
+        case PacketType::ICEPingReply:
+        case PacketType::AssignmentClientStatus:
+        case PacketType::StopNode:
+        case PacketType::DomainServerRemovedNode:
+        case PacketType::UsernameFromIDReply:
+        case PacketType::OctreeFileReplacement:
+        case PacketType::ReplicatedMicrophoneAudioNoEcho:
+        case PacketType::ReplicatedMicrophoneAudioWithEcho:
+        case PacketType::ReplicatedInjectAudio:
+        case PacketType::ReplicatedSilentAudioFrame:
+        case PacketType::ReplicatedAvatarIdentity:
+        case PacketType::ReplicatedKillAvatar:
+        case PacketType::ReplicatedBulkAvatarData:
+        case PacketType::AvatarZonePresence:
+        case PacketType::WebRTCSignaling:
+            return false;
+        default:
+            return true;
+    }
+}
+
+bool NLPacket::isVerifiedType(PacketType type) {
+    if (!isSourcedType(type)) return false;
+    switch (type) {
+        case PacketType::NodeJsonStats:
+        case PacketType::EntityQuery:
+        case PacketType::OctreeDataNack:
+        case PacketType::EntityEditNack:
+        case PacketType::DomainListRequest:
+        case PacketType::DomainDisconnectRequest:
+        case PacketType::UsernameFromIDRequest:
+        case PacketType::NodeKickRequest:
+        case PacketType::NodeMuteRequest:
+            return false;
+        default:
+            return true;
+    }
 }
 
 bool NLPacket::parseHeader(const uint8_t* data, size_t size, Header& header) {
@@ -175,29 +266,47 @@ bool NLPacket::parseHeader(const uint8_t* data, size_t size, Header& header) {
     header.sequenceAndFlags = ntohl(netSeqAndFlags);
     offset += sizeof(uint32_t);
     
+    // Parts of ordered messages carry message and part numbers first
+    header.isMessage = (header.sequenceAndFlags & MESSAGE_BIT_MASK) != 0;
+    header.messageNumber = 0;
+    header.messagePosition = MessagePosition::Only;
+    header.messagePart = 0;
+    if (header.isMessage) {
+        if (size < BASE_HEADER_SIZE + MESSAGE_HEADER_SIZE) {
+            return false;
+        }
+        uint32_t netNumber;
+        std::memcpy(&netNumber, data + offset, sizeof(uint32_t));
+        const uint32_t number = ntohl(netNumber);
+        header.messageNumber = number & MESSAGE_NUMBER_MASK;
+        header.messagePosition = static_cast<MessagePosition>(number >> MESSAGE_POSITION_OFFSET);
+        uint32_t netPart;
+        std::memcpy(&netPart, data + offset + sizeof(uint32_t), sizeof(uint32_t));
+        header.messagePart = ntohl(netPart);
+        offset += MESSAGE_HEADER_SIZE;
+    }
+    
     // Read packet type
     header.type = static_cast<PacketType>(data[offset++]);
     
     // Read version
     header.version = data[offset++];
+    header.size = offset;
     
-    // Read source ID if present (check if packet is sourced)
-    if (size >= SOURCED_HEADER_SIZE) {
-        uint16_t netSourceID;
-        std::memcpy(&netSourceID, data + offset, sizeof(uint16_t));
-        header.sourceID = ntohs(netSourceID);
-    } else {
-        header.sourceID = NULL_LOCAL_ID;
-    }
+    // Read source ID if present (check if packet is sourced). Little-endian,
+    // as writeHeader() and Overte put it.
+    header.sourceID = NULL_LOCAL_ID;
+    Wire::Schema<Wire::U16LE>::decode(data + offset, size - offset, header.sourceID);
     
     return true;
 }
 
 PacketType NLPacket::getType(const uint8_t* data, size_t size) {
-    if (size < sizeof(uint32_t) + 1) {
+    Header header;
+    if (!parseHeader(data, size, header)) {
         return PacketType::Unknown;
     }
-    return static_cast<PacketType>(data[sizeof(uint32_t)]);
+    return header.type;
 }
 
 namespace {
@@ -5,10 +5,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <vector>
 #include <cstring>
 #include <string>
 
+#include "HmacMd5.hpp"
+#include "WireSchema.hpp"
+
 namespace Overte {
 
 // Packet types from Overte protocol
@@ -134,22 +138,41 @@ namespace PacketVersions {
     constexpr PacketVersion Ping_IncludeConnectionID = 18;
 }
 
+// Where a packet sits in a multi-packet (ordered) message
+enum class MessagePosition : uint8_t {
+    Only = 0,
+    Last = 1,
+    First = 2,
+    Middle = 3
+};
+
 // NLPacket structure (minimal implementation)
 class NLPacket {
 public:
     // Packet header components
     struct Header {
-        uint32_t sequenceAndFlags;  // Sequence number (29 bits) + flags (3 bits)
+        uint32_t sequenceAndFlags;  // Sequence number (27 bits) + flags (5 bits)
         PacketType type;
         PacketVersion version;
         LocalID sourceID;  // Only for sourced packets
+        // Message bit set: part `messagePart` of message `messageNumber`
+        bool isMessage{false};
+        uint32_t messageNumber{0};
+        MessagePosition messagePosition{MessagePosition::Only};
+        uint32_t messagePart{0};
+        size_t size{0};  // Bytes up to and including the version; a source ID follows
     };
     
     static constexpr LocalID NULL_LOCAL_ID = 0;
     static constexpr size_t BASE_HEADER_SIZE = sizeof(uint32_t) + sizeof(PacketType) + sizeof(PacketVersion);
     static constexpr size_t SOURCED_HEADER_SIZE = BASE_HEADER_SIZE + sizeof(LocalID);
+    static constexpr size_t MESSAGE_HEADER_SIZE = 2 * sizeof(uint32_t);  // Message number, part number
+    static constexpr size_t VERIFICATION_HASH_SIZE = 16;                 // HMAC-MD5
     
-    NLPacket(PacketType type, PacketVersion version = 0, bool isReliable = false);
+    // The packet's bytes are allocated from `memory`; with a FrameArena a
+    // packet built and sent within one Scope costs no heap allocation.
+    NLPacket(PacketType type, PacketVersion version = 0, bool isReliable = false,
+             std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     
     // Write data to packet payload
     void write(const void* data, size_t size);
@@ -158,9 +181,12 @@ public:
     void writeUInt32(uint32_t value);
     void writeUInt64(uint64_t value);
     void writeString(const std::string& str, bool nullTerminated = true);
+    // Grow the payload by `size` bytes and return where they start, for
+    // encoders that write in place (Wire::Schema::append)
+    uint8_t* extend(size_t size);
     
     // Get packet data for sending
-    const std::vector<uint8_t>& getData() const { return m_data; }
+    const std::pmr::vector<uint8_t>& getData() const { return m_data; }
     size_t getSize() const { return m_data.size(); }
     
     // Parse received packet
@@ -169,10 +195,20 @@ public:
     
     void setSequenceNumber(SequenceNumber seq);
     void setSourceID(LocalID id);
+    // Mark as part of an ordered message. Like setSourceID(), call before
+    // writing the payload.
+    void setMessage(uint32_t messageNumber, MessagePosition position, uint32_t part);
     
-    // Write HMAC-MD5 verification hash
+    // Write HMAC-MD5 verification hash. Keep an HmacMd5 per peer rather than
+    // passing the raw secret, which hashes the key pads again every packet.
+    void writeVerificationHash(const HmacMd5& key);
     void writeVerificationHash(const uint8_t* connectionSecretUUID);
     
+    // Overte's NON_SOURCED_PACKETS and NON_VERIFIED_PACKETS: whether packets
+    // of `type` carry a source ID, and whether a hash follows it
+    static bool isSourcedType(PacketType type);
+    static bool isVerifiedType(PacketType type);
+    
     // Protocol version signature
     static std::vector<uint8_t> computeProtocolVersionSignature();
     static uint8_t versionForPacketType(PacketType type);
@@ -186,9 +222,63 @@ private:
     LocalID m_sourceID{NULL_LOCAL_ID};
     bool m_isReliable;
     bool m_isSourced{false};
+    bool m_isMessage{false};
+    uint32_t m_messageNumber{0};
+    MessagePosition m_messagePosition{MessagePosition::Only};
+    uint32_t m_messagePart{0};
     
-    std::vector<uint8_t> m_data;
+    std::pmr::vector<uint8_t> m_data;
     size_t m_headerSize;
 };
 
+// Payload layouts of the packets we build and parse (see WireSchema.hpp)
+namespace Payload {
+    // Ping (IncludeConnectionID): ping type, sender's clock (us since epoch),
+    // sender's connection ID for the receiving node
+    using Ping = Wire::Schema<Wire::U8, Wire::U64LE, Wire::I64LE>;
+    static_assert(Ping::fixedSize == 17);
+    // PingReply: ping type and clock echoed from the Ping, then the
+    // replier's clock when it answered
+    using PingReply = Wire::Schema<Wire::U8, Wire::U64LE, Wire::U64LE>;
+    static_assert(PingReply::fixedSize == 17);
+
+    // OctreeQuery without frustums: connection ID, frustum count, max
+    // packets per second, octree scale, boundary level adjust, JSON size,
+    // query flags
+    using EntityQuery = Wire::Schema<Wire::U16, Wire::U8, Wire::I32, Wire::F32, Wire::I32, Wire::U16, Wire::U16>;
+    static_assert(EntityQuery::fixedSize == 19);
+
+    // EntityAdd: entity type, created and last edited (us since epoch), ID
+    // flags, then properties as [id:u16][value] up to PropertiesEnd
+    using EntityAddHeader = Wire::Schema<Wire::U8, Wire::U64, Wire::U64, Wire::U8>;
+    using TextProperty = Wire::Schema<Wire::U16, Wire::Utf8<Wire::U16>>;
+    using Vec3Property = Wire::Schema<Wire::U16, Wire::Vec3<Wire::F32>>;
+    using ColorProperty = Wire::Schema<Wire::U16, Wire::U8, Wire::U8, Wire::U8>;
+    using PropertiesEnd = Wire::Schema<Wire::U16>;
+
+    // AvatarIdentity (simplified): identity sequence, display name, avatar
+    // URL, skeleton model URL
+    using AvatarIdentity = Wire::Schema<Wire::U16, Wire::Utf8<Wire::U32>, Wire::Utf8<Wire::U32>, Wire::Utf8<Wire::U32>>;
+
+    // AvatarData with position and orientation only: sequence, hasFlags,
+    // global position, orientation (full floats)
+    using AvatarData = Wire::Schema<Wire::U16, Wire::U64, Wire::Vec3<Wire::F32>, Wire::QuatXYZW<Wire::F32>>;
+    static_assert(AvatarData::fixedSize == 38);
+
+    // DomainList header, read field by field since a short packet still
+    // carries our local ID: domain session UUID and local ID, our node UUID
+    // and local ID, permissions, authenticated, then three timestamps (us)
+    // and newConnection
+    using DomainListTimes = Wire::Schema<Wire::U64, Wire::U64, Wire::U64>;
+
+    // DomainList node entry (Node.cpp operator<<): type, UUID, public socket
+    // type and address protocol; an IPv4 address and port; the same for the
+    // local socket; then permissions, replicated, local ID and the
+    // connection secret
+    using NodeHead = Wire::Schema<Wire::U8, Wire::Uuid, Wire::U8, Wire::U8>;
+    using SocketV4 = Wire::Schema<Wire::U32, Wire::U16>;
+    using SocketHead = Wire::Schema<Wire::U8, Wire::U8>;
+    using NodeTail = Wire::Schema<Wire::U32, Wire::Bool, Wire::U16, Wire::Uuid>;
+}
+
 } // namespace Overte
@@ -1,18 +1,23 @@
 #include "OverteClient.hpp"
+#include "ModelCache.hpp"
+#include "MemoryBudget.hpp"
 #include "NLPacketCodec.hpp"
 #include "OverteAuth.hpp"
+#include "PacketLanes.hpp"
+#include "UdpReceive.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
 #include <cmath>
 #include <iostream>
 #include <random>
 #include <sstream>
 #include <iomanip>
+#include <utility>
 
-#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
-#include <glm/gtx/matrix_decompose.hpp>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -32,60 +37,34 @@ using namespace Overte;
 // Minimal QDataStream-like writer (Big Endian) for Qt wire format
 namespace {
 struct QtStream {
-    std::vector<uint8_t> buf;
-    void writeUInt8(uint8_t v) { buf.push_back(v); }
-    void writeUInt16BE(uint16_t v) {
-        buf.push_back(static_cast<uint8_t>((v >> 8) & 0xFF));
-        buf.push_back(static_cast<uint8_t>(v & 0xFF));
-    }
-    void writeUInt32BE(uint32_t v) {
-        buf.push_back(static_cast<uint8_t>((v >> 24) & 0xFF));
-        buf.push_back(static_cast<uint8_t>((v >> 16) & 0xFF));
-        buf.push_back(static_cast<uint8_t>((v >> 8) & 0xFF));
-        buf.push_back(static_cast<uint8_t>(v & 0xFF));
-    }
-    void writeUInt64BE(uint64_t v) {
-        for (int i = 7; i >= 0; --i) buf.push_back(static_cast<uint8_t>((v >> (i * 8)) & 0xFF));
-    }
-    void writeInt32BE(int32_t v) {
-        writeUInt32BE(static_cast<uint32_t>(v));
-    }
-    void writeBytes(const uint8_t* d, size_t n) { buf.insert(buf.end(), d, d + n); }
-    void writeQByteArray(const std::vector<uint8_t>& a) { writeUInt32BE(static_cast<uint32_t>(a.size())); writeBytes(a.data(), a.size()); }
-    void writeQByteArrayFromString(const std::string& s) { std::vector<uint8_t> v(s.begin(), s.end()); writeQByteArray(v); }
-    void writeQString(const std::string& s) {
-        // QDataStream QString: quint32 length (chars), then UTF-16 BE code units
-        writeUInt32BE(static_cast<uint32_t>(s.size()));
-        for (unsigned char c : s) { writeUInt16BE(static_cast<uint16_t>(c)); }
-    }
-    static bool parseHex(const std::string& hex, uint64_t& out, size_t digits) {
-        if (hex.size() < digits) return false; out = 0; for (size_t i = 0; i < digits; ++i) {
-            char ch = hex[i]; uint8_t val;
-            if (ch >= '0' && ch <= '9') val = ch - '0';
-            else if (ch >= 'a' && ch <= 'f') val = ch - 'a' + 10;
-            else if (ch >= 'A' && ch <= 'F') val = ch - 'A' + 10;
-            else return false; out = (out << 4) | val; }
-        return true;
-    }
-    void writeQUuidFromString(const std::string& uuid) {
-        // UUID string xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
-        std::string hex; hex.reserve(32);
-        for (char c : uuid) if (c != '-') hex.push_back(c);
-        if (hex.size() != 32) { // write zeros
-            for (int i = 0; i < 16; ++i) buf.push_back(0); return;
-        }
-        uint64_t d1=0,d2=0,d3=0; // using 64 for parse then cast
-        parseHex(hex.substr(0,8), d1, 8);
-        parseHex(hex.substr(8,4), d2, 4);
-        parseHex(hex.substr(12,4), d3, 4);
-        writeUInt32BE(static_cast<uint32_t>(d1));
-        writeUInt16BE(static_cast<uint16_t>(d2));
-        writeUInt16BE(static_cast<uint16_t>(d3));
-        // remaining 8 bytes
-        for (int i = 0; i < 8; ++i) {
-            uint64_t byteVal=0; parseHex(hex.substr(16 + i*2, 2), byteVal, 2);
-            writeUInt8(static_cast<uint8_t>(byteVal & 0xFF));
+    std::pmr::vector<uint8_t> buf;
+    explicit QtStream(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : buf(memory) {}
+    template <typename Field>
+    void put(const typename Field::value_type& v) { Wire::Schema<Field>::append(buf, v); }
+    void writeUInt8(uint8_t v) { put<Wire::U8>(v); }
+    void writeUInt16BE(uint16_t v) { put<Wire::U16>(v); }
+    void writeUInt32BE(uint32_t v) { put<Wire::U32>(v); }
+    void writeUInt64BE(uint64_t v) { put<Wire::U64>(v); }
+    void writeInt32BE(int32_t v) { put<Wire::I32>(v); }
+    void writeQByteArray(std::span<const uint8_t> a) { put<Wire::QByteArray>(a); }
+    void writeQString(std::string_view s) { put<Wire::QString>(s); }
+    void writeQUuidFromString(std::string_view uuid) {
+        // UUID string xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx; bytes in string order
+        auto nibble = [](char ch) -> uint8_t {
+            if (ch >= '0' && ch <= '9') return ch - '0';
+            if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+            if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+            return 0;
+        };
+        Wire::Uuid::value_type bytes{};
+        size_t digits = 0;
+        for (char c : uuid) {
+            if (c == '-') continue;
+            if (digits < 32) bytes[digits / 2] = static_cast<uint8_t>((bytes[digits / 2] << 4) | nibble(c));
+            ++digits;
         }
+        if (digits != 32) bytes.fill(0); // Malformed: write zeros
+        put<Wire::Uuid>(bytes);
     }
 };
 
@@ -147,14 +126,62 @@ static std::string generateUUID() {
     return ss.str();
 }
 
-OverteClient::OverteClient(std::string domainUrl)
-    : m_domainUrl(std::move(domainUrl)) {
+// Random first sequence number of a UDT connection
+static std::uint32_t randomSequence() {
+    std::random_device rd;
+    return rd() & UdtConnection::kSequenceMask;
+}
+
+OverteClient::OverteClient(std::string domainUrl, std::shared_ptr<EntityParsePipeline::WorkerPool> parseWorkers)
+    : m_domainUrl(std::move(domainUrl)),
+      m_parsePipeline(parseWorkers ? std::move(parseWorkers) : std::make_shared<EntityParsePipeline::WorkerPool>()) {
     // Initialize debug logging
     DebugLog::init();
+    if (const char* env = std::getenv("STARWORLD_INITIAL_LOAD_TIMEOUT_MS")) {
+        m_initialLoadTimeout = std::chrono::milliseconds(std::max(0, std::atoi(env)));
+    }
+    if (const char* env = std::getenv("STARWORLD_SNAPSHOT")) {
+        m_snapshotEnabled = std::string(env) != "0";
+    }
+    if (const char* env = std::getenv("STARWORLD_SNAPSHOT_INTERVAL_S")) {
+        m_snapshotInterval = std::chrono::seconds(std::max(1, std::atoi(env)));
+    }
+    if (const char* env = std::getenv("STARWORLD_BULK_BUDGET_US")) {
+        m_bulkBudgetTotal = std::chrono::microseconds(std::max(0, std::atoi(env)));
+    }
+    m_bulkBudget = m_bulkBudgetTotal;
+    m_link = SessionLink(SessionLink::timeoutFromEnv());
+    m_verifier.setChecking(PacketVerifier::checkingFromEnv());
+    if (!m_verifier.checking()) {
+        std::cout << "[OverteClient] Inbound packet verification off (STARWORLD_VERIFY_PACKETS=0)" << std::endl;
+    }
+    AssetClient::Config assetConfig;
+    assetConfig.storeDir = ModelCache::instance().getAtpStoreDirectory();
+    m_assets = std::make_unique<AssetClient>(
+        assetConfig, [this](PacketType type, const std::vector<std::uint8_t>& payload) {
+            sendAssetPacket(type, payload);
+        });
+    resetAssetLink();
+    m_shedder = MemoryBudget::instance().addShedder("Entity store and packet buffers", MemoryBudget::Pressure::Soft,
+                                                    [this](MemoryBudget::Pressure) { shrinkBuffers(); });
+    const auto now = std::chrono::steady_clock::now();
+    m_lastPing = m_lastDomainList = m_lastAvatarData = m_lastAvatarQuery = now;
+    m_simulationStart = now;
+}
+
+void OverteClient::setBudgetShare(double share) {
+    share = std::clamp(share, 0.0, 1.0);
+    m_entityRate.setBudget(EntityRateController::configFromEnv().budget * share);
+    m_bulkBudget = std::chrono::duration_cast<std::chrono::microseconds>(m_bulkBudgetTotal * share);
 }
 
 OverteClient::~OverteClient() {
-    // Destructor implementation
+    MemoryBudget::instance().removeShedder(m_shedder);
+    // Persist the final state; the writer's destructor waits for the write
+    if (m_snapshotWriter) {
+        m_snapshotDue = true;
+        captureSnapshot();
+    }
 }
 
 // Deprecated: Use OverteAuth directly from main.cpp and call setAuth()
@@ -180,8 +207,11 @@ bool OverteClient::isAuthenticated() const {
 }
 
 bool OverteClient::connect() {
-    // Generate session UUID
-    m_sessionUUID = generateUUID();
+    // One session UUID for the client's lifetime, so the domain can resume us
+    if (m_sessionUUID.empty()) m_sessionUUID = generateUUID();
+    // The session UUID survives a reconnect; a larger connection ID in our
+    // Pings tells Overte peers to reset what they kept of the old connection
+    ++m_pingConnectionId;
     std::cout << "[OverteClient] Session UUID: " << m_sessionUUID << std::endl;
     
     // Check for authentication credentials from environment
@@ -277,6 +307,9 @@ bool OverteClient::connect() {
             m_udpFd = ::socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
             if (m_udpFd == -1) continue;
             ::fcntl(m_udpFd, F_SETFL, O_NONBLOCK);
+            // Kernel receive times keep our frame loop out of PingReply RTTs
+            UdpReceive::enableTimestamps(m_udpFd);
+            UdpReceive::enableDropCounter(m_udpFd);
             
             // Bind to any local address/port so getsockname() works
             sockaddr_in bindAddr{};
@@ -290,6 +323,8 @@ bool OverteClient::connect() {
             std::memcpy(&m_udpAddr, rp->ai_addr, rp->ai_addrlen);
             m_udpAddrLen = rp->ai_addrlen;
             m_udpReady = true;
+            if (UdpRing::enabled()) m_domainRing = UdpRing::create(m_udpFd);
+            std::cout << "[OverteClient] Domain socket I/O: " << (m_domainRing ? "io_uring" : "recvmsg/sendto") << std::endl;
             std::cout << "[OverteClient] UDP socket ready for " << m_host << ":" << udpPort << std::endl;
             break;
         }
@@ -313,40 +348,39 @@ bool OverteClient::connect() {
     if (m_useSimulation) {
         // Seed a few demo entities with different types and properties
         OverteEntity cubeA;
-        cubeA.id = m_nextEntityId++;
-        cubeA.name = "CubeA";
+        cubeA.name = m_world.strings().acquire("CubeA");
         cubeA.type = EntityType::Box;
         cubeA.color = glm::vec3(1.0f, 0.3f, 0.3f); // Red cube
         cubeA.dimensions = glm::vec3(0.2f, 0.2f, 0.2f);
-        cubeA.transform = glm::translate(glm::mat4(1.0f), glm::vec3(-0.5f, 1.5f, -2.0f));
+        cubeA.position = glm::vec3(-0.5f, 1.5f, -2.0f);
         
         OverteEntity sphereB;
-        sphereB.id = m_nextEntityId++;
-        sphereB.name = "SphereB";
+        sphereB.name = m_world.strings().acquire("SphereB");
         sphereB.type = EntityType::Sphere;
         sphereB.color = glm::vec3(0.3f, 1.0f, 0.3f); // Green sphere
         sphereB.dimensions = glm::vec3(0.15f, 0.15f, 0.15f);
-        sphereB.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f, 1.5f, -2.0f));
+        sphereB.position = glm::vec3(0.5f, 1.5f, -2.0f);
         
         OverteEntity modelC;
-        modelC.id = m_nextEntityId++;
-        modelC.name = "ModelC";
+        modelC.name = m_world.strings().acquire("ModelC");
         modelC.type = EntityType::Model;
         modelC.color = glm::vec3(0.3f, 0.3f, 1.0f); // Blue tint
         modelC.dimensions = glm::vec3(0.25f, 0.25f, 0.25f);
         // Leave modelUrl empty - primitive will be used based on type
-        modelC.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.2f, -2.0f));
+        modelC.position = glm::vec3(0.0f, 1.2f, -2.0f);
         
-        m_entities.emplace(cubeA.id, cubeA);
-        m_entities.emplace(sphereB.id, sphereB);
-        m_entities.emplace(modelC.id, modelC);
-        m_updateQueue.push_back(cubeA.id);
-        m_updateQueue.push_back(sphereB.id);
-        m_updateQueue.push_back(modelC.id);
+        for (auto* demo : {&cubeA, &sphereB, &modelC}) {
+            const std::uint32_t slot = m_world.store().emplace(EntityUuid::fromCounter(m_nextEntityId++));
+            demo->id = m_world.store().at(slot).id;
+            demo->slot = slot;
+            m_world.store().at(slot) = *demo;
+            m_world.markUpdated(slot);
+        }
         std::cout << "[OverteClient] Simulation mode enabled (STARWORLD_SIMULATE=1) with 3 demo entities" << std::endl;
     } else {
         std::cout << "[OverteClient] Waiting for entity packets from Overte server..." << std::endl;
         std::cout << "[OverteClient] Tip: Set STARWORLD_SIMULATE=1 to enable demo entities" << std::endl;
+        if (m_snapshotEnabled) restoreSnapshot();
     }
     return true;
 }
@@ -368,6 +402,11 @@ bool OverteClient::connectEntityServer() {
     
     // Make non-blocking
     ::fcntl(m_entityFd, F_SETFL, O_NONBLOCK);
+    // Kernel receive timestamps feed the network-to-compositor latency trace
+    if (!UdpReceive::enableTimestamps(m_entityFd)) {
+        std::cerr << "[OverteClient] SO_TIMESTAMPNS unavailable; latency trace starts at recv()" << std::endl;
+    }
+    UdpReceive::enableDropCounter(m_entityFd);
     
     // Bind to ephemeral port (let OS choose) for receiving entity packets
     sockaddr_in bindAddr{};
@@ -387,6 +426,8 @@ bool OverteClient::connectEntityServer() {
     if (::getsockname(m_entityFd, reinterpret_cast<sockaddr*>(&bindAddr), &addrLen) == 0) {
         std::cout << "[OverteClient] EntityServer socket bound to port " << ntohs(bindAddr.sin_port) << std::endl;
     }
+    if (UdpRing::enabled()) m_entityRing = UdpRing::create(m_entityFd);
+    std::cout << "[OverteClient] EntityServer socket I/O: " << (m_entityRing ? "io_uring" : "recvmsg") << std::endl;
     
     m_entityServer = true;
     return true;
@@ -406,34 +447,55 @@ void OverteClient::poll() {
         // Read ALL available packets (non-blocking socket)
         while (true) {
             char buf[1500];
-            sockaddr_storage from{}; socklen_t fromlen = sizeof(from);
-            ssize_t r = ::recvfrom(m_udpFd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &fromlen);
+            sockaddr_storage from{};
+            UdpReceive::Meta meta;
+            ssize_t r = m_domainRing ? m_domainRing->receive(buf, sizeof(buf), &from, meta)
+                                     : UdpReceive::receive(m_udpFd, buf, sizeof(buf), &from, meta);
             if (r > 0) {
-                // Log source address
-                char fromIP[INET_ADDRSTRLEN];
-                uint16_t fromPort = 0;
-                if (from.ss_family == AF_INET) {
-                    sockaddr_in* sin = reinterpret_cast<sockaddr_in*>(&from);
-                    inet_ntop(AF_INET, &sin->sin_addr, fromIP, sizeof(fromIP));
-                    fromPort = ntohs(sin->sin_port);
+                if (DebugLog::debugNetworkPackets) {
+                    // Log source address
+                    char fromIP[INET_ADDRSTRLEN] = "?";
+                    uint16_t fromPort = 0;
+                    if (from.ss_family == AF_INET) {
+                        sockaddr_in* sin = reinterpret_cast<sockaddr_in*>(&from);
+                        inet_ntop(AF_INET, &sin->sin_addr, fromIP, sizeof(fromIP));
+                        fromPort = ntohs(sin->sin_port);
+                    }
+                    std::cout << "[OverteClient] <<< Received packet (" << r << " bytes) from " << fromIP << ":" << fromPort << std::endl;
+                    
+                    // Hex dump first 32 bytes for debugging
+                    std::cout << "[OverteClient] Hex: ";
+                    for (int i = 0; i < std::min(32, (int)r); ++i) {
+                        printf("%02x ", (unsigned char)buf[i]);
+                    }
+                    std::cout << std::endl;
                 }
-                std::cout << "[OverteClient] <<< Received packet (" << r << " bytes) from " << fromIP << ":" << fromPort << std::endl;
-                
-                // Hex dump first 32 bytes for debugging
-                std::cout << "[OverteClient] Hex: ";
-                for (int i = 0; i < std::min(32, (int)r); ++i) {
-                    printf("%02x ", (unsigned char)buf[i]);
+                noteSocketDrops(meta, m_domainSocketDrops, "domain");
+
+                // Reliable packets are ACKed once they pass verification, so a
+                // forged or corrupt one is retransmitted rather than lost
+                const uint8_t* udata = reinterpret_cast<const uint8_t*>(buf);
+                if (peerTypeFor(from) == 'D') m_link.heard(std::chrono::steady_clock::now());
+                if (PacketLanes::classify(udata, static_cast<size_t>(r)) == PacketLanes::Lane::Control) {
+                    // Handled now, so checked on its own
+                    if (m_verifier.accept(udata, static_cast<size_t>(r))) {
+                        ackIfReliable(udata, static_cast<size_t>(r), from);
+                        parseDomainPacket(buf, static_cast<size_t>(r), from, meta.rxTime);
+                    } else {
+                        noteVerifyFailures(1);
+                    }
+                } else if (!m_bulkLane.push(buf, static_cast<size_t>(r), from, meta.rxTime) &&
+                           (m_bulkLane.dropped() & (m_bulkLane.dropped() - 1)) == 0) {
+                    // Log at powers of two so a flood doesn't flood the log
+                    std::cerr << "[OverteClient] Bulk lane full, dropped " << m_bulkLane.dropped() << " packets" << std::endl;
                 }
-                std::cout << std::endl;
-                parseDomainPacket(buf, static_cast<size_t>(r));
             } else if (r < 0) {
                 if (errno == EWOULDBLOCK || errno == EAGAIN) {
                     // No more packets available
                     break;
                 } else {
                     // Real error
-                    static int errorCount = 0;
-                    if (++errorCount <= 3) {
+                    if (++m_recvErrorCount <= 3) {
                         std::cerr << "[OverteClient] UDP recv error: " << strerror(errno) << std::endl;
                     }
                     break;
@@ -443,101 +505,289 @@ void OverteClient::poll() {
                 break;
             }
         }
+        // Completions of earlier sends were read along with the datagrams
+        noteSendFailures();
+        if (m_domainRing && m_domainRing->failed()) {
+            std::cerr << "[OverteClient] io_uring receive unsupported on domain socket, using recvmsg" << std::endl;
+            m_domainRing.reset();
+            m_ringSendFailures = 0;
+        }
+
+        // Verify this poll's bulk packets as one batch (runs from one peer
+        // reuse its key) before any of them is dispatched, and ACK those kept
+        noteVerifyFailures(m_bulkLane.filterNew([&](const char* data, size_t len, const sockaddr_storage& from) {
+            const auto* udata = reinterpret_cast<const uint8_t*>(data);
+            if (!m_verifier.accept(udata, len)) return false;
+            ackIfReliable(udata, len, from);
+            return true;
+        }));
+        if (m_assetAckDue) {
+            m_assetAckDue = false;
+            sendControl(m_assetLink.ack(), m_assetServerAddr, m_assetServerAddrLen);
+        }
+
+        // Entity and avatar bulk data, oldest first, within this poll's budget
+        m_bulkLane.drain([&](const char* data, size_t len, const sockaddr_storage& from,
+                             std::chrono::steady_clock::time_point rxTime) {
+            parseDomainPacket(data, len, from, rxTime);
+        }, m_bulkBudget);
         
         // Send periodic ping to domain to keep connection alive
-        static auto lastPing = std::chrono::steady_clock::now();
-        static auto lastDomainList = std::chrono::steady_clock::now();
-        static auto lastAvatarData = std::chrono::steady_clock::now();
-        static auto lastAvatarQuery = std::chrono::steady_clock::now();
         auto now = std::chrono::steady_clock::now();
         
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastPing).count() >= 1) {
+        if (std::chrono::duration_cast<std::chrono::seconds>(now - m_lastPing).count() >= 1) {
             std::cout << "[OverteClient] Sending periodic ping to domain (localID=" << m_localID << ")" << std::endl;
             sendPing(m_udpFd, m_udpAddr, m_udpAddrLen);
-            lastPing = now;
+            // Mixers are pinged too so every peer has RTT and clock offset
+            if (m_avatarMixerConnected) sendPing(m_udpFd, m_avatarMixerAddr, m_avatarMixerAddrLen);
+            if (m_entityServerPort != 0) sendPing(m_udpFd, m_entityServerAddr, m_entityServerAddrLen);
+            m_lastPing = now;
         }
         
         // Send AvatarQuery periodically (every 5 seconds) to get avatar updates
-        if (m_avatarMixerConnected && std::chrono::duration_cast<std::chrono::seconds>(now - lastAvatarQuery).count() >= 5) {
+        if (m_avatarMixerConnected && std::chrono::duration_cast<std::chrono::seconds>(now - m_lastAvatarQuery).count() >= 5) {
             sendAvatarQuery();
-            lastAvatarQuery = now;
+            m_lastAvatarQuery = now;
         }
         
         // Send avatar data to Avatar Mixer every 100ms (10 Hz) if connected
-        if (m_avatarMixerConnected && std::chrono::duration_cast<std::chrono::milliseconds>(now - lastAvatarData).count() >= 100) {
+        if (m_avatarMixerConnected && std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastAvatarData).count() >= 100) {
             sendAvatarData();
-            lastAvatarData = now;
+            m_lastAvatarData = now;
         }
         
+        // Silent domain: retry the handshake now, as the same session
+        if (m_link.checkLost(now)) {
+            std::cout << "[OverteClient] Domain silent for "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(m_link.timeout()).count()
+                      << " ms; reconnecting as session " << m_sessionUUID << " (local ID " << m_localID
+                      << "), keeping " << m_world.store().size() << " entities" << std::endl;
+            m_domainConnected = false;
+            m_lastDomainList = {};
+        }
+
+        // atp:// downloads ModelCache queued for this domain; they wait there
+        // until we know its asset server.
+        if (m_assetServerPort != 0) {
+            for (auto& url : ModelCache::instance().takeAtpRequests(m_domainUrl)) {
+                m_assets->request(url, [](const std::string& u, bool success, const std::string& localPath) {
+                    ModelCache::instance().completeAtpRequest(u, success, localPath);
+                });
+            }
+        }
+        m_assets->poll(now);
+        // Requests are held until the asset server acknowledges a handshake
+        if (m_assetServerPort != 0 && !m_assetBacklog.empty() && m_assetLink.handshakeDue(now)) {
+            sendControl(m_assetLink.handshake(), m_assetServerAddr, m_assetServerAddrLen);
+        }
+
         // Request domain list periodically if not connected
-        if (!m_domainConnected && std::chrono::duration_cast<std::chrono::seconds>(now - lastDomainList).count() >= 3) {
+        if (!m_domainConnected && std::chrono::duration_cast<std::chrono::seconds>(now - m_lastDomainList).count() >= 3) {
             std::cout << "[OverteClient] Retrying domain handshake..." << std::endl;
             sendDomainConnectRequest();
             sendDomainListRequest();
-            lastDomainList = now;
+            m_lastDomainList = now;
         }
     }
 
-    // Parse entity server packets
+    // Parse entity server packets, then apply whatever the parse workers
+    // have finished decoding (in arrival order)
+    const auto entityStart = std::chrono::steady_clock::now();
     parseNetworkPackets();
+    commitParsedEntities();
+    const auto entityEnd = std::chrono::steady_clock::now();
+    m_entityRate.recordCost(entityEnd - entityStart);
+    if (m_entityServerPort != 0 && m_entityRate.update(entityEnd, m_parsePipeline.backlog() + m_syncBacklog)) {
+        sendEntityQuery();
+    }
+    if (m_initialLoad.active && std::chrono::steady_clock::now() - m_initialLoadStart >= m_initialLoadTimeout) {
+        finishInitialLoad("time limit reached", false);
+    }
+    if (m_resyncActive && std::chrono::steady_clock::now() - m_resyncStart >= m_initialLoadTimeout) {
+        finishResync("time limit reached", false);
+    }
+    if (m_snapshotWriter && !m_initialLoad.active &&
+        (m_snapshotDue || std::chrono::steady_clock::now() - m_lastSnapshot >= m_snapshotInterval)) {
+        captureSnapshot();
+    }
+
+    // Everything sent through the ring this poll goes out in one submission
+    if (m_domainRing) m_domainRing->flush();
 
     if (m_useSimulation) {
         // Simulate entity transforms changing slightly over time.
-        static auto t0 = std::chrono::steady_clock::now();
-        const float t = std::chrono::duration<float>(std::chrono::steady_clock::now() - t0).count();
-        for (auto& [id, e] : m_entities) {
-            const float r = 0.25f + 0.05f * static_cast<float>(id);
-            const float x = std::cos(t * 0.5f + static_cast<float>(id)) * r;
-            const float z = std::sin(t * 0.5f + static_cast<float>(id)) * r;
-            e.transform = glm::translate(glm::mat4(1.0f), glm::vec3{x, 1.25f, z});
-            m_updateQueue.push_back(id);
-        }
+        const float t = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_simulationStart).count();
+        m_world.store().forEach([&](OverteEntity& e) {
+            const float phase = static_cast<float>(e.slot + 1);
+            const float r = 0.25f + 0.05f * phase;
+            const float x = std::cos(t * 0.5f + phase) * r;
+            const float z = std::sin(t * 0.5f + phase) * r;
+            e.position = glm::vec3{x, 1.25f, z};
+            m_world.markUpdated(e.slot);
+        });
     }
 }
 
 void OverteClient::parseNetworkPackets() {
     // Read from EntityServer socket
     if (m_entityServerReady && m_entityFd != -1) {
+        // Drain the whole burst (non-blocking socket) so the parse workers get
+        // a full batch instead of one packet per frame.
         char buf[1500];
-        sockaddr_storage from{}; socklen_t fromlen = sizeof(from);
-        ssize_t r = ::recvfrom(m_entityFd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &fromlen);
-        if (r > 0) {
-            std::cout << "[OverteClient] EntityServer packet received (" << r << " bytes, type=0x" 
-                      << std::hex << (int)(unsigned char)buf[0] << std::dec << ")" << std::endl;
-            parseEntityPacket(buf, static_cast<size_t>(r));
+        for (int i = 0; i < 1024; ++i) {
+            sockaddr_storage from{};
+            UdpReceive::Meta meta;
+            ssize_t r = m_entityRing ? m_entityRing->receive(buf, sizeof(buf), &from, meta)
+                                     : UdpReceive::receive(m_entityFd, buf, sizeof(buf), &from, meta);
+            if (r <= 0) break;
+            noteSocketDrops(meta, m_entitySocketDrops, "entity");
+            if (DebugLog::debugEntityPackets) {
+                std::cout << "[OverteClient] EntityServer packet received (" << r << " bytes, type=0x" 
+                          << std::hex << (int)(unsigned char)buf[0] << std::dec << ")" << std::endl;
+            }
+            parseEntityPacket(buf, static_cast<size_t>(r), meta.rxTime);
+            m_entityRate.recordPackets(1);
+        }
+        if (m_entityRing && m_entityRing->failed()) {
+            std::cerr << "[OverteClient] io_uring receive unsupported on EntityServer socket, using recvmsg" << std::endl;
+            m_entityRing.reset();
+        }
+    }
+}
+
+// Same host and port (IPv4/IPv6)
+static bool sameEndpoint(const sockaddr_storage& a, const sockaddr_storage& b) {
+    if (a.ss_family != b.ss_family) return false;
+    if (a.ss_family == AF_INET) {
+        const auto& x = reinterpret_cast<const sockaddr_in&>(a);
+        const auto& y = reinterpret_cast<const sockaddr_in&>(b);
+        return x.sin_port == y.sin_port && x.sin_addr.s_addr == y.sin_addr.s_addr;
+    }
+    if (a.ss_family == AF_INET6) {
+        const auto& x = reinterpret_cast<const sockaddr_in6&>(a);
+        const auto& y = reinterpret_cast<const sockaddr_in6&>(b);
+        return x.sin6_port == y.sin6_port && std::memcmp(&x.sin6_addr, &y.sin6_addr, sizeof(x.sin6_addr)) == 0;
+    }
+    return false;
+}
+
+char OverteClient::peerTypeFor(const sockaddr_storage& from) const {
+    if (m_entityServerPort != 0 && sameEndpoint(from, m_entityServerAddr)) return 'o';
+    if (m_avatarMixerPort != 0 && sameEndpoint(from, m_avatarMixerAddr)) return 'W';
+    if (m_assetServerPort != 0 && sameEndpoint(from, m_assetServerAddr)) return 'A';
+    return 'D';
+}
+
+void OverteClient::noteSocketDrops(const UdpReceive::Meta& meta, std::uint32_t& total, const char* socketName) {
+    if (!meta.hasDropCount || meta.dropCount <= total) return;
+    std::cerr << "[OverteClient] " << socketName << " socket receive queue overflowed: "
+              << (meta.dropCount - total) << " more datagrams dropped (" << meta.dropCount << " total)" << std::endl;
+    total = meta.dropCount;
+}
+
+void OverteClient::ackIfReliable(const uint8_t* data, size_t len, const sockaddr_storage& from) {
+    NLPacket::Header header;
+    if (!NLPacket::parseHeader(data, len, header) || (header.sequenceAndFlags & 0xC0000000) != 0x40000000) return;
+    const uint32_t sequence = header.sequenceAndFlags & UdtConnection::kSequenceMask;
+    const socklen_t fromLen = from.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+    if (peerTypeFor(from) == 'A') {
+        // One ACK per poll covers the whole burst (sent after filterNew).
+        // A duplicate is ACKed again, since our last ACK may have been lost;
+        // AssetClient ignores the repeated reply.
+        if (m_assetLink.receive(sequence) == UdtConnection::Receive::NoHandshake) {
+            sendControl({UdtConnection::ControlType::HandshakeRequest}, from, fromLen);
+        } else {
+            m_assetAckDue = true;
         }
+        return;
+    }
+    sendControl({UdtConnection::ControlType::ACK, sequence}, from, fromLen);
+}
+
+void OverteClient::handleControlPacket(const uint8_t* data, size_t len, const sockaddr_storage& from) {
+    UdtConnection::Control control;
+    if (!UdtConnection::parse(data, len, control)) return;
+    const socklen_t fromLen = from.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+    if (peerTypeFor(from) == 'A') {
+        const bool wasEstablished = m_assetLink.established();
+        if (auto reply = m_assetLink.handle(control)) sendControl(*reply, from, fromLen);
+        if (m_assetLink.established() && !wasEstablished) {
+            std::cout << "[OverteClient] Asset server connection established, sending "
+                      << m_assetBacklog.size() << " held requests" << std::endl;
+            for (auto& [type, payload] : std::exchange(m_assetBacklog, {})) sendAssetPacket(type, payload);
+        }
+        return;
+    }
+    // Other peers get no per-connection state: answer their handshake so
+    // their reliable packets flow, ignore ACKs (nothing is retransmitted)
+    if (control.type == UdtConnection::ControlType::Handshake) {
+        sendControl({UdtConnection::ControlType::HandshakeACK, control.value}, from, fromLen);
+    }
+    if (DebugLog::debugNetworkPackets) {
+        std::cout << "[OverteClient] Control packet type " << static_cast<int>(control.type) << " from '"
+                  << peerTypeFor(from) << "'" << std::endl;
     }
 }
 
-void OverteClient::parseDomainPacket(const char* data, size_t len) {
+void OverteClient::noteVerifyFailures(std::size_t count) {
+    if (count == 0) return;
+    // Log at powers of two so a flood of bad hashes doesn't flood the log
+    const std::uint64_t total = m_verifier.failed();
+    if (std::bit_floor(total) > total - count) {
+        std::cerr << "[OverteClient] Dropped " << total << " packets with a bad verification hash" << std::endl;
+    }
+}
+
+void OverteClient::noteSendFailures() {
+    if (!m_domainRing || m_domainRing->sendFailures() == m_ringSendFailures) return;
+    const std::uint64_t count = m_domainRing->sendFailures() - m_ringSendFailures;
+    m_ringSendFailures = m_domainRing->sendFailures();
+    m_queuedSendsFailed += count;
+    // sendDatagram reported these as sent when they were queued; log at
+    // powers of two like the verifier drops
+    const std::uint64_t total = m_queuedSendsFailed;
+    if (std::bit_floor(total) > total - count) {
+        std::cerr << "[OverteClient] " << total << " queued sends failed on completion (last: "
+                  << strerror(m_domainRing->lastSendError()) << ")" << std::endl;
+    }
+}
+
+OverteClient::ReceiveStats OverteClient::receiveStats() const {
+    ReceiveStats stats;
+    stats.domainSocketDrops = m_domainSocketDrops;
+    stats.entitySocketDrops = m_entitySocketDrops;
+    stats.bulkQueued = m_bulkLane.size();
+    stats.bulkDropped = m_bulkLane.dropped();
+    stats.verified = m_verifier.verified();
+    stats.verifyFailed = m_verifier.failed();
+    stats.queuedSendsFailed = m_queuedSendsFailed;
+    return stats;
+}
+
+void OverteClient::parseDomainPacket(const char* data, size_t len, const sockaddr_storage& from,
+                                     std::chrono::steady_clock::time_point rxTime) {
+    // UDT control packets (ACK, handshake) have no NLPacket header
+    const uint8_t* udata = reinterpret_cast<const uint8_t*>(data);
+    if (len >= 4 && (udata[0] & 0x80) != 0) {
+        handleControlPacket(udata, len, from);
+        return;
+    }
     if (len < 6) return;  // NLPacket header is minimum 6 bytes
     
     // Parse NLPacket header
     NLPacket::Header header;
-    const uint8_t* udata = reinterpret_cast<const uint8_t*>(data);
     if (!NLPacket::parseHeader(udata, len, header)) {
         std::cerr << "[OverteClient] Failed to parse NLPacket header" << std::endl;
         return;
     }
     
-    // Check if this is a control packet (bit 31 set in sequenceAndFlags)
-    bool isControlPacket = (header.sequenceAndFlags & 0x80000000) != 0;
     bool isReliable = (header.sequenceAndFlags & 0x40000000) != 0;
-    uint32_t sequenceNumber = header.sequenceAndFlags & 0x1FFFFFFF;  // 29 bits
+    uint32_t sequenceNumber = header.sequenceAndFlags & 0x07FFFFFF;  // 27 bits
     
-    if (isControlPacket) {
-        // This is a control packet (ACK, Handshake, etc.) - just log it for now
-        std::cout << "[OverteClient] Received control packet (ACK/Handshake)" << std::endl;
-        return;
-    }
-    
-    // If this is a reliable packet, send ACK
-    if (isReliable) {
-        sendACK(sequenceNumber);
-    }
+    // Reliable packets were already ACKed once they passed verification (poll)
     
     PacketType packetType = NLPacket::getType(udata, len);
-    std::cout << "[OverteClient] Domain packet type: " << static_cast<int>(packetType) 
+    if (DebugLog::debugNetworkPackets) std::cout << "[OverteClient] Domain packet type: " << static_cast<int>(packetType) 
               << " (0x" << std::hex << static_cast<int>(packetType) << std::dec << ")" 
               << " version: " << (int)header.version 
               << " seq: " << sequenceNumber 
@@ -572,8 +822,7 @@ void OverteClient::parseDomainPacket(const char* data, size_t len) {
             break;
             
         case PacketType::PingReply:
-            // Keep-alive ping reply
-            std::cout << "[OverteClient] Ping reply received" << std::endl;
+            handlePingReply(payload, payloadLen, peerTypeFor(from), rxTime);
             break;
             
         case PacketType::ICEPing:
@@ -587,8 +836,11 @@ void OverteClient::parseDomainPacket(const char* data, size_t len) {
             break;
             
         case PacketType::EntityData:
-            std::cout << "[OverteClient] Received EntityData packet (" << payloadLen << " bytes)" << std::endl;
-            parseEntityPacket(payload, payloadLen);
+            if (DebugLog::debugNetworkPackets) {
+                std::cout << "[OverteClient] Received EntityData packet (" << payloadLen << " bytes)" << std::endl;
+            }
+            parseEntityPacket(payload, payloadLen, rxTime);
+            m_entityRate.recordPackets(1);
             break;
             
         case PacketType::EntityEditNack:
@@ -604,10 +856,19 @@ void OverteClient::parseDomainPacket(const char* data, size_t len) {
             
         case PacketType::EntityQueryInitialResultsComplete:
             std::cout << "[OverteClient] Entity query initial results complete" << std::endl;
+            // Everything sent before this marker belongs to the initial load.
+            // A resync reconciles first; after a timed-out load or resync the
+            // initial load reconciles what is still unconfirmed.
+            m_parsePipeline.waitIdle();
+            commitParsedEntities();
+            finishResync("server reported initial results complete", true);
+            finishInitialLoad("server reported initial results complete", true);
             break;
         
         case PacketType::BulkAvatarData:
-            std::cout << "[OverteClient] Received BulkAvatarData from Avatar Mixer (" << payloadLen << " bytes)" << std::endl;
+            if (DebugLog::debugNetworkPackets) {
+                std::cout << "[OverteClient] Received BulkAvatarData from Avatar Mixer (" << payloadLen << " bytes)" << std::endl;
+            }
             handleAvatarMixerPacket(payload, payloadLen, static_cast<uint8_t>(packetType));
             break;
             
@@ -619,6 +880,12 @@ void OverteClient::parseDomainPacket(const char* data, size_t len) {
         case PacketType::KillAvatar:
             std::cout << "[OverteClient] Received KillAvatar packet" << std::endl;
             break;
+
+        case PacketType::AssetMappingOperationReply:
+        case PacketType::AssetGetInfoReply:
+        case PacketType::AssetGetReply:
+            m_assets->handlePacket(udata, len);
+            break;
             
         default:
             // Log all unknown packet types to see what we're missing
@@ -636,10 +903,13 @@ void OverteClient::parseDomainPacket(const char* data, size_t len) {
     }
 }
 
-void OverteClient::parseEntityPacket(const char* data, size_t len) {
+void OverteClient::parseEntityPacket(const char* data, size_t len, std::chrono::steady_clock::time_point rxTime) {
     // Overte packet structure (simplified):
     // - Byte 0: PacketType
     // - Following bytes: payload (varies by type)
+    //
+    // Decoding happens on the parse pipeline's workers; results are applied
+    // in arrival order by commitParsedEntities().
     
     if (len < 1) return;
     
@@ -652,248 +922,305 @@ void OverteClient::parseEntityPacket(const char* data, size_t len) {
         std::cout << std::endl;
     }
     
-    unsigned char packetType = static_cast<unsigned char>(data[0]);
-    
-    // Entity packet types
-    const unsigned char PACKET_TYPE_ENTITY_ADD = 0x10;
-    const unsigned char PACKET_TYPE_ENTITY_EDIT = 0x11;
-    const unsigned char PACKET_TYPE_ENTITY_ERASE = 0x12;
-    const unsigned char PACKET_TYPE_ENTITY_QUERY = 0x15;
-    const unsigned char PACKET_TYPE_OCTREE_STATS = 0x16;
-    const unsigned char PACKET_TYPE_ENTITY_DATA = 0x41; // Bulk entity data response
-    
-    switch (packetType) {
-        case PACKET_TYPE_ENTITY_DATA:
-        case PACKET_TYPE_ENTITY_ADD: {
-            // EntityAdd packet structure (enhanced):
-            // [type:u8][id:u64][name:null-terminated][position:3xf32][rotation:4xf32][dimensions:3xf32][model_url:null-terminated][texture_url:null-terminated][color:3xf32]
-            if (len < 9) break; // need at least 1+8 bytes
-            
-            std::uint64_t entityId;
-            std::memcpy(&entityId, data + 1, 8);
-            
-            // Parse name (null-terminated string after ID)
-            size_t offset = 9;
-            std::string name;
-            while (offset < len && data[offset] != '\0') {
-                name += data[offset++];
-            }
-            offset++; // skip null terminator
-            if (name.empty()) name = "Entity_" + std::to_string(entityId);
-            
-            // Parse position (vec3 - 3 floats)
-            glm::vec3 position(0.0f, 1.5f, -2.0f); // Default
-            if (offset + 12 <= len) {
-                std::memcpy(&position.x, data + offset, 4);
-                std::memcpy(&position.y, data + offset + 4, 4);
-                std::memcpy(&position.z, data + offset + 8, 4);
-                offset += 12;
-            }
-            
-            // Parse rotation (quaternion - 4 floats: x, y, z, w)
-            glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f); // Identity (w, x, y, z in glm)
-            if (offset + 16 <= len) {
-                float qx, qy, qz, qw;
-                std::memcpy(&qx, data + offset, 4);
-                std::memcpy(&qy, data + offset + 4, 4);
-                std::memcpy(&qz, data + offset + 8, 4);
-                std::memcpy(&qw, data + offset + 12, 4);
-                rotation = glm::quat(qw, qx, qy, qz); // glm uses w first
-                offset += 16;
-            }
-            
-            // Parse dimensions/scale (vec3 - 3 floats)
-            glm::vec3 dimensions(0.1f, 0.1f, 0.1f); // Default
-            if (offset + 12 <= len) {
-                std::memcpy(&dimensions.x, data + offset, 4);
-                std::memcpy(&dimensions.y, data + offset + 4, 4);
-                std::memcpy(&dimensions.z, data + offset + 8, 4);
-                offset += 12;
-            }
-            
-            // Parse model URL (null-terminated string)
-            std::string modelUrl;
-            while (offset < len && data[offset] != '\0') {
-                modelUrl += data[offset++];
+    m_parsePipeline.submit(data, len, rxTime);
+}
+
+// True if `entity` (restored from a snapshot or kept through a reconnect)
+// already has the state `op` carries.
+static bool matchesKnown(const OverteEntity& entity, const EntityOp& op, const StringTable& strings) {
+    auto near = [](const glm::vec3& a, const glm::vec3& b) {
+        const glm::vec3 d = a - b;
+        return glm::dot(d, d) < 1e-10f;
+    };
+    // Stored rotations are normalized; compare up to sign
+    const glm::quat a = glm::normalize(op.rotation);
+    const glm::quat b = glm::normalize(entity.rotation);
+    const float qdot = std::fabs(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+    auto same = [&](StringId id, std::string_view text) { return strings.str(id) == text; };
+    return entity.type == op.type && same(entity.name, op.name) &&
+           same(entity.modelUrl, op.modelUrl) && same(entity.textureUrl, op.textureUrl) &&
+           near(entity.position, op.position) && near(entity.scale, op.dimensions) &&
+           near(entity.dimensions, op.dimensions) && near(entity.color, op.color) &&
+           entity.parentId == op.parentId && entity.parentJoint == op.parentJoint &&
+           entity.alpha == 1.0f && qdot > 1.0f - 1e-6f;
+}
+
+static void logRejectedParent(const EntityOp& op) {
+    std::cerr << "[OverteClient] Ignoring parent " << op.parentId.toString() << " for "
+              << op.id.toString() << ": would create a cycle" << std::endl;
+}
+
+void OverteClient::commitParsedEntities() {
+    m_parsedOps.clear();
+    m_parsePipeline.drain(m_parsedOps);
+    for (const auto& op : m_parsedOps) {
+        applyEntityOp(op);
+    }
+}
+
+void OverteClient::applyEntityOp(const EntityOp& op) {
+    switch (op.kind) {
+        case EntityOp::Kind::Add: {
+            // Reconcile against the snapshot: an entity the server confirms
+            // unchanged needs no compositor update.
+            bool unchanged = false;
+            const std::uint32_t known = m_world.store().find(op.id);
+            if (known != EntityStore::npos && known < m_unconfirmed.size() && m_unconfirmed[known]) {
+                m_unconfirmed[known] = 0;
+                --m_unconfirmedCount;
+                unchanged = matchesKnown(m_world.store().at(known), op, m_world.strings());
             }
-            offset++; // skip null terminator
             
-            // Parse texture URL (null-terminated string)
-            std::string textureUrl;
-            while (offset < len && data[offset] != '\0') {
-                textureUrl += data[offset++];
-            }
-            offset++; // skip null terminator
+            const auto applied = m_world.apply(op, !unchanged);
+            if (applied.parentRejected) logRejectedParent(op);
             
-            // Parse color (vec3 RGB - 3 floats 0-1)
-            glm::vec3 color(1.0f, 1.0f, 1.0f); // Default white
-            if (offset + 12 <= len) {
-                std::memcpy(&color.r, data + offset, 4);
-                std::memcpy(&color.g, data + offset + 4, 4);
-                std::memcpy(&color.b, data + offset + 8, 4);
-                offset += 12;
+            if (m_resyncActive) {
+                ++m_resyncReceived;
+                if (!unchanged) ++m_resyncChanged;
             }
+            if (!unchanged) markSnapshotDirty(applied.slot);
             
-            // Parse entity type (optional, u8)
-            EntityType entityType = EntityType::Box; // Default
-            if (offset + 1 <= len) {
-                uint8_t typeCode = static_cast<uint8_t>(data[offset++]);
-                // Map Overte entity type codes to our enum
-                // 0=Unknown, 1=Box, 2=Sphere, 3=Model, etc.
-                if (typeCode <= static_cast<uint8_t>(EntityType::Material)) {
-                    entityType = static_cast<EntityType>(typeCode);
+            if (!m_initialLoad.complete) {
+                if (!m_initialLoad.active) {
+                    m_initialLoad.active = true;
+                    m_initialLoadStart = std::chrono::steady_clock::now();
+                    std::cout << "[OverteClient] Initial load started" << std::endl;
                 }
+                ++m_initialLoad.entitiesReceived;
+                // Per-entity logging would dominate a bulk load; progress is reported instead
+                if (!DebugLog::debugEntityLifecycle) break;
             }
             
-            // Build transform matrix from position, rotation, scale
-            glm::mat4 transform = glm::mat4(1.0f);
-            transform = glm::translate(transform, position);
-            transform = transform * glm::mat4_cast(rotation);
-            transform = glm::scale(transform, dimensions);
-            
-            // Create entity with all properties
-            OverteEntity entity;
-            entity.id = entityId;
-            entity.name = name;
-            entity.transform = transform;
-            entity.type = entityType;
-            entity.modelUrl = modelUrl;
-            entity.textureUrl = textureUrl;
-            entity.color = color;
-            entity.dimensions = dimensions;
-            entity.alpha = 1.0f; // Default fully opaque
-            
-            m_entities[entityId] = entity;
-            m_updateQueue.push_back(entityId);
-            
-            std::cout << "[OverteClient] Entity added: " << name << " (id=" << entityId << ")" << std::endl;
+            std::cout << "[OverteClient] Entity added: " << op.name << " (id=" << op.id.toString() << ")" << std::endl;
             if (DebugLog::debugEntityLifecycle) {
-                std::cout << "  Type: " << static_cast<int>(entityType) << std::endl;
-                std::cout << "  Position: (" << position.x << ", " << position.y << ", " << position.z << ")" << std::endl;
-                std::cout << "  Rotation: (" << rotation.x << ", " << rotation.y << ", " << rotation.z << ", " << rotation.w << ")" << std::endl;
-                std::cout << "  Dimensions: (" << dimensions.x << ", " << dimensions.y << ", " << dimensions.z << ")" << std::endl;
-                std::cout << "  Color: RGB(" << color.r << ", " << color.g << ", " << color.b << ")" << std::endl;
-                if (!modelUrl.empty()) {
-                    std::cout << "  Model: " << modelUrl << std::endl;
+                std::cout << "  Type: " << static_cast<int>(op.type) << std::endl;
+                std::cout << "  Position: (" << op.position.x << ", " << op.position.y << ", " << op.position.z << ")" << std::endl;
+                std::cout << "  Rotation: (" << op.rotation.x << ", " << op.rotation.y << ", " << op.rotation.z << ", " << op.rotation.w << ")" << std::endl;
+                std::cout << "  Dimensions: (" << op.dimensions.x << ", " << op.dimensions.y << ", " << op.dimensions.z << ")" << std::endl;
+                std::cout << "  Color: RGB(" << op.color.r << ", " << op.color.g << ", " << op.color.b << ")" << std::endl;
+                if (!op.modelUrl.empty()) {
+                    std::cout << "  Model: " << op.modelUrl << std::endl;
                 }
-                if (!textureUrl.empty()) {
-                    std::cout << "  Texture: " << textureUrl << std::endl;
+                if (!op.textureUrl.empty()) {
+                    std::cout << "  Texture: " << op.textureUrl << std::endl;
                 }
             }
-            std::cout << "[OverteClient/Lifecycle] Total entities: " << m_entities.size() << ", Update queue: " << m_updateQueue.size() << std::endl;
+            std::cout << "[OverteClient/Lifecycle] Total entities: " << m_world.store().size() << ", Update queue: " << m_world.queuedUpdates() << std::endl;
             break;
         }
         
-        case PACKET_TYPE_ENTITY_EDIT: {
-            // EntityEdit packet: [type:u8][id:u64][flags:u8][property data...]
-            if (len < 10) break; // Need type + id + flags
-            
-            std::uint64_t entityId;
-            std::memcpy(&entityId, data + 1, 8);
-            
-            uint8_t flags = data[9];
-            size_t offset = 10;
-            
-            const uint8_t HAS_POSITION = 0x01;
-            const uint8_t HAS_ROTATION = 0x02;
-            const uint8_t HAS_DIMENSIONS = 0x04;
+        case EntityOp::Kind::Edit: {
+            const auto applied = m_world.apply(op);
+            if (applied.slot == EntityStore::npos) break;
+            if (applied.parentRejected) logRejectedParent(op);
+            markSnapshotDirty(applied.slot);
             
-            auto it = m_entities.find(entityId);
-            if (it != m_entities.end()) {
-                glm::vec3 position(0.0f);
-                glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
-                glm::vec3 dimensions(1.0f);
-                
-                // Extract current transform
-                glm::vec3 scale;
-                glm::quat currentRot;
-                glm::vec3 currentPos;
-                glm::vec3 skew;
-                glm::vec4 perspective;
-                glm::decompose(it->second.transform, scale, currentRot, currentPos, skew, perspective);
-                
-                position = currentPos;
-                rotation = currentRot;
-                dimensions = scale;
-                
-                // Update based on flags
-                if (flags & HAS_POSITION) {
-                    if (offset + 12 <= len) {
-                        std::memcpy(&position.x, data + offset, 4);
-                        std::memcpy(&position.y, data + offset + 4, 4);
-                        std::memcpy(&position.z, data + offset + 8, 4);
-                        offset += 12;
-                    }
-                }
-                
-                if (flags & HAS_ROTATION) {
-                    if (offset + 16 <= len) {
-                        float qx, qy, qz, qw;
-                        std::memcpy(&qx, data + offset, 4);
-                        std::memcpy(&qy, data + offset + 4, 4);
-                        std::memcpy(&qz, data + offset + 8, 4);
-                        std::memcpy(&qw, data + offset + 12, 4);
-                        rotation = glm::quat(qw, qx, qy, qz);
-                        offset += 16;
-                    }
-                }
-                
-                if (flags & HAS_DIMENSIONS) {
-                    if (offset + 12 <= len) {
-                        std::memcpy(&dimensions.x, data + offset, 4);
-                        std::memcpy(&dimensions.y, data + offset + 4, 4);
-                        std::memcpy(&dimensions.z, data + offset + 8, 4);
-                        offset += 12;
-                    }
-                }
-                
-                // Rebuild transform
-                glm::mat4 transform = glm::mat4(1.0f);
-                transform = glm::translate(transform, position);
-                transform = transform * glm::mat4_cast(rotation);
-                transform = glm::scale(transform, dimensions);
-                
-                it->second.transform = transform;
-                m_updateQueue.push_back(entityId);
-                
-                std::cout << "[OverteClient] Entity edited: id=" << entityId << " (flags=0x" << std::hex << (int)flags << std::dec << ")" << std::endl;
-                if (flags & HAS_POSITION) {
-                    std::cout << "  New position: (" << position.x << ", " << position.y << ", " << position.z << ")" << std::endl;
-                }
-                if (flags & HAS_ROTATION) {
-                    std::cout << "  New rotation: (" << rotation.x << ", " << rotation.y << ", " << rotation.z << ", " << rotation.w << ")" << std::endl;
-                }
-                if (flags & HAS_DIMENSIONS) {
-                    std::cout << "  New dimensions: (" << dimensions.x << ", " << dimensions.y << ", " << dimensions.z << ")" << std::endl;
-                }
+            // Edits are the steady-state traffic; logging them allocates per packet
+            if (!DebugLog::debugEntityLifecycle) break;
+            std::cout << "[OverteClient] Entity edited: id=" << op.id.toString() << " (flags=0x" << std::hex << (int)op.editFlags << std::dec << ")" << std::endl;
+            if (op.editFlags & EntityPacket::HasPosition) {
+                std::cout << "  New position: (" << op.position.x << ", " << op.position.y << ", " << op.position.z << ")" << std::endl;
+            }
+            if (op.editFlags & EntityPacket::HasRotation) {
+                std::cout << "  New rotation: (" << op.rotation.x << ", " << op.rotation.y << ", " << op.rotation.z << ", " << op.rotation.w << ")" << std::endl;
+            }
+            if (op.editFlags & EntityPacket::HasDimensions) {
+                std::cout << "  New dimensions: (" << op.dimensions.x << ", " << op.dimensions.y << ", " << op.dimensions.z << ")" << std::endl;
             }
             break;
         }
         
-        case PACKET_TYPE_ENTITY_ERASE: {
-            // EntityErase packet: u64 entityID
-            if (len < 9) break;
-            
-            std::uint64_t entityId;
-            std::memcpy(&entityId, data + 1, 8);
-            
-            auto it = m_entities.find(entityId);
-            if (it != m_entities.end()) {
-                m_entities.erase(it);
-                m_deleteQueue.push_back(entityId);
-                std::cout << "[OverteClient] Entity erased: id=" << entityId << std::endl;
+        case EntityOp::Kind::Erase: {
+            const std::uint32_t slot = m_world.apply(op).slot;
+            if (slot != EntityStore::npos) {
+                markSnapshotDirty(slot);
+                if (slot < m_unconfirmed.size() && m_unconfirmed[slot]) {
+                    m_unconfirmed[slot] = 0;
+                    --m_unconfirmedCount;
+                }
+                if (DebugLog::debugEntityLifecycle) {
+                    std::cout << "[OverteClient] Entity erased: id=" << op.id.toString() << std::endl;
+                }
             }
             break;
         }
         
-        case PACKET_TYPE_OCTREE_STATS:
-            std::cout << "[OverteClient] Received octree stats" << std::endl;
+        case EntityOp::Kind::OctreeStats:
+            m_entityRate.recordServerStats(op.statsPackets, op.statsElapsedUs);
+            if (DebugLog::debugEntityPackets) {
+                std::cout << "[OverteClient] Received octree stats: " << op.statsPackets << " packets in "
+                          << op.statsElapsedUs << " us" << std::endl;
+            }
             break;
             
-        default:
-            std::cout << "[OverteClient] Unknown entity packet type: 0x" << std::hex << (int)packetType << std::dec << std::endl;
+        case EntityOp::Kind::Unknown:
+            std::cout << "[OverteClient] Unknown entity packet type: 0x" << std::hex << (int)op.packetType << std::dec << std::endl;
             break;
+            
+        case EntityOp::Kind::Invalid:
+            break;
+    }
+}
+
+void OverteClient::finishInitialLoad(const char* reason, bool serverComplete) {
+    if (m_initialLoad.complete) {
+        // A pass that outlasted the time limit has now completed
+        if (serverComplete && m_unconfirmedCount > 0) {
+            const std::size_t removed = removeUnconfirmed();
+            std::cout << "[OverteClient] Late reconcile: removed " << removed << " stale entities" << std::endl;
+            m_snapshotDue = true;
+        }
+        return;
+    }
+    m_initialLoad.elapsedSeconds = m_initialLoad.active
+        ? std::chrono::duration<float>(std::chrono::steady_clock::now() - m_initialLoadStart).count()
+        : 0.0f;
+    m_initialLoad.active = false;
+    m_initialLoad.complete = true;
+    std::cout << "[OverteClient] Initial load finished (" << reason << "): "
+              << m_initialLoad.entitiesReceived << " entities in " << m_initialLoad.elapsedSeconds << "s" << std::endl;
+
+    // Snapshot entities the server did not send are gone from the domain,
+    // but only once it says it has sent everything
+    if (m_unconfirmedCount > 0 && serverComplete) {
+        const std::size_t removed = removeUnconfirmed();
+        std::cout << "[OverteClient] Snapshot reconcile: removed " << removed << " stale entities" << std::endl;
+    } else if (m_unconfirmedCount > 0) {
+        std::cout << "[OverteClient] Snapshot reconcile: keeping " << m_unconfirmedCount
+                  << " unconfirmed entities until the server completes a pass" << std::endl;
+    }
+    m_snapshotDue = true;
+}
+
+void OverteClient::beginResync() {
+    // Ops still decoding belong to the old node's stream
+    m_parsePipeline.waitIdle();
+    commitParsedEntities();
+    m_world.store().forEach([&](OverteEntity& e) { markUnconfirmed(e.slot); });
+    // A new query connection ID makes the server send the whole scene and
+    // mark its end with EntityQueryInitialResultsComplete
+    ++m_queryConnectionId;
+    m_entityRate.reset();
+    // Still in the initial load: that one's reconcile covers everything
+    if (!m_initialLoad.complete) return;
+    m_resyncActive = true;
+    m_resyncStart = std::chrono::steady_clock::now();
+    m_resyncReceived = 0;
+    m_resyncChanged = 0;
+    std::cout << "[OverteClient] Resync started against " << m_unconfirmedCount << " kept entities" << std::endl;
+}
+
+void OverteClient::finishResync(const char* reason, bool serverComplete) {
+    if (!m_resyncActive) return;
+    m_resyncActive = false;
+    // Timed out: the rest may still be on its way, so unconfirmed entities
+    // stay until the marker of a complete pass arrives
+    const std::size_t removed = serverComplete ? removeUnconfirmed() : 0;
+    const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_resyncStart).count();
+    std::cout << "[OverteClient] Resync finished (" << reason << ") in " << seconds << "s: "
+              << m_resyncReceived << " entities received, " << m_resyncChanged << " changed, "
+              << removed << " removed";
+    if (!serverComplete && m_unconfirmedCount > 0) std::cout << ", " << m_unconfirmedCount << " kept unconfirmed";
+    std::cout << std::endl;
+    m_snapshotDue = true;
+}
+
+std::size_t OverteClient::removeUnconfirmed() {
+    std::size_t removed = 0;
+    for (std::uint32_t slot = 0; slot < m_unconfirmed.size(); ++slot) {
+        if (!m_unconfirmed[slot]) continue;
+        m_unconfirmed[slot] = 0;
+        if (!m_world.store().isLive(slot)) continue;
+        m_world.erase(slot);
+        markSnapshotDirty(slot);
+        ++removed;
+    }
+    m_unconfirmedCount = 0;
+    return removed;
+}
+
+void OverteClient::markUnconfirmed(std::uint32_t slot) {
+    if (slot >= m_unconfirmed.size()) m_unconfirmed.resize(slot + 1, 0);
+    if (m_unconfirmed[slot]) return;
+    m_unconfirmed[slot] = 1;
+    ++m_unconfirmedCount;
+}
+
+void OverteClient::restoreSnapshot() {
+    m_snapshotPath = WorldSnapshot::pathForDomain(m_host + "_" + std::to_string(m_port));
+    m_snapshotWriter = std::make_unique<WorldSnapshot::Writer>();
+    m_lastSnapshot = std::chrono::steady_clock::now();
+
+    WorldSnapshot::MappedFile snapshot;
+    if (!snapshot.open(m_snapshotPath)) return;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::uint32_t> parented;
+    std::size_t duplicates = 0;
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+        OverteEntity restored;
+        snapshot.decode(i, restored, m_world.strings());
+        bool created = false;
+        const std::uint32_t slot = m_world.store().emplace(restored.id, &created);
+        if (!created) {
+            // A damaged file may repeat an id: keep the first record and hand
+            // back the strings the decode interned for this one
+            m_world.strings().release(restored.name);
+            m_world.strings().release(restored.modelUrl);
+            m_world.strings().release(restored.textureUrl);
+            ++duplicates;
+            continue;
+        }
+        restored.slot = slot;
+        if (!restored.parentId.isNull()) parented.push_back(slot);
+        m_world.store().at(slot) = restored;
+        m_world.markUpdated(slot);
+        m_snapshotBuilder.update(restored, m_world.strings());
+        markUnconfirmed(slot);
+    }
+    // Link parents once every record is in the store (children may precede them)
+    for (auto slot : parented) {
+        OverteEntity& e = m_world.store().at(slot);
+        const EntityUuid parentId = e.parentId;
+        e.parentId = EntityUuid{};
+        m_world.setParent(slot, parentId, e.parentJoint);
+    }
+    const auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "[OverteClient] Restored " << snapshot.size() - duplicates << " entities from snapshot " << m_snapshotPath
+              << " in " << ms << " ms";
+    if (duplicates > 0) std::cout << " (skipped " << duplicates << " duplicate records)";
+    std::cout << std::endl;
+}
+
+void OverteClient::markSnapshotDirty(std::uint32_t slot) {
+    if (!m_snapshotWriter) return;
+    if (slot >= m_snapshotDirty.size()) m_snapshotDirty.resize(slot + 1, 0);
+    if (m_snapshotDirty[slot]) return;
+    m_snapshotDirty[slot] = 1;
+    m_snapshotDirtySlots.push_back(slot);
+}
+
+void OverteClient::captureSnapshot() {
+    m_lastSnapshot = std::chrono::steady_clock::now();
+    const bool due = m_snapshotDue;
+    m_snapshotDue = false;
+    if (m_snapshotDirtySlots.empty() && !due) return;
+
+    // Only slots touched since the last capture are re-encoded
+    for (auto slot : m_snapshotDirtySlots) {
+        m_snapshotDirty[slot] = 0;
+        if (m_world.store().isLive(slot)) {
+            m_snapshotBuilder.update(m_world.store().at(slot), m_world.strings());
+        } else {
+            m_snapshotBuilder.remove(slot);
+        }
     }
+    m_snapshotDirtySlots.clear();
+
+    std::vector<WorldSnapshot::Record> records;
+    std::vector<char> strings;
+    m_snapshotBuilder.build(records, strings);
+    m_snapshotWriter->submit(m_snapshotPath, std::move(records), std::move(strings));
 }
 
 void OverteClient::handleICEPing(const char* data, size_t len) {
@@ -913,7 +1240,8 @@ void OverteClient::handleICEPing(const char* data, size_t len) {
     std::cout << "[OverteClient] ICEPing type=" << (int)pingType << std::endl;
     
     // Send ICEPingReply with the same ICE ID and ping type
-    NLPacket reply(PacketType::ICEPingReply, 0, false);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket reply(PacketType::ICEPingReply, 0, false, m_packetArena.resource());
     if (m_localID != 0) {
         reply.setSourceID(m_localID);
     }
@@ -924,11 +1252,10 @@ void OverteClient::handleICEPing(const char* data, size_t len) {
     reply.writeUInt8(pingType);
     
     const auto& replyData = reply.getData();
-    ssize_t s = ::sendto(m_udpFd, replyData.data(), replyData.size(), 0,
-                         reinterpret_cast<sockaddr*>(&m_udpAddr), m_udpAddrLen);
+    ssize_t s = sendDatagram(m_udpFd, replyData.data(), replyData.size(), m_udpAddr, m_udpAddrLen);
     
     if (s > 0) {
-        std::cout << "[OverteClient] Sent ICEPingReply (" << s << " bytes)" << std::endl;
+        std::cout << "[OverteClient] Queued ICEPingReply (" << s << " bytes)" << std::endl;
     } else {
         std::cerr << "[OverteClient] Failed to send ICEPingReply: " << strerror(errno) << std::endl;
     }
@@ -959,7 +1286,15 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
         return;
     }
     
-    size_t offset = 0;
+    Wire::Reader reader(data, len);
+    auto uuidString = [](const Wire::Uuid::value_type& u) {
+        char buf[37];
+        snprintf(buf, sizeof(buf),
+                 "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                 u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7],
+                 u[8], u[9], u[10], u[11], u[12], u[13], u[14], u[15]);
+        return std::string(buf);
+    };
     
     // DomainList packet structure (from DomainServer.cpp sendDomainListToNode):
     // 1. Domain Session UUID (16 bytes) 
@@ -969,108 +1304,80 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
     // 5. Permissions (4 bytes)
     // 6. Authenticated (1 byte)
     // 7. More fields...
+    // Read field by field: a packet cut short still gives us our local ID.
     
-    // Read domain session UUID
-    if (offset + 16 > len) return;
-    char domainUUID[33];
-    snprintf(domainUUID, sizeof(domainUUID),
-             "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-             (unsigned char)data[offset], (unsigned char)data[offset+1],
-             (unsigned char)data[offset+2], (unsigned char)data[offset+3],
-             (unsigned char)data[offset+4], (unsigned char)data[offset+5],
-             (unsigned char)data[offset+6], (unsigned char)data[offset+7],
-             (unsigned char)data[offset+8], (unsigned char)data[offset+9],
-             (unsigned char)data[offset+10], (unsigned char)data[offset+11],
-             (unsigned char)data[offset+12], (unsigned char)data[offset+13],
-             (unsigned char)data[offset+14], (unsigned char)data[offset+15]);
-    offset += 16;
-    
-    std::cout << "[OverteClient] Domain Session UUID: " << domainUUID << std::endl;
-    
-    // Skip domain session local ID (2 bytes) - we don't need this
-    if (offset + 2 > len) return;
-    uint16_t domainSessionLocalID = ntohs(*reinterpret_cast<const uint16_t*>(data + offset));
-    offset += 2;
-    std::cout << "[OverteClient] Domain Session Local ID: " << domainSessionLocalID << std::endl;
+    // Read domain session UUID and local ID, and our node UUID (session)
+    Wire::Uuid::value_type domainUUID{}, nodeUUID{};
+    uint16_t domainSessionLocalID = 0;
+    if (!reader.read<Wire::Uuid, Wire::U16, Wire::Uuid>(domainUUID, domainSessionLocalID, nodeUUID)) return;
     
-    // Read node UUID (our session UUID)
-    if (offset + 16 > len) return;
-    char nodeUUID[33];
-    snprintf(nodeUUID, sizeof(nodeUUID),
-             "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-             (unsigned char)data[offset], (unsigned char)data[offset+1],
-             (unsigned char)data[offset+2], (unsigned char)data[offset+3],
-             (unsigned char)data[offset+4], (unsigned char)data[offset+5],
-             (unsigned char)data[offset+6], (unsigned char)data[offset+7],
-             (unsigned char)data[offset+8], (unsigned char)data[offset+9],
-             (unsigned char)data[offset+10], (unsigned char)data[offset+11],
-             (unsigned char)data[offset+12], (unsigned char)data[offset+13],
-             (unsigned char)data[offset+14], (unsigned char)data[offset+15]);
-    offset += 16;
-    
-    std::cout << "[OverteClient] Node UUID (our session): " << nodeUUID << std::endl;
+    std::cout << "[OverteClient] Domain Session UUID: " << uuidString(domainUUID) << std::endl;
+    std::cout << "[OverteClient] Domain Session Local ID: " << domainSessionLocalID << std::endl;
+    std::cout << "[OverteClient] Node UUID (our session): " << uuidString(nodeUUID) << std::endl;
     
     // Read node local ID (16-bit, BIG-ENDIAN / network byte order)
-    if (offset + 2 > len) return;
+    const size_t localIDOffset = reader.offset();
+    uint16_t localID = 0;
+    if (!reader.read<Wire::U16>(localID)) return;
     
     // Debug: show the exact bytes at this position
-    std::cout << "[OverteClient] Node LocalID bytes at offset " << offset << ": "
-              << std::hex << std::setfill('0') << std::setw(2) << (int)(unsigned char)data[offset] << " "
-              << std::setw(2) << (int)(unsigned char)data[offset+1] << std::dec << std::endl;
-    
-    uint16_t localID = ntohs(*reinterpret_cast<const uint16_t*>(data + offset)); // Big-endian!
-    offset += 2;
+    std::cout << "[OverteClient] Node LocalID bytes at offset " << localIDOffset << ": "
+              << std::hex << std::setfill('0') << std::setw(2) << (int)(unsigned char)data[localIDOffset] << " "
+              << std::setw(2) << (int)(unsigned char)data[localIDOffset+1] << std::dec << std::endl;
     
     // Store our local ID for use in sourced packets
+    const std::uint16_t previousLocalID = m_localID;
     m_localID = localID;
     
     std::cout << "[OverteClient] Node Local ID (ours!): " << localID << " (0x" << std::hex << localID << std::dec << ")" << std::endl;
     
     // Read permissions (32-bit)
-    if (offset + 4 > len) return;
-    uint32_t permissions = ntohl(*reinterpret_cast<const uint32_t*>(data + offset));
-    offset += 4;
+    uint32_t permissions = 0;
+    if (!reader.read<Wire::U32>(permissions)) return;
     
     std::cout << "[OverteClient] Permissions: 0x" << std::hex << permissions << std::dec << std::endl;
     
     // Read authenticated flag
-    if (offset + 1 > len) return;
-    bool authenticated = data[offset++];
+    bool authenticated = false;
+    if (!reader.read<Wire::Bool>(authenticated)) return;
     
     std::cout << "[OverteClient] Authenticated: " << (authenticated ? "yes" : "no") << std::endl;
     
     // Read additional timing/metadata fields (from Overte's DomainServer::sendDomainListToNode)
-    // These fields were added after the authenticated flag
-    if (offset + 8 > len) {
+    // These fields were added after the authenticated flag:
+    // lastDomainCheckinTimestamp, currentTimestamp, processingTime (uint64 each)
+    uint64_t lastCheckinTimestamp = 0, currentTimestamp = 0, processingTime = 0;
+    if (!Payload::DomainListTimes::read(reader, lastCheckinTimestamp, currentTimestamp, processingTime)) {
         std::cout << "[OverteClient] Packet too short for timing fields" << std::endl;
         return;
     }
     
-    // lastDomainCheckinTimestamp (uint64)
-    uint64_t lastCheckinTimestamp;
-    std::memcpy(&lastCheckinTimestamp, data + offset, 8);
-    lastCheckinTimestamp = be64toh(lastCheckinTimestamp);
-    offset += 8;
-    
-    if (offset + 8 > len) return;
-    // currentTimestamp (uint64)
-    uint64_t currentTimestamp;
-    std::memcpy(&currentTimestamp, data + offset, 8);
-    currentTimestamp = be64toh(currentTimestamp);
-    offset += 8;
-    
-    if (offset + 8 > len) return;
-    // processingTime (uint64)
-    uint64_t processingTime;
-    std::memcpy(&processingTime, data + offset, 8);
-    processingTime = be64toh(processingTime);
-    offset += 8;
-    
-    if (offset + 1 > len) return;
     // newConnection (bool)
-    bool newConnection = data[offset++];
+    bool newConnection = false;
+    if (!reader.read<Wire::Bool>(newConnection)) return;
+    const size_t offset = reader.offset();
     
     std::cout << "[OverteClient] New connection: " << (newConnection ? "yes" : "no") << std::endl;
+
+    // After an outage: did the server keep our node?
+    const bool newNode = newConnection || (previousLocalID != 0 && previousLocalID != localID);
+    switch (m_link.joined(std::chrono::steady_clock::now(), newNode)) {
+        case SessionLink::Join::First:
+            break;
+        case SessionLink::Join::Resumed:
+            if (!m_domainConnected) {
+                std::cout << "[OverteClient] Session resumed after "
+                          << std::chrono::duration<float>(m_link.lastOutage()).count()
+                          << "s; the entity server continues where it left off" << std::endl;
+            }
+            break;
+        case SessionLink::Join::Rejoined:
+            std::cout << "[OverteClient] Reconnected after "
+                      << std::chrono::duration<float>(m_link.lastOutage()).count()
+                      << "s as a new node; resyncing entities" << std::endl;
+            beginResync();
+            break;
+    }
     
     // Now mark as connected since we got a valid DomainList
     m_domainConnected = true;
@@ -1078,6 +1385,7 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
     // Clear previous assignment client list
     m_assignmentClients.clear();
     m_entityServerPort = 0;
+    m_assetServerPort = 0;
     
     std::cout << "[OverteClient] Bytes remaining after header: " << (len - offset) << std::endl;
     std::cout << "[OverteClient] Remaining bytes (hex): ";
@@ -1087,17 +1395,17 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
     std::cout << std::endl;
     
     // Check if this might be a count field (QDataStream format often starts with a count)
-    if (len - offset >= 4) {
-        uint32_t possibleCount = ntohl(*reinterpret_cast<const uint32_t*>(data + offset));
+    uint32_t possibleCount = 0;
+    if (Wire::Schema<Wire::U32>::decode(data + offset, len - offset, possibleCount)) {
         std::cout << "[OverteClient] First 4 bytes as uint32 (big-endian): " << possibleCount << std::endl;
     }
-    if (len - offset >= 2) {
-        uint16_t possibleCount16 = ntohs(*reinterpret_cast<const uint16_t*>(data + offset));
+    uint16_t possibleCount16 = 0, possibleCount16_le = 0;
+    if (Wire::Schema<Wire::U16>::decode(data + offset, len - offset, possibleCount16)) {
         std::cout << "[OverteClient] First 2 bytes as uint16 (big-endian): " << possibleCount16 << std::endl;
         
         // New observation: those 2 bytes might be flags or a node count
         // Let's interpret them as little-endian too
-        uint16_t possibleCount16_le = *reinterpret_cast<const uint16_t*>(data + offset);
+        Wire::Schema<Wire::U16LE>::decode(data + offset, len - offset, possibleCount16_le);
         std::cout << "[OverteClient] First 2 bytes as uint16 (little-endian): " << possibleCount16_le << std::endl;
         std::cout << "[OverteClient] As individual bytes: 0x" << std::hex << (int)(unsigned char)data[offset] 
                   << " 0x" << (int)(unsigned char)data[offset+1] << std::dec << std::endl;
@@ -1119,37 +1427,19 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
     
     std::cout << "[OverteClient] Parsing assignment clients..." << std::endl;
     
-    while (offset < len) {
+    while (reader.remaining() > 0) {
         AssignmentClient ac;
         
-        // Read NodeType (qint8)
-        if (offset + 1 > len) break;
-        ac.type = static_cast<uint8_t>(data[offset++]);
-        
-        // Read UUID (16 bytes)
-        if (offset + 16 > len) break;
-        std::memcpy(ac.uuid.data(), data + offset, 16);
-        offset += 16;
-        
-        // Read PublicSocket.type (quint8)
-        if (offset + 1 > len) break;
-        uint8_t publicSocketType = static_cast<uint8_t>(data[offset++]);
-        
-        // Read PublicSocket.address (QHostAddress)
-        if (offset + 1 > len) break;
-        uint8_t addressProtocol = static_cast<uint8_t>(data[offset++]);
+        // NodeType, UUID, PublicSocket.type and address protocol
+        uint8_t publicSocketType = 0, addressProtocol = 0;
+        if (!Payload::NodeHead::read(reader, ac.type, ac.uuid, publicSocketType, addressProtocol)) break;
+        (void)publicSocketType; // unused for now
         
         if (addressProtocol == 1) { // IPv4
-            if (offset + 4 > len) break;
-            uint32_t ipv4Addr;
-            std::memcpy(&ipv4Addr, data + offset, 4);
-            ipv4Addr = ntohl(ipv4Addr);
-            offset += 4;
-            
-            // Read PublicSocket.port (quint16)
-            if (offset + 2 > len) break;
-            uint16_t publicPort = ntohs(*reinterpret_cast<const uint16_t*>(data + offset));
-            offset += 2;
+            // PublicSocket address and port
+            uint32_t ipv4Addr = 0;
+            uint16_t publicPort = 0;
+            if (!Payload::SocketV4::read(reader, ipv4Addr, publicPort)) break;
             
             // Store address
             sockaddr_in* addr = reinterpret_cast<sockaddr_in*>(&ac.address);
@@ -1164,45 +1454,30 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
             break;
         }
         
-        // Read LocalSocket.type (quint8)
-        if (offset + 1 > len) break;
-        uint8_t localSocketType = static_cast<uint8_t>(data[offset++]);
+        // LocalSocket.type and address protocol
+        uint8_t localSocketType = 0, localAddressProtocol = 0;
+        if (!Payload::SocketHead::read(reader, localSocketType, localAddressProtocol)) break;
         (void)localSocketType; // unused for now
         
-        // Read LocalSocket.address (QHostAddress)
-        if (offset + 1 > len) break;
-        uint8_t localAddressProtocol = static_cast<uint8_t>(data[offset++]);
-        
         if (localAddressProtocol == 1) { // IPv4
-            if (offset + 4 > len) break;
-            offset += 4; // Skip local IP
-            
-            // Read LocalSocket.port (quint16)
-            if (offset + 2 > len) break;
-            offset += 2; // Skip local port
+            // Skip local IP and port
+            uint32_t localIPv4 = 0;
+            uint16_t localPort = 0;
+            if (!Payload::SocketV4::read(reader, localIPv4, localPort)) break;
         } else {
             std::cout << "[OverteClient] Unsupported local address protocol: " << (int)localAddressProtocol << std::endl;
             break;
         }
         
-        // Read Permissions (quint32)
-        if (offset + 4 > len) break;
-        offset += 4; // Skip permissions
-        
-        // Read isReplicated (bool)
-        if (offset + 1 > len) break;
-        offset++; // Skip isReplicated
+        // Permissions and isReplicated (skipped), localID, and the
+        // connectionSecretUUID added by the DomainList packet
+        uint32_t nodePermissions = 0;
+        bool replicated = false;
+        if (!Payload::NodeTail::read(reader, nodePermissions, replicated, ac.localID, ac.connectionSecret)) break;
         
-        // Read localID (quint16)
-        if (offset + 2 > len) break;
-        offset += 2; // Skip localID
-        
-        // Read connectionSecretUUID (16 bytes) - this is added by DomainList packet
-        if (offset + 16 > len) break;
-        offset += 16; // Skip connectionSecretUUID
-        
-        // Store this assignment client
+        // Store this assignment client; its secret keys the packets between us
         m_assignmentClients.push_back(ac);
+        m_verifier.setPeer(ac.localID, ac.connectionSecret);
         
         // NodeType mapping (from Overte NodeType.h):
         // 'D' (0x44) = DomainServer
@@ -1235,6 +1510,8 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
         
         // If this is the EntityServer, store its address for EntityQuery
         if (ac.type == 'o') { // EntityServer
+            // A different server starts over from the initial packet rate
+            if (ac.port != m_entityServerPort) m_entityRate.reset();
             m_entityServerAddr = ac.address;
             m_entityServerAddrLen = ac.addressLen;
             m_entityServerPort = ac.port;
@@ -1250,9 +1527,24 @@ void OverteClient::handleDomainListReply(const char* data, size_t len) {
             
             std::cout << "[OverteClient] Avatar Mixer found at " << addrStr << ":" << ac.port << std::endl;
         }
+
+        // Asset server: atp:// downloads, verified with its connection secret
+        if (ac.type == 'A') {
+            if (ac.localID != m_assetServerLocalID || !sameEndpoint(ac.address, m_assetServerAddr)) resetAssetLink();
+            m_assetServerAddr = ac.address;
+            m_assetServerAddrLen = ac.addressLen;
+            m_assetServerPort = ac.port;
+            m_assetServerLocalID = ac.localID;
+
+            std::cout << "[OverteClient] Asset server found at " << addrStr << ":" << ac.port << std::endl;
+        }
     }
     
     std::cout << "[OverteClient] Parsed " << m_assignmentClients.size() << " assignment clients" << std::endl;
+    m_verifier.retainPeers([&](uint16_t id) {
+        return std::any_of(m_assignmentClients.begin(), m_assignmentClients.end(),
+                           [&](const AssignmentClient& ac) { return ac.localID == id; });
+    });
     
     // TEMPORARY HACK: If no Avatar Mixer found, try the known address from web UI
     if (m_avatarMixerPort == 0) {
@@ -1339,11 +1631,12 @@ void OverteClient::sendDomainConnectRequest() {
     
     // DomainConnectRequest is in NON_SOURCED_PACKETS - it should NOT have a source ID field
     // because we don't have a Local ID yet (server assigns it in DomainList response)
-    NLPacket packet(PacketType::DomainConnectRequest, PacketVersions::DomainConnectRequest_SocketTypes, false);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::DomainConnectRequest, PacketVersions::DomainConnectRequest_SocketTypes, false, m_packetArena.resource());
     packet.setSequenceNumber(m_sequenceNumber++);
     
     // Build payload using Qt wire format (match Overte's NodeList.cpp structure exactly)
-    QtStream qs;
+    QtStream qs(m_packetArena.resource());
     
     // 1. UUID
     qs.writeQUuidFromString(m_sessionUUID);
@@ -1487,7 +1780,7 @@ void OverteClient::sendDomainConnectRequest() {
     ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0, 
                          reinterpret_cast<sockaddr*>(&m_udpAddr), m_udpAddrLen);
     if (s > 0) {
-        std::cout << "[OverteClient] DomainConnectRequest sent (" << s << " bytes, seq=" << (m_sequenceNumber-1) << ")" << std::endl;
+        std::cout << "[OverteClient] DomainConnectRequest queued (" << s << " bytes, seq=" << (m_sequenceNumber-1) << ")" << std::endl;
         std::cout << "[OverteClient]   Session UUID: " << m_sessionUUID << std::endl;
     // Print MD5 signature in hex for diff against reference Overte client
     std::ostringstream md5hex; md5hex << std::hex << std::setfill('0');
@@ -1511,7 +1804,8 @@ void OverteClient::sendDomainConnectRequest() {
         std::cout << "[OverteClient]       UUID (16 bytes)" << std::endl;
         std::cout << "[OverteClient]       Protocol sig length (4 bytes): ";
         if (qs.buf.size() >= 20) {
-            uint32_t sigLen = (qs.buf[16] << 24) | (qs.buf[17] << 16) | (qs.buf[18] << 8) | qs.buf[19];
+            uint32_t sigLen = 0;
+            Wire::Schema<Wire::U32>::decode(qs.buf.data() + 16, 4, sigLen);
             std::cout << sigLen << std::endl;
             std::cout << "[OverteClient]       Protocol sig data (" << sigLen << " bytes at offset 20): ";
             for (size_t i = 20; i < 20 + sigLen && i < qs.buf.size(); ++i) {
@@ -1551,7 +1845,8 @@ void OverteClient::sendDomainListRequest() {
     if (!m_udpReady || m_udpFd == -1) return;
     
     // Create NLPacket with DomainListRequest type and correct version
-    NLPacket packet(PacketType::DomainListRequest, PacketVersions::DomainListRequest_SocketTypes, true);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::DomainListRequest, PacketVersions::DomainListRequest_SocketTypes, true, m_packetArena.resource());
     packet.setSequenceNumber(m_sequenceNumber++);
     
     // DomainListRequest has no payload, just the header
@@ -1560,90 +1855,141 @@ void OverteClient::sendDomainListRequest() {
     ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0, 
                          reinterpret_cast<sockaddr*>(&m_udpAddr), m_udpAddrLen);
     if (s > 0) {
-        std::cout << "[OverteClient] DomainListRequest sent (seq=" << (m_sequenceNumber-1) << ")" << std::endl;
+        std::cout << "[OverteClient] DomainListRequest queued (seq=" << (m_sequenceNumber-1) << ")" << std::endl;
     } else {
         std::cerr << "[OverteClient] Failed to send domain list request: " << strerror(errno) << std::endl;
     }
 }
 
-void OverteClient::sendACK(uint32_t sequenceNumber) {
+ssize_t OverteClient::sendDatagram(int fd, const void* data, size_t len, const sockaddr_storage& to, socklen_t toLen) {
+    // Queued on the ring and submitted with the rest at the end of poll().
+    // The length returned only means queued; a send that then fails shows
+    // up in noteSendFailures().
+    if (fd == m_udpFd && m_domainRing && m_domainRing->send(data, len, to, toLen)) {
+        return static_cast<ssize_t>(len);
+    }
+    return ::sendto(fd, data, len, 0, reinterpret_cast<const sockaddr*>(&to), toLen);
+}
+
+void OverteClient::sendControl(const UdtConnection::Control& control, const sockaddr_storage& to, socklen_t toLen) {
     if (!m_udpReady || m_udpFd == -1) return;
     
-    // ACK is a control packet with minimal structure:
-    // - 4 bytes: sequence+flags with Control bit (bit 31) set + sequence of ACK packet itself
-    // - 1 byte: Control packet type (0 = ACK)
-    // - 4 bytes: sequence number being acknowledged
-    
-    uint8_t ackPacket[9];
-    
-    // Control bit (bit 31) set, plus our own sequence for this ACK packet
-    uint32_t controlSeqAndFlags = 0x80000000 | (m_sequenceNumber++ & 0x7FFFFFFF);
-    ackPacket[0] = (controlSeqAndFlags >> 24) & 0xFF;
-    ackPacket[1] = (controlSeqAndFlags >> 16) & 0xFF;
-    ackPacket[2] = (controlSeqAndFlags >> 8) & 0xFF;
-    ackPacket[3] = controlSeqAndFlags & 0xFF;
-    
-    // Control packet type: ACK = 0
-    ackPacket[4] = 0;
-    
-    // Sequence number being acknowledged (big-endian)
-    ackPacket[5] = (sequenceNumber >> 24) & 0xFF;
-    ackPacket[6] = (sequenceNumber >> 16) & 0xFF;
-    ackPacket[7] = (sequenceNumber >> 8) & 0xFF;
-    ackPacket[8] = sequenceNumber & 0xFF;
-    
-    ssize_t s = ::sendto(m_udpFd, ackPacket, sizeof(ackPacket), 0,
-                         reinterpret_cast<const sockaddr*>(&m_udpAddr), m_udpAddrLen);
+    uint8_t packet[UdtConnection::kMaxControlSize];
+    const size_t size = UdtConnection::write(control, packet);
+    ssize_t s = sendDatagram(m_udpFd, packet, size, to, toLen);
     if (s < 0 && errno != EWOULDBLOCK && errno != EAGAIN) {
-        std::cerr << "[OverteClient] ACK send failed: " << strerror(errno) << std::endl;
-    } else {
-        std::cout << "[OverteClient] Sent ACK for sequence " << sequenceNumber << std::endl;
+        std::cerr << "[OverteClient] Control packet send failed: " << strerror(errno) << std::endl;
+    } else if (DebugLog::debugNetworkPackets) {
+        std::cout << "[OverteClient] Queued control packet type " << static_cast<int>(control.type)
+                  << " (" << control.value << ")" << std::endl;
+    }
+}
+
+void OverteClient::sendAssetPacket(PacketType type, const std::vector<std::uint8_t>& payload) {
+    if (!m_udpReady || m_udpFd == -1 || m_assetServerPort == 0) return;
+    // Numbered in the asset server's own sequence space, which opens once
+    // it has acknowledged our handshake (sent from poll)
+    if (!m_assetLink.established()) {
+        m_assetBacklog.emplace_back(type, payload);
+        return;
+    }
+
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(type, NLPacket::versionForPacketType(type), true, m_packetArena.resource());
+    packet.setSequenceNumber(m_assetLink.nextSequence());
+    packet.setSourceID(m_localID);
+    packet.write(payload.data(), payload.size());
+    // Keyed with the asset server's connection secret, pads hashed once. The
+    // verifier holds no key for a null secret; sign with that anyway.
+    static const PacketVerifier::Secret nullSecret{};
+    static const HmacMd5 nullKey(nullSecret.data(), nullSecret.size());
+    const HmacMd5* key = m_verifier.key(m_assetServerLocalID);
+    packet.writeVerificationHash(key ? *key : nullKey);
+
+    const auto& data = packet.getData();
+    ssize_t s = sendDatagram(m_udpFd, data.data(), data.size(), m_assetServerAddr, m_assetServerAddrLen);
+    if (s < 0 && errno != EWOULDBLOCK && errno != EAGAIN) {
+        std::cerr << "[OverteClient] Asset request send failed: " << strerror(errno) << std::endl;
     }
 }
 
+void OverteClient::resetAssetLink() {
+    m_assetLink = UdtConnection(randomSequence());
+    m_assetBacklog.clear();
+    m_assetAckDue = false;
+}
+
 void OverteClient::handlePing(const char* payload, size_t len) {
-    // Ping packet format:
-    // - uint64: timestamp (microseconds)
+    // Ping packet format (little-endian):
     // - uint8: ping type (0=local, 1=public)
-    // - [optional] uint16: connection ID
+    // - uint64: sender's timestamp (microseconds)
+    // - int64: sender's connection ID
     
-    if (len < 9) {
+    // Read ping type and timestamp (we'll echo both back)
+    uint8_t pingType = 0;
+    uint64_t timestamp = 0;
+    int64_t connectionId = 0;
+    if (!Payload::Ping::decode(payload, len, pingType, timestamp, connectionId)) {
         std::cerr << "[OverteClient] Ping packet too short: " << len << " bytes" << std::endl;
         return;
     }
     
-    // Read timestamp (we'll echo it back)
-    uint64_t timestamp = 0;
-    for (int i = 0; i < 8; i++) {
-        timestamp = (timestamp << 8) | (unsigned char)payload[i];
-    }
-    
-    uint8_t pingType = payload[8];
-    
     // Send PingReply
-    NLPacket packet(PacketType::PingReply, PacketVersions::Ping_IncludeConnectionID, false);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::PingReply, PacketVersions::Ping_IncludeConnectionID, false, m_packetArena.resource());
     if (m_localID != 0) {
         packet.setSourceID(m_localID);
     }
     packet.setSequenceNumber(m_sequenceNumber++);
     
-    // Echo back the timestamp
-    packet.writeUInt64(timestamp);
-    
-    // Ping type
-    packet.writeUInt8(pingType);
+    // Echo back the ping type and timestamp, then our own clock
+    Payload::PingReply::append(packet, pingType, timestamp, static_cast<uint64_t>(ClockSync::nowUs()));
     
     const auto& data = packet.getData();
-    ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0,
-                         reinterpret_cast<const sockaddr*>(&m_udpAddr), m_udpAddrLen);
+    ssize_t s = sendDatagram(m_udpFd, data.data(), data.size(), m_udpAddr, m_udpAddrLen);
     if (s < 0 && errno != EWOULDBLOCK && errno != EAGAIN) {
         std::cerr << "[OverteClient] PingReply send failed: " << strerror(errno) << std::endl;
     }
 }
 
+void OverteClient::handlePingReply(const char* payload, size_t len, char peerType,
+                                   std::chrono::steady_clock::time_point rxTime) {
+    // PingReply format (little-endian):
+    // - uint8: ping type, echoed
+    // - uint64: our Ping timestamp, echoed (microseconds)
+    // - uint64: the peer's clock when it replied (microseconds)
+    uint8_t pingType = 0;
+    uint64_t sent = 0, peer = 0;
+    if (!Payload::PingReply::decode(payload, len, pingType, sent, peer)) {
+        std::cerr << "[OverteClient] PingReply too short: " << len << " bytes" << std::endl;
+        return;
+    }
+    const std::int64_t sentUs = static_cast<std::int64_t>(sent);
+    const std::int64_t peerUs = static_cast<std::int64_t>(peer);
+    // Receive time on the Ping clock, taken from the (kernel) arrival time
+    const std::int64_t receivedUs = ClockSync::nowUs() -
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - rxTime).count();
+
+    PeerClock& clock = m_clockSync.peer(peerType);
+    if (!clock.addSample(sentUs, receivedUs, peerUs)) {
+        std::cerr << "[OverteClient] Ignoring PingReply from '" << peerType << "' with RTT "
+                  << (receivedUs - sentUs) << " us" << std::endl;
+        return;
+    }
+    if (DebugLog::debugNetworkPackets || clock.samples() == 1) {
+        std::cout << "[OverteClient] PingReply from '" << peerType << "': rtt=" << clock.lastRtt().count()
+                  << " us srtt=" << clock.srtt().count() << " us rttvar=" << clock.rttVar().count() << " us";
+        if (clock.hasOffset()) {
+            std::cout << " offset=" << clock.offset().count() << " +/- " << clock.offsetError().count() << " us";
+        }
+        std::cout << std::endl;
+    }
+}
+
 void OverteClient::sendPing(int fd, const sockaddr_storage& addr, socklen_t addrLen) {
     // Create NLPacket for Ping with correct version
-    NLPacket packet(PacketType::Ping, PacketVersions::Ping_IncludeConnectionID, false);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::Ping, PacketVersions::Ping_IncludeConnectionID, false, m_packetArena.resource());
     
     // Set source ID and sequence number
     if (m_localID != 0) {
@@ -1651,42 +1997,39 @@ void OverteClient::sendPing(int fd, const sockaddr_storage& addr, socklen_t addr
     }
     packet.setSequenceNumber(m_sequenceNumber++);
     
-    // Add timestamp (microseconds since epoch)
-    auto now = std::chrono::system_clock::now();
-    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
-    packet.writeUInt64(micros);
-    
-    // Ping type (0 = local, 1 = public)
-    packet.writeUInt8(0);
+    // Ping type (0 = local, 1 = public), timestamp (microseconds since epoch)
+    // and our connection ID
+    Payload::Ping::append(packet, 0, static_cast<uint64_t>(ClockSync::nowUs()), m_pingConnectionId);
     
     // Do NOT write verification hash - this creates a 17-byte sourced packet without hash
     // The server should either skip verification or use the packet structure to determine hash presence
     
     const auto& data = packet.getData();
     
-    // Debug: show destination address
-    char destIP[INET6_ADDRSTRLEN];
-    int destPort = 0;
-    if (addr.ss_family == AF_INET) {
-        auto* sin = reinterpret_cast<const sockaddr_in*>(&addr);
-        inet_ntop(AF_INET, &sin->sin_addr, destIP, sizeof(destIP));
-        destPort = ntohs(sin->sin_port);
-    } else if (addr.ss_family == AF_INET6) {
-        auto* sin6 = reinterpret_cast<const sockaddr_in6*>(&addr);
-        inet_ntop(AF_INET6, &sin6->sin6_addr, destIP, sizeof(destIP));
-        destPort = ntohs(sin6->sin6_port);
-    }
-    
-    // Debug: hex dump ping packet
-    std::cout << "[OverteClient] Ping packet (" << data.size() << " bytes, localID=" << m_localID 
-              << ") to " << destIP << ":" << destPort << " - ";
-    for (size_t i = 0; i < std::min(data.size(), size_t(32)); i++) {
-        printf("%02x ", (unsigned char)data[i]);
+    if (DebugLog::debugNetworkPackets) {
+        // Debug: show destination address
+        char destIP[INET6_ADDRSTRLEN] = "?";
+        int destPort = 0;
+        if (addr.ss_family == AF_INET) {
+            auto* sin = reinterpret_cast<const sockaddr_in*>(&addr);
+            inet_ntop(AF_INET, &sin->sin_addr, destIP, sizeof(destIP));
+            destPort = ntohs(sin->sin_port);
+        } else if (addr.ss_family == AF_INET6) {
+            auto* sin6 = reinterpret_cast<const sockaddr_in6*>(&addr);
+            inet_ntop(AF_INET6, &sin6->sin6_addr, destIP, sizeof(destIP));
+            destPort = ntohs(sin6->sin6_port);
+        }
+        
+        // Debug: hex dump ping packet
+        std::cout << "[OverteClient] Ping packet (" << data.size() << " bytes, localID=" << m_localID 
+                  << ") to " << destIP << ":" << destPort << " - ";
+        for (size_t i = 0; i < std::min(data.size(), size_t(32)); i++) {
+            printf("%02x ", (unsigned char)data[i]);
+        }
+        std::cout << std::endl;
     }
-    std::cout << std::endl;
     
-    ssize_t s = ::sendto(fd, data.data(), data.size(), 0, 
-                         reinterpret_cast<const sockaddr*>(&addr), addrLen);
+    ssize_t s = sendDatagram(fd, data.data(), data.size(), addr, addrLen);
     if (s < 0 && errno != EWOULDBLOCK && errno != EAGAIN) {
         std::cerr << "[OverteClient] Ping send failed: " << strerror(errno) << std::endl;
     }
@@ -1702,7 +2045,8 @@ void OverteClient::sendEntityQuery() {
         m_entityServerAddrLen : m_udpAddrLen;
     
     // Create EntityQuery packet (PacketType::EntityQuery = 0x29)
-    NLPacket packet(PacketType::EntityQuery, 0, true);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::EntityQuery, 0, true, m_packetArena.resource());
     // Include our local ID (sourced packet)
     if (m_localID != 0) {
         packet.setSourceID(m_localID);
@@ -1720,58 +2064,15 @@ void OverteClient::sendEntityQuery() {
     // 8. JSON parameters (if size > 0)
     // 9. Query flags (uint16)
     
-    std::vector<uint8_t> payload;
-    auto writeU16 = [&](uint16_t v) {
-        payload.push_back((v >> 8) & 0xFF);
-        payload.push_back(v & 0xFF);
-    };
-    auto writeU8 = [&](uint8_t v) { payload.push_back(v); };
-    auto writeI32 = [&](int32_t v) {
-        payload.push_back((v >> 24) & 0xFF);
-        payload.push_back((v >> 16) & 0xFF);
-        payload.push_back((v >> 8) & 0xFF);
-        payload.push_back(v & 0xFF);
-    };
-    auto writeF32 = [&](float v) {
-        uint32_t bits;
-        std::memcpy(&bits, &v, sizeof(float));
-        writeI32(static_cast<int32_t>(bits));
-    };
-    
-    // 1. Connection ID - use 0 for initial query
-    static uint16_t connectionID = 0;
-    writeU16(connectionID);
-    
-    // 2. Number of frustums - 0 to request all entities
-    writeU8(0);
-    
-    // 3. No frustum data since numFrustums = 0
-    
-    // 4. Max octree PPS - 3000 is typical
-    writeI32(3000);
-    
-    // 5. Octree size scale - 1.0 is default
-    writeF32(1.0f);
-    
-    // 6. Boundary level adjust - 0 is default
-    writeI32(0);
-    
-    // 7. JSON parameters size - 0 (no filters)
-    writeU16(0);
-    
-    // 8. No JSON parameters
-    
-    // 9. Query flags - 0x1 = WantInitialCompletion
-    writeU16(0x1);
-    
-    // Write payload to packet
-    if (!payload.empty()) {
-        packet.write(payload.data(), payload.size());
-    }
+    // Connection ID (0 for the initial query), no frustums (all entities),
+    // max PPS adapted to what we can process (EntityRateController), default
+    // octree scale and boundary level, no JSON parameters, and
+    // WantInitialCompletion
+    const int maxPps = m_entityRate.pps();
+    Payload::EntityQuery::append(packet, m_queryConnectionId, 0, maxPps, 1.0f, 0, 0, 0x1);
     
     const auto& data = packet.getData();
-    ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0, 
-                         reinterpret_cast<const sockaddr*>(targetAddr), targetAddrLen);
+    ssize_t s = sendDatagram(m_udpFd, data.data(), data.size(), *targetAddr, targetAddrLen);
     
     if (s > 0) {
         char addrStr[INET_ADDRSTRLEN] = "unknown";
@@ -1781,20 +2082,24 @@ void OverteClient::sendEntityQuery() {
         }
         
         const char* targetName = (m_entityServerPort != 0) ? "entity-server" : "domain-server";
-        std::cout << "[OverteClient] Sent EntityQuery to " << targetName 
+        std::cout << "[OverteClient] Queued EntityQuery to " << targetName 
                   << " (" << addrStr << ":" << ntohs(reinterpret_cast<const sockaddr_in*>(targetAddr)->sin_port)
-                  << ", " << s << " bytes, seq=" << (m_sequenceNumber-1) << ")" << std::endl;
+                  << ", " << s << " bytes, seq=" << (m_sequenceNumber-1) << ", maxPPS=" << maxPps
+                  << ", " << m_entityRate.costPerPacketUs() << " us/packet)" << std::endl;
+        m_entityRate.markSent(std::chrono::steady_clock::now());
         
         if (DebugLog::debugEntityPackets) {
             std::cout << "[EntityQuery Details]" << std::endl;
-            std::cout << "  Connection ID: " << connectionID << std::endl;
+            std::cout << "  Connection ID: " << m_queryConnectionId << std::endl;
             std::cout << "  Num frustums: 0 (requesting all entities)" << std::endl;
-            std::cout << "  Max PPS: 3000" << std::endl;
+            std::cout << "  Max PPS: " << maxPps << std::endl;
             std::cout << "  Octree scale: 1.0" << std::endl;
             std::cout << "  Flags: 0x1 (WantInitialCompletion)" << std::endl;
-            std::cout << "  Payload size: " << payload.size() << " bytes" << std::endl;
+            std::cout << "  Payload size: " << Payload::EntityQuery::fixedSize << " bytes" << std::endl;
         }
     } else {
+        // The sent rate stays as it was; the controller spaces out retries
+        m_entityRate.markFailed(std::chrono::steady_clock::now());
         std::cerr << "[OverteClient] Failed to send EntityQuery: " << strerror(errno) << std::endl;
     }
 }
@@ -1803,21 +2108,13 @@ void OverteClient::sendMovementInput(const glm::vec3& linearVelocity) {
     (void)linearVelocity; // TODO: send to avatar mixer
 }
 
-std::vector<OverteEntity> OverteClient::consumeUpdatedEntities() {
-    std::vector<OverteEntity> out;
-    out.reserve(m_updateQueue.size());
-    for (auto id : m_updateQueue) {
-        auto it = m_entities.find(id);
-        if (it != m_entities.end()) out.push_back(it->second);
-    }
-    m_updateQueue.clear();
-    return out;
-}
-
-std::vector<std::uint64_t> OverteClient::consumeDeletedEntities() {
-    std::vector<std::uint64_t> out;
-    out.swap(m_deleteQueue); // efficient clear
-    return out;
+void OverteClient::shrinkBuffers() {
+    // Runs between frames: nothing holds entity pointers, the bulk lane keeps
+    // the datagrams it has queued. The transform scratch is left alone: it is
+    // refilled every frame, so freeing it would only move the allocation.
+    m_world.shrink();
+    m_bulkLane.shrink();
+    releaseSpare(m_entityBuffer);
 }
 
 void OverteClient::createEntity(const std::string& name, EntityType type, const glm::vec3& position,
@@ -1836,7 +2133,8 @@ void OverteClient::createEntity(const std::string& name, EntityType type, const
               << position.x << ", " << position.y << ", " << position.z << ")" << std::endl;
     
     // Create EntityAdd packet (PacketType::EntityAdd = 0x3A)
-    NLPacket packet(PacketType::EntityAdd, 0, true);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::EntityAdd, 0, true, m_packetArena.resource());
     packet.setSourceID(m_localID);
     packet.setSequenceNumber(m_sequenceNumber++);
     
@@ -1847,42 +2145,6 @@ void OverteClient::createEntity(const std::string& name, EntityType type, const
     // 4. Entity ID flags (uint8) - 0x00 for server-generated ID
     // 5. Entity properties encoded as key-value pairs
     
-    std::vector<uint8_t> payload;
-    
-    // Helper lambdas for writing data in network byte order
-    auto writeU8 = [&](uint8_t v) { payload.push_back(v); };
-    auto writeU16 = [&](uint16_t v) {
-        payload.push_back((v >> 8) & 0xFF);
-        payload.push_back(v & 0xFF);
-    };
-    auto writeU32 = [&](uint32_t v) {
-        payload.push_back((v >> 24) & 0xFF);
-        payload.push_back((v >> 16) & 0xFF);
-        payload.push_back((v >> 8) & 0xFF);
-        payload.push_back(v & 0xFF);
-    };
-    auto writeU64 = [&](uint64_t v) {
-        for (int i = 7; i >= 0; --i) {
-            payload.push_back((v >> (i * 8)) & 0xFF);
-        }
-    };
-    auto writeF32 = [&](float v) {
-        uint32_t bits;
-        std::memcpy(&bits, &v, sizeof(float));
-        writeU32(bits);
-    };
-    auto writeVec3 = [&](const glm::vec3& v) {
-        writeF32(v.x);
-        writeF32(v.y);
-        writeF32(v.z);
-    };
-    auto writeString = [&](const std::string& s) {
-        writeU16(static_cast<uint16_t>(s.length()));
-        for (char c : s) {
-            payload.push_back(static_cast<uint8_t>(c));
-        }
-    };
-    
     // 1. Entity type - convert our EntityType to Overte's entity type codes
     uint8_t overtypeType = 0;
     switch (type) {
@@ -1892,18 +2154,13 @@ void OverteClient::createEntity(const std::string& name, EntityType type, const
         case EntityType::Shape: overtypeType = 4; break;
         default: overtypeType = 1; break; // Default to Box
     }
-    writeU8(overtypeType);
     
-    // 2. Creation time (current time in microseconds)
+    // 2-4. Creation time (current time in microseconds), last edited time
+    // (same as creation time), ID flags 0x00 to let the server assign the ID
     auto now = std::chrono::system_clock::now();
-    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
-    writeU64(static_cast<uint64_t>(micros));
-    
-    // 3. Last edited time (same as creation time)
-    writeU64(static_cast<uint64_t>(micros));
-    
-    // 4. Entity ID flags - 0x00 means let server assign ID
-    writeU8(0x00);
+    const auto micros = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count());
+    Payload::EntityAddHeader::append(packet, overtypeType, micros, micros, 0x00);
     
     // 5. Entity properties (encoded as a property list)
     // Property encoding format: property ID (uint16) + property data
@@ -1918,38 +2175,30 @@ void OverteClient::createEntity(const std::string& name, EntityType type, const
     // Overte uses a compact property encoding with flags, but we'll use a simpler approach
     
     // Name property (PROP_NAME = 0x1F = 31)
-    writeU16(0x1F);
-    writeString(name);
+    Payload::TextProperty::append(packet, 0x1F, name);
     
     // Position property (PROP_POSITION = 0x01 = 1)
-    writeU16(0x01);
-    writeVec3(position);
+    Payload::Vec3Property::append(packet, 0x01, position);
     
     // Dimensions property (PROP_DIMENSIONS = 0x02 = 2)
-    writeU16(0x02);
-    writeVec3(dimensions);
+    Payload::Vec3Property::append(packet, 0x02, dimensions);
     
     // Color property (PROP_COLOR = 0x0C = 12)
     // Overte uses RGB values 0-255
-    writeU16(0x0C);
-    writeU8(static_cast<uint8_t>(color.r * 255.0f));
-    writeU8(static_cast<uint8_t>(color.g * 255.0f));
-    writeU8(static_cast<uint8_t>(color.b * 255.0f));
+    Payload::ColorProperty::append(packet, 0x0C,
+                                   static_cast<uint8_t>(color.r * 255.0f),
+                                   static_cast<uint8_t>(color.g * 255.0f),
+                                   static_cast<uint8_t>(color.b * 255.0f));
     
     // End of properties marker (property ID = 0xFFFF)
-    writeU16(0xFFFF);
-    
-    // Write payload to packet
-    if (!payload.empty()) {
-        packet.write(payload.data(), payload.size());
-    }
+    Payload::PropertiesEnd::append(packet, 0xFFFF);
     
     const auto& data = packet.getData();
     ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0,
                          reinterpret_cast<sockaddr*>(&m_udpAddr), m_udpAddrLen);
     
     if (s > 0) {
-        std::cout << "[OverteClient] Sent EntityAdd (" << s << " bytes, seq=" << (m_sequenceNumber-1) << ")" << std::endl;
+        std::cout << "[OverteClient] Queued EntityAdd (" << s << " bytes, seq=" << (m_sequenceNumber-1) << ")" << std::endl;
     } else {
         std::cerr << "[OverteClient] Failed to send EntityAdd: " << strerror(errno) << std::endl;
     }
@@ -1967,7 +2216,8 @@ void OverteClient::sendAvatarIdentity() {
     PacketVersion version = NLPacket::versionForPacketType(PacketType::AvatarIdentity);
     std::cout << "[OverteClient] Sending AvatarIdentity (version=" << (int)version << ") to Avatar Mixer..." << std::endl;
     
-    NLPacket packet(PacketType::AvatarIdentity, version, true);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::AvatarIdentity, version, true, m_packetArena.resource());
     packet.setSequenceNumber(m_sequenceNumber++);
     
     // Include our local ID (sourced packet)
@@ -1982,48 +2232,19 @@ void OverteClient::sendAvatarIdentity() {
     // 4. Skeleton model URL (QString) - optional
     // Additional fields exist but are optional for basic connection
     
-    std::vector<uint8_t> payload;
-    
-    auto writeU16BE = [&](uint16_t v) {
-        payload.push_back((v >> 8) & 0xFF);
-        payload.push_back(v & 0xFF);
-    };
-    
-    auto writeQString = [&](const std::string& str) {
-        // Qt QString serialization: int32 size (bytes), then UTF-8 data
-        uint32_t size = str.size();
-        payload.push_back((size >> 24) & 0xFF);
-        payload.push_back((size >> 16) & 0xFF);
-        payload.push_back((size >> 8) & 0xFF);
-        payload.push_back(size & 0xFF);
-        payload.insert(payload.end(), str.begin(), str.end());
-    };
-    
-    // 1. Identity sequence number
-    writeU16BE(m_avatarIdentitySequence++);
-    
-    // 2. Display name (use empty to match typical client behavior - server assigns default)
-    std::string displayName = m_username.empty() ? "" : m_username;
-    writeQString(displayName);
-    
-    // 3. Avatar URL (empty for now - uses default avatar)
-    writeQString("");
-    
-    // 4. Skeleton model URL (empty)
-    writeQString("");
-    
-    // Write payload to packet
-    if (!payload.empty()) {
-        packet.write(payload.data(), payload.size());
-    }
+    // Display name is left empty to match typical client behavior when we
+    // have no username (the server assigns a default); the avatar URL is
+    // empty for the default avatar, as is the skeleton model URL.
+    // Strings go out as a u32 byte count and UTF-8 data.
+    const std::string& displayName = m_username;
+    Payload::AvatarIdentity::append(packet, m_avatarIdentitySequence++, displayName, "", "");
     
     const auto& data = packet.getData();
-    ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0,
-                         reinterpret_cast<sockaddr*>(&m_avatarMixerAddr), m_avatarMixerAddrLen);
+    ssize_t s = sendDatagram(m_udpFd, data.data(), data.size(), m_avatarMixerAddr, m_avatarMixerAddrLen);
     
     if (s > 0) {
         m_identitySent = true;
-        std::cout << "[OverteClient] Sent AvatarIdentity (" << s << " bytes, name=" << displayName << ")" << std::endl;
+        std::cout << "[OverteClient] Queued AvatarIdentity (" << s << " bytes, name=" << displayName << ")" << std::endl;
         std::cout << "[OverteClient] AvatarIdentity hex (first 64 bytes): ";
         for (size_t i = 0; i < std::min(size_t(64), data.size()); ++i) {
             printf("%02x ", data[i]);
@@ -2040,9 +2261,9 @@ void OverteClient::sendAvatarData() {
     // Create AvatarData packet (PacketType::AvatarData = 6 = 0x06)
     // Use correct packet version from versionForPacketType
     PacketVersion version = NLPacket::versionForPacketType(PacketType::AvatarData);
-    std::cout << "[OverteClient] Sending AvatarData (version=" << (int)version << ") to Avatar Mixer..." << std::endl;
     
-    NLPacket packet(PacketType::AvatarData, version, true);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::AvatarData, version, true, m_packetArena.resource());
     packet.setSequenceNumber(m_sequenceNumber++);
     
     // Include our local ID (sourced packet)
@@ -2061,59 +2282,20 @@ void OverteClient::sendAvatarData() {
     const uint64_t PACKET_HAS_AVATAR_GLOBAL_POSITION = 1ULL << 0;  // 0x0001
     const uint64_t PACKET_HAS_AVATAR_ORIENTATION = 1ULL << 2;       // 0x0004
     
-    std::vector<uint8_t> payload;
-    
-    auto writeU16BE = [&](uint16_t v) {
-        payload.push_back((v >> 8) & 0xFF);
-        payload.push_back(v & 0xFF);
-    };
-    
-    auto writeU64BE = [&](uint64_t v) {
-        for (int i = 7; i >= 0; i--) {
-            payload.push_back((v >> (i * 8)) & 0xFF);
-        }
-    };
-    
-    auto writeFloat32BE = [&](float v) {
-        uint32_t bits;
-        std::memcpy(&bits, &v, sizeof(float));
-        payload.push_back((bits >> 24) & 0xFF);
-        payload.push_back((bits >> 16) & 0xFF);
-        payload.push_back((bits >> 8) & 0xFF);
-        payload.push_back(bits & 0xFF);
-    };
-    
-    // 1. Avatar data sequence number
-    writeU16BE(m_avatarDataSequence++);
-    
-    // 2. HasFlags - we're only sending position for now
-    uint64_t hasFlags = PACKET_HAS_AVATAR_GLOBAL_POSITION | PACKET_HAS_AVATAR_ORIENTATION;
-    writeU64BE(hasFlags);
-    
-    // 3. Global position (x, y, z in meters)
-    writeFloat32BE(m_avatarPosition.x);
-    writeFloat32BE(m_avatarPosition.y);
-    writeFloat32BE(m_avatarPosition.z);
-    
-    // 4. Avatar orientation (quaternion - for simplicity, send as full float32 for now)
+    // We're only sending position and orientation for now; the orientation
+    // goes out as full float32s.
     // TODO: Compress to float16 as Overte does
-    writeFloat32BE(m_avatarOrientation.x);
-    writeFloat32BE(m_avatarOrientation.y);
-    writeFloat32BE(m_avatarOrientation.z);
-    writeFloat32BE(m_avatarOrientation.w);
-    
-    // Write payload to packet
-    if (!payload.empty()) {
-        packet.write(payload.data(), payload.size());
-    }
+    const uint64_t hasFlags = PACKET_HAS_AVATAR_GLOBAL_POSITION | PACKET_HAS_AVATAR_ORIENTATION;
+    Payload::AvatarData::append(packet, m_avatarDataSequence++, hasFlags, m_avatarPosition, m_avatarOrientation);
     
     const auto& data = packet.getData();
-    ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0,
-                         reinterpret_cast<sockaddr*>(&m_avatarMixerAddr), m_avatarMixerAddrLen);
+    ssize_t s = sendDatagram(m_udpFd, data.data(), data.size(), m_avatarMixerAddr, m_avatarMixerAddrLen);
     
     if (s > 0) {
-        std::cout << "[OverteClient] Sent AvatarData (" << s << " bytes, pos=[" 
-                  << m_avatarPosition.x << "," << m_avatarPosition.y << "," << m_avatarPosition.z << "])" << std::endl;
+        if (DebugLog::debugNetworkPackets) {
+            std::cout << "[OverteClient] Queued AvatarData (version=" << (int)version << ", " << s << " bytes, pos=["
+                      << m_avatarPosition.x << "," << m_avatarPosition.y << "," << m_avatarPosition.z << "])" << std::endl;
+        }
     } else {
         std::cerr << "[OverteClient] Failed to send AvatarData: " << strerror(errno) << std::endl;
     }
@@ -2125,7 +2307,8 @@ void OverteClient::sendAvatarQuery() {
     // Create AvatarQuery packet - tells Avatar Mixer which avatars we want to receive
     // Based on Overte's Application::queryAvatars() in interface/src/Application.cpp
     PacketVersion version = NLPacket::versionForPacketType(PacketType::AvatarQuery);
-    NLPacket packet(PacketType::AvatarQuery, version, true);
+    FrameArena::Scope arena(m_packetArena);
+    NLPacket packet(PacketType::AvatarQuery, version, true, m_packetArena.resource());
     packet.setSequenceNumber(m_sequenceNumber++);
     
     // Include our local ID (sourced packet)
@@ -2139,11 +2322,10 @@ void OverteClient::sendAvatarQuery() {
     packet.writeUInt8(numFrustums);
     
     const auto& data = packet.getData();
-    ssize_t s = ::sendto(m_udpFd, data.data(), data.size(), 0,
-                         reinterpret_cast<sockaddr*>(&m_avatarMixerAddr), m_avatarMixerAddrLen);
+    ssize_t s = sendDatagram(m_udpFd, data.data(), data.size(), m_avatarMixerAddr, m_avatarMixerAddrLen);
     
     if (s > 0) {
-        std::cout << "[OverteClient] Sent AvatarQuery (" << s << " bytes, numFrustums=0 = request all avatars)" << std::endl;
+        std::cout << "[OverteClient] Queued AvatarQuery (" << s << " bytes, numFrustums=0 = request all avatars)" << std::endl;
     } else {
         std::cerr << "[OverteClient] Failed to send AvatarQuery: " << strerror(errno) << std::endl;
     }
@@ -2,7 +2,9 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -11,6 +13,20 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include "AssetClient.hpp"
+#include "ClockSync.hpp"
+#include "EntityParsePipeline.hpp"
+#include "EntityRateController.hpp"
+#include "EntityWorld.hpp"
+#include "FrameArena.hpp"
+#include "PacketLanes.hpp"
+#include "PacketVerifier.hpp"
+#include "SessionLink.hpp"
+#include "UdpReceive.hpp"
+#include "UdpRing.hpp"
+#include "UdtConnection.hpp"
+#include "WorldSnapshot.hpp"
+
 // Networking types needed for member declarations (sockaddr_storage, socklen_t)
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -19,39 +35,6 @@
 // Forward declarations
 class OverteAuth;
 
-// Overte entity types (matching Overte EntityTypes.h)
-enum class EntityType {
-	Unknown,
-	Box,
-	Sphere,
-	Model,
-	Shape,
-	Light,
-	Text,
-	Zone,
-	Web,
-	ParticleEffect,
-	Line,
-	PolyLine,
-	Grid,
-	Gizmo,
-	Material
-};
-
-struct OverteEntity {
-	std::uint64_t id{0};
-	std::string name;
-	glm::mat4 transform{1.0f};
-	
-	// Visual properties
-	EntityType type{EntityType::Box};
-	std::string modelUrl;      // For Model type entities
-	std::string textureUrl;    // Texture/material URL
-	glm::vec3 color{1.0f, 1.0f, 1.0f};  // RGB color (0-1 range)
-	glm::vec3 dimensions{0.1f, 0.1f, 0.1f};  // Size/scale in meters
-	float alpha{1.0f};         // Transparency (0-1)
-};
-
 // Assignment client information from DomainList
 struct AssignmentClient {
 	uint8_t type;           // 0=EntityServer, 1=AudioMixer, 2=AvatarMixer, etc.
@@ -59,6 +42,8 @@ struct AssignmentClient {
 	sockaddr_storage address{};
 	socklen_t addressLen{0};
 	uint16_t port{0};
+	uint16_t localID{0};
+	std::array<uint8_t, 16> connectionSecret{};  // Keys packet verification hashes
 };
 
 // Lightweight client for Overte mixers/entities. Designed to follow Overte's
@@ -66,7 +51,10 @@ struct AssignmentClient {
 // optionally enabled via STARWORLD_SIMULATE=1.
 class OverteClient {
 public:
-	explicit OverteClient(std::string domainUrl);
+	// `parseWorkers` lets several sessions share one set of entity decoder
+	// threads; by default the client starts its own.
+	explicit OverteClient(std::string domainUrl,
+	                      std::shared_ptr<EntityParsePipeline::WorkerPool> parseWorkers = nullptr);
 	~OverteClient();
 
 	// Authentication
@@ -89,29 +77,119 @@ public:
 	// Movement/controls
 	void sendMovementInput(const glm::vec3& linearVelocity); // m/s in domain frame
 
-	// Entity accessors
-	const std::unordered_map<std::uint64_t, OverteEntity>& entities() const { return m_entities; }
-	std::vector<OverteEntity> consumeUpdatedEntities();
-	std::vector<std::uint64_t> consumeDeletedEntities();
+	// Entities of this session and their unconsumed changes (SceneSync)
+	EntityWorld& world() { return m_world; }
+	const EntityWorld& world() const { return m_world; }
 	
+	// Initial world load: runs from the first entity received until the
+	// server sends EntityQueryInitialResultsComplete or the time limit
+	// (STARWORLD_INITIAL_LOAD_TIMEOUT_MS) passes. Consumers may defer
+	// compositor work while it is active.
+	struct InitialLoadProgress {
+		bool active{false};
+		bool complete{false};
+		std::size_t entitiesReceived{0};
+		float elapsedSeconds{0.0f};
+	};
+	InitialLoadProgress initialLoadProgress() const {
+		InitialLoadProgress progress = m_initialLoad;
+		if (progress.active) {
+			progress.elapsedSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_initialLoadStart).count();
+		}
+		return progress;
+	}
+
+	// Main-thread time the consumer spent applying entity updates; counts
+	// against the entity packet rate budget (see EntityRateController).
+	void recordSyncCost(std::chrono::steady_clock::duration cost) { m_entityRate.recordCost(cost); }
+	// Updates the consumer has taken but not applied yet (SceneSync's
+	// carry-over queue); counted as backlog by the entity rate controller.
+	void recordSyncBacklog(std::size_t pending) { m_syncBacklog = pending; }
+	const EntityRateController& entityRate() const { return m_entityRate; }
+
+	// Fraction of the per-frame budgets (entity rate cost share, bulk lane
+	// time) this session may use; 1/N with N domains in one process.
+	void setBudgetShare(double share);
+
+	// Receive-side overload counters
+	struct ReceiveStats {
+		std::uint32_t domainSocketDrops{0};  // Kernel queue overflows (SO_RXQ_OVFL)
+		std::uint32_t entitySocketDrops{0};
+		std::size_t bulkQueued{0};           // Deferred bulk packets waiting
+		std::uint64_t bulkDropped{0};        // Bulk packets dropped with the lane full
+		std::uint64_t verified{0};           // Inbound packets whose hash checked out
+		std::uint64_t verifyFailed{0};       // Dropped on a hash mismatch
+		std::uint64_t queuedSendsFailed{0};  // io_uring sends that failed on completion
+	};
+	ReceiveStats receiveStats() const;
+
+	// RTT and clock offset per peer, from Ping/PingReply
+	const ClockSync& clockSync() const { return m_clockSync; }
+	// Domain link state; see SessionLink for what survives an outage
+	const SessionLink& link() const { return m_link; }
+
+	glm::vec3 avatarPosition() const { return m_avatarPosition; }
+	// Domain this session was created for; keys its atp:// requests in ModelCache
+	const std::string& domainUrl() const { return m_domainUrl; }
+
 	// Entity creation
 	void createEntity(const std::string& name, EntityType type, const glm::vec3& position, 
 	                  const glm::vec3& dimensions, const glm::vec3& color);
 
 private:
 	void parseNetworkPackets(); // standards-aligned parsing (scaffold)
-	void parseEntityPacket(const char* data, size_t len);
-	void parseDomainPacket(const char* data, size_t len);
+	void parseEntityPacket(const char* data, size_t len, std::chrono::steady_clock::time_point rxTime);
+	void commitParsedEntities();  // apply decoded ops from m_parsePipeline
+	void applyEntityOp(const EntityOp& op);
+	// `serverComplete`: the server marked the end of its pass, so entities
+	// it did not send are gone. After a timeout they are kept (the server
+	// may still be streaming them) until a pass does complete.
+	void finishInitialLoad(const char* reason, bool serverComplete);
+	// The server lost our node during an outage and resends everything:
+	// keep the entities (and their compositor nodes) and diff against them.
+	void beginResync();
+	void finishResync(const char* reason, bool serverComplete);
+	// Erase entities the server never confirmed; returns how many.
+	std::size_t removeUnconfirmed();
+	void markUnconfirmed(std::uint32_t slot);
+
+	// World snapshot (warm startup)
+	void restoreSnapshot();
+	void markSnapshotDirty(std::uint32_t slot);
+	void captureSnapshot();
+	void parseDomainPacket(const char* data, size_t len, const sockaddr_storage& from,
+	                       std::chrono::steady_clock::time_point rxTime);
+	// Node type of the peer at `from` (see ClockSync, 'A' for the asset
+	// server); the domain server if unknown.
+	char peerTypeFor(const sockaddr_storage& from) const;
 	void handleDomainListReply(const char* data, size_t len);
 	void handleDomainConnectionDenied(const char* data, size_t len);
 	void handleDomainServerConnectionToken(const char* data, size_t len);
 	void handleICEPing(const char* data, size_t len);
+	// Log and record growth of a socket's SO_RXQ_OVFL counter
+	void noteSocketDrops(const UdpReceive::Meta& meta, std::uint32_t& total, const char* socketName);
+	// Log packets the verifier just rejected
+	void noteVerifyFailures(std::size_t count);
+	// Log queued ring sends whose completion reported an error
+	void noteSendFailures();
 	void handlePing(const char* payload, size_t len);
+	void handlePingReply(const char* payload, size_t len, char peerType, std::chrono::steady_clock::time_point rxTime);
 	void sendDomainListRequest();
 	void sendDomainConnectRequest();
 	void sendEntityQuery();
 	void sendPing(int fd, const sockaddr_storage& addr, socklen_t addrLen);
-	void sendACK(uint32_t sequenceNumber);
+	// sendto(), or queued on the domain socket's io_uring (sent at the end of poll)
+	ssize_t sendDatagram(int fd, const void* data, size_t len, const sockaddr_storage& to, socklen_t toLen);
+	// One UDT control packet (ACK, handshake)
+	void sendControl(const UdtConnection::Control& control, const sockaddr_storage& to, socklen_t toLen);
+	// ACK a received packet if it is reliable (call once it is accepted)
+	void ackIfReliable(const uint8_t* data, size_t len, const sockaddr_storage& from);
+	void handleControlPacket(const uint8_t* data, size_t len, const sockaddr_storage& from);
+	// One AssetClient request to the asset server (sourced and verified).
+	// Held back until the asset server has answered our handshake.
+	void sendAssetPacket(Overte::PacketType type, const std::vector<std::uint8_t>& payload);
+	// A new asset server: new connection, nothing held back
+	void resetAssetLink();
 	
 	// Avatar Mixer protocol
 	void sendAvatarIdentity();
@@ -119,6 +197,9 @@ private:
 	void sendAvatarQuery();
 	void handleAvatarMixerPacket(const char* data, size_t len, uint8_t packetType);
 
+	// MemoryBudget shedder: give back spare store, packet and scratch memory
+	void shrinkBuffers();
+
 	std::string m_domainUrl;
 	std::string m_host{"127.0.0.1"};
 	int m_port{40102};
@@ -128,26 +209,70 @@ private:
 	bool m_audioMixer{false};
 	bool m_useSimulation{false};
 	bool m_domainConnected{false};
-	std::string m_sessionUUID; // Our client session UUID
+	std::string m_sessionUUID; // Our client session UUID (kept across reconnects)
 	std::string m_username;     // Domain account username (for future signature-based auth)
-	std::string m_connectionToken; // Connection token from domain server (UUID string)
+	std::string m_connectionToken; // Connection token from domain server (UUID string, kept across reconnects)
 	std::uint32_t m_sequenceNumber{0};  // Packet sequence number for NLPacket protocol
+	std::int64_t m_pingConnectionId{0}; // Sent in Pings; bumped per connect() so peers drop our stale connection
 	std::uint16_t m_localID{0};         // Local ID assigned by domain server
 	
 	// Authentication (non-owning pointer to auth object from main)
 	OverteAuth* m_auth{nullptr};
 
 	// Very small in-process world state for testing
-	std::unordered_map<std::uint64_t, OverteEntity> m_entities;
-	std::vector<std::uint64_t> m_updateQueue; // ids of entities updated since last consume
-	std::vector<std::uint64_t> m_deleteQueue; // ids of entities to delete
-	std::uint64_t m_nextEntityId{1};
+	EntityWorld m_world;
+	std::uint64_t m_nextEntityId{1};          // counter for simulated entity UUIDs
+
+	// Entity packet decoding (worker threads) and reusable commit buffer
+	EntityParsePipeline m_parsePipeline;
+	std::vector<EntityOp> m_parsedOps;
+	EntityRateController m_entityRate;  // maxOctreePPS of the EntityQuery
+	std::size_t m_syncBacklog{0};
+
+	// Initial load tracking (see initialLoadProgress)
+	InitialLoadProgress m_initialLoad;
+	std::chrono::steady_clock::time_point m_initialLoadStart{};
+	std::chrono::milliseconds m_initialLoadTimeout{10000};
+
+	// Domain liveness and the resync after the server lost our node
+	SessionLink m_link;
+	bool m_resyncActive{false};
+	std::chrono::steady_clock::time_point m_resyncStart{};
+	std::size_t m_resyncReceived{0};
+	std::size_t m_resyncChanged{0};
+
+	// Per-domain snapshot: restored at connect, rewritten in the background.
+	// Entities restored from it (or kept through a reconnect) stay
+	// "unconfirmed" until the server sends them; unconfirmed ones are erased
+	// when the initial load (or resync) finishes.
+	bool m_snapshotEnabled{true};
+	std::filesystem::path m_snapshotPath;
+	WorldSnapshot::Builder m_snapshotBuilder;
+	std::unique_ptr<WorldSnapshot::Writer> m_snapshotWriter;
+	std::vector<std::uint8_t> m_snapshotDirty;        // per slot
+	std::vector<std::uint32_t> m_snapshotDirtySlots;
+	std::vector<std::uint8_t> m_unconfirmed;  // per slot
+	std::size_t m_unconfirmedCount{0};
+	bool m_snapshotDue{false};
+	std::chrono::steady_clock::time_point m_lastSnapshot{};
+	std::chrono::seconds m_snapshotInterval{30};
 
 	// Networking
 	int m_udpFd{-1};
 	bool m_udpReady{false};
 	struct sockaddr_storage m_udpAddr{};
 	socklen_t m_udpAddrLen{0};
+	// Domain socket bulk lane: drained for up to STARWORLD_BULK_BUDGET_US per poll
+	std::unique_ptr<UdpRing> m_domainRing;  // null: recvmsg/sendto (STARWORLD_IO_URING=0 or unsupported)
+	std::uint64_t m_queuedSendsFailed{0};   // Seen from m_domainRing (and rings before it)
+	std::uint64_t m_ringSendFailures{0};    // m_domainRing->sendFailures() already counted
+	BulkQueue m_bulkLane;
+	std::chrono::microseconds m_bulkBudget{2000};
+	std::chrono::microseconds m_bulkBudgetTotal{2000};  // STARWORLD_BULK_BUDGET_US before setBudgetShare()
+	std::uint32_t m_domainSocketDrops{0};
+	std::uint32_t m_entitySocketDrops{0};
+	// Connection secret keys of the assignment clients, by local ID
+	PacketVerifier m_verifier;
 	
 	// Assignment clients from DomainList
 	std::vector<AssignmentClient> m_assignmentClients;
@@ -155,11 +280,25 @@ private:
 	socklen_t m_entityServerAddrLen{0};
 	uint16_t m_entityServerPort{0};
 	
+	ClockSync m_clockSync;
+	
 	// Avatar Mixer connection
 	sockaddr_storage m_avatarMixerAddr{};
 	socklen_t m_avatarMixerAddrLen{0};
 	uint16_t m_avatarMixerPort{0};
 	bool m_avatarMixerConnected{false};
+
+	// Asset server (atp:// downloads)
+	sockaddr_storage m_assetServerAddr{};
+	socklen_t m_assetServerAddrLen{0};
+	uint16_t m_assetServerPort{0};
+	uint16_t m_assetServerLocalID{0};  // Signs our requests (m_verifier)
+	std::unique_ptr<AssetClient> m_assets;
+	// Reliable packets to and from the asset server: their own sequence
+	// space, opened with a handshake (replaced by resetAssetLink())
+	UdtConnection m_assetLink{0};
+	std::vector<std::pair<Overte::PacketType, std::vector<std::uint8_t>>> m_assetBacklog;  // Waiting for the handshake
+	bool m_assetAckDue{false};  // Reliable packets received since the last ACK
 	
 	// Avatar state
 	glm::vec3 m_avatarPosition{0.0f, 0.0f, 0.0f};
@@ -173,6 +312,20 @@ private:
 	bool m_entityServerReady{false};
 	sockaddr_storage m_entityAddr{};
 	socklen_t m_entityAddrLen{0};
+	std::unique_ptr<UdpRing> m_entityRing;
 	std::vector<char> m_entityBuffer; // accumulate partial packets
+
+	// Packets and payloads of the send* functions, reset after each send
+	FrameArena m_packetArena{4 * 1024};
+
+	// poll() timers and counters (per session)
+	std::chrono::steady_clock::time_point m_lastPing{};
+	std::chrono::steady_clock::time_point m_lastDomainList{};
+	std::chrono::steady_clock::time_point m_lastAvatarData{};
+	std::chrono::steady_clock::time_point m_lastAvatarQuery{};
+	std::chrono::steady_clock::time_point m_simulationStart{};
+	int m_recvErrorCount{0};
+	std::uint16_t m_queryConnectionId{0};  // EntityQuery connection ID (0 = initial query)
+	int m_shedder{0};                      // MemoryBudget registration
 };
 
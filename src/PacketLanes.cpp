@@ -0,0 +1,65 @@
+// PacketLanes.cpp
+#include "PacketLanes.hpp"
+
+#include <algorithm>
+
+using Overte::NLPacket;
+using Overte::PacketType;
+
+namespace PacketLanes {
+
+Lane classify(PacketType type) {
+    switch (type) {
+        // Keepalives: late replies get us timed out
+        case PacketType::Ping:
+        case PacketType::PingReply:
+        case PacketType::ICEPing:
+        case PacketType::ICEPingReply:
+        // Connection state and node membership
+        case PacketType::DomainList:
+        case PacketType::DomainConnectRequestPending:
+        case PacketType::DomainConnectionDenied:
+        case PacketType::DomainServerConnectionToken:
+        case PacketType::DomainServerRequireDTLS:
+        case PacketType::DomainServerAddedNode:
+        case PacketType::DomainServerRemovedNode:
+        case PacketType::DomainDisconnectRequest:
+        case PacketType::StopNode:
+            return Lane::Control;
+        default:
+            return Lane::Bulk;
+    }
+}
+
+Lane classify(const std::uint8_t* data, std::size_t len) {
+    NLPacket::Header header;
+    if (!NLPacket::parseHeader(data, len, header)) return Lane::Control;
+    // Bit 31: protocol control packet (ACK, handshake); no NLPacket type
+    if (header.sequenceAndFlags & 0x80000000) return Lane::Control;
+    return classify(header.type);
+}
+
+} // namespace PacketLanes
+
+BulkQueue::BulkQueue(std::size_t capacity) : m_ring(std::max<std::size_t>(capacity, 1)) {}
+
+bool BulkQueue::push(const char* data, std::size_t len, const sockaddr_storage& from, Clock::time_point rxTime) {
+    if (m_size == m_ring.size()) {
+        ++m_dropped;
+        return false;
+    }
+    Entry& e = m_ring[(m_head + m_size) % m_ring.size()];
+    e.bytes.assign(data, data + len);
+    e.from = from;
+    e.rxTime = rxTime;
+    ++m_size;
+    ++m_fresh;
+    return true;
+}
+
+void BulkQueue::shrink() {
+    for (std::size_t i = m_size; i < m_ring.size(); ++i) {
+        auto& bytes = m_ring[(m_head + i) % m_ring.size()].bytes;
+        decltype(Entry::bytes)().swap(bytes);
+    }
+}
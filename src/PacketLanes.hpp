@@ -0,0 +1,110 @@
+// PacketLanes.hpp
+// Receive-side priority lanes for the domain socket.
+//
+// Keepalives (Ping, ICEPing), the connection handshake and DomainList are
+// handled as soon as they are read: the domain server drops us if a Ping
+// waits behind thousands of EntityData packets. Bulk entity and avatar
+// traffic goes into a bounded queue that is drained under a time budget per
+// poll. The bulk lane keeps arrival order, so e.g. every EntityData still
+// precedes the EntityQueryInitialResultsComplete that follows it.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include "MemoryBudget.hpp"
+#include "NLPacketCodec.hpp"
+
+namespace PacketLanes {
+
+enum class Lane : std::uint8_t {
+	Control,  // Handle now
+	Bulk      // Defer to the budgeted queue
+};
+
+// Classify from the NLPacket header alone. Protocol control packets (ACK,
+// handshake) and unparseable headers go to the control lane, which is cheap.
+Lane classify(const std::uint8_t* data, std::size_t len);
+Lane classify(Overte::PacketType type);
+
+} // namespace PacketLanes
+
+// Fixed-capacity FIFO of received bulk datagrams. Slot buffers keep their
+// capacity, so a steady flood does not allocate.
+class BulkQueue {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit BulkQueue(std::size_t capacity = 4096);
+
+	// Copy a datagram in. Returns false (and counts a drop) when full.
+	bool push(const char* data, std::size_t len, const sockaddr_storage& from, Clock::time_point rxTime);
+
+	// Hand queued datagrams to fn(data, len, from, rxTime) in arrival order
+	// until `budget` is used up. At least one is handled per call so the
+	// lane always makes progress. Returns the number handled.
+	template <typename Fn>
+	std::size_t drain(Fn&& fn, Clock::duration budget) {
+		const auto deadline = Clock::now() + budget;
+		std::size_t handled = 0;
+		while (m_size > 0) {
+			Entry& e = m_ring[m_head];
+			fn(e.bytes.data(), e.bytes.size(), e.from, e.rxTime);
+			m_head = (m_head + 1) % m_ring.size();
+			--m_size;
+			m_fresh = std::min(m_fresh, m_size);
+			++handled;
+			if (Clock::now() >= deadline) break;
+		}
+		return handled;
+	}
+
+	// Drop the datagrams pushed since the last call for which
+	// keep(data, len, from) is false, keeping the order of the rest, so a
+	// whole receive burst is screened before any of it is drained. Returns
+	// the number dropped.
+	template <typename Keep>
+	std::size_t filterNew(Keep&& keep) {
+		const std::size_t first = m_size - m_fresh;
+		std::size_t kept = first;
+		for (std::size_t i = first; i < m_size; ++i) {
+			Entry& e = at(i);
+			if (!keep(e.bytes.data(), e.bytes.size(), e.from)) continue;
+			if (kept != i) std::swap(at(kept), e);  // Buffers trade places, none is freed
+			++kept;
+		}
+		const std::size_t dropped = m_size - kept;
+		m_size = kept;
+		m_fresh = 0;
+		return dropped;
+	}
+
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	std::size_t capacity() const { return m_ring.size(); }
+	std::uint64_t dropped() const { return m_dropped; }
+
+	// Free the buffers of slots that hold no datagram (memory pressure). They
+	// are allocated again as the next flood comes in.
+	void shrink();
+
+private:
+	struct Entry {
+		TrackedVector<char, MemoryBudget::Subsystem::PacketBuffers> bytes;
+		sockaddr_storage from{};
+		Clock::time_point rxTime{};
+	};
+
+	Entry& at(std::size_t i) { return m_ring[(m_head + i) % m_ring.size()]; }
+
+	TrackedVector<Entry, MemoryBudget::Subsystem::PacketBuffers> m_ring;
+	std::size_t m_head{0};
+	std::size_t m_size{0};
+	std::size_t m_fresh{0};  // Newest entries not yet through filterNew()
+	std::uint64_t m_dropped{0};
+};
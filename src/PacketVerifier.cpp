@@ -0,0 +1,99 @@
+// PacketVerifier.cpp
+#include "PacketVerifier.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using Overte::NLPacket;
+
+namespace {
+
+constexpr std::uint32_t kControlBit = 0x80000000;
+
+} // anonymous namespace
+
+bool PacketVerifier::checkingFromEnv() {
+    const char* env = std::getenv("STARWORLD_VERIFY_PACKETS");
+    return !env || std::string(env) != "0";
+}
+
+void PacketVerifier::setPeer(Overte::LocalID id, const Secret& secret) {
+    const bool null = std::all_of(secret.begin(), secret.end(), [](std::uint8_t b) { return b == 0; });
+    for (auto it = m_peers.begin(); it != m_peers.end(); ++it) {
+        if (it->id != id) continue;
+        if (null) {
+            m_peers.erase(it);
+            m_last = nullptr;
+        } else if (it->secret != secret) {
+            it->secret = secret;
+            it->key = HmacMd5(secret.data(), secret.size());
+            it->reported = false;
+        }
+        return;
+    }
+    if (null) return;
+    m_peers.push_back(Peer{id, secret, HmacMd5(secret.data(), secret.size())});
+    m_last = nullptr;  // The vector may have moved
+}
+
+void PacketVerifier::clear() {
+    m_peers.clear();
+    m_last = nullptr;
+}
+
+const PacketVerifier::Peer* PacketVerifier::find(Overte::LocalID id) const {
+    if (m_last && m_last->id == id) return m_last;
+    for (const Peer& peer : m_peers) {
+        if (peer.id == id) {
+            m_last = &peer;
+            return &peer;
+        }
+    }
+    return nullptr;
+}
+
+const HmacMd5* PacketVerifier::key(Overte::LocalID id) const {
+    const Peer* peer = find(id);
+    return peer ? &peer->key : nullptr;
+}
+
+PacketVerifier::Verdict PacketVerifier::check(const std::uint8_t* data, std::size_t len) const {
+    const Peer* peer = nullptr;
+    return check(data, len, peer);
+}
+
+PacketVerifier::Verdict PacketVerifier::check(const std::uint8_t* data, std::size_t len, const Peer*& peer) const {
+    if (!m_checking) return Verdict::Unchecked;
+    NLPacket::Header header;
+    if (!NLPacket::parseHeader(data, len, header)) return Verdict::Unchecked;
+    if ((header.sequenceAndFlags & kControlBit) != 0) return Verdict::Unchecked;
+    if (!NLPacket::isVerifiedType(header.type)) return Verdict::Unchecked;
+    if (len < header.size + sizeof(Overte::LocalID)) return Verdict::Unchecked;  // Not actually sourced
+
+    peer = find(header.sourceID);
+    if (!peer) return Verdict::Unchecked;
+
+    // [header][sourceID][hash][payload...], the hash over the payload
+    const std::size_t hashAt = header.size + sizeof(Overte::LocalID);
+    const std::size_t payloadAt = hashAt + NLPacket::VERIFICATION_HASH_SIZE;
+    if (len < payloadAt) return Verdict::Failed;
+    return peer->key.verify(data + payloadAt, len - payloadAt, data + hashAt) ? Verdict::Verified : Verdict::Failed;
+}
+
+bool PacketVerifier::accept(const std::uint8_t* data, std::size_t len) {
+    const Peer* peer = nullptr;
+    switch (check(data, len, peer)) {
+        case Verdict::Unchecked: return true;
+        case Verdict::Verified: ++m_verified; return true;
+        case Verdict::Failed: break;
+    }
+    ++m_failed;
+    if (peer && !peer->reported) {
+        peer->reported = true;
+        std::cerr << "[PacketVerifier] Dropping packets from node " << peer->id << " (first one " << len
+                  << " bytes): verification hash mismatch. STARWORLD_VERIFY_PACKETS=0 turns checking off" << std::endl;
+    }
+    return false;
+}
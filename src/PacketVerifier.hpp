@@ -0,0 +1,92 @@
+// PacketVerifier.hpp
+// Per-peer HMAC-MD5 keys, and the check of inbound verified packets.
+//
+// Each assignment client in the DomainList comes with the connection secret
+// the domain server issued for it and us; packets both ways between the two
+// are hashed with it. The verifier keeps one HmacMd5 per peer local ID,
+// built when the peer first appears (or its secret changes), so neither
+// signing nor checking hashes the key again.
+//
+// Inbound, a packet is checked when its type is sourced and verified and
+// its source ID is a peer we hold a secret for. Packets from the domain
+// server, unsourced or unverified types, and control packets pass
+// unchecked; so does a source we don't know yet (a node that appears before
+// the DomainList naming it), which Overte would drop.
+//
+// A peer whose secret is the null UUID gets no key: servers that never set
+// a node's secret leave the hash slot unsigned (see
+// docs/SESSION_2025-11-10_HMAC_INVESTIGATION.md), so its packets stay
+// unchecked rather than all failing. STARWORLD_VERIFY_PACKETS=0 turns
+// inbound checking off altogether.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "HmacMd5.hpp"
+#include "NLPacketCodec.hpp"
+
+class PacketVerifier {
+public:
+	using Secret = std::array<std::uint8_t, 16>;
+
+	enum class Verdict : std::uint8_t {
+		Unchecked,  // Nothing to verify it against
+		Verified,
+		Failed      // Hash mismatch, or too short to hold one
+	};
+
+	// STARWORLD_VERIFY_PACKETS (unset or anything but 0 = check)
+	static bool checkingFromEnv();
+
+	// Key packets to and from `id` with `secret`. The pads are only hashed
+	// again if the secret changed; a null secret forgets the peer.
+	void setPeer(Overte::LocalID id, const Secret& secret);
+	// Forget the peers for which keep(id) is false
+	template <typename Keep>
+	void retainPeers(Keep keep) {
+		std::erase_if(m_peers, [&](const Peer& p) { return !keep(p.id); });
+		m_last = nullptr;
+	}
+	void clear();
+	std::size_t peers() const { return m_peers.size(); }
+
+	// Key for `id` (nullptr if unknown)
+	const HmacMd5* key(Overte::LocalID id) const;
+
+	// With checking off every packet is Unchecked (keys still sign)
+	void setChecking(bool checking) { m_checking = checking; }
+	bool checking() const { return m_checking; }
+
+	// Check one packet without counting it
+	Verdict check(const std::uint8_t* data, std::size_t len) const;
+
+	// Check a packet that is about to be dispatched and count the outcome.
+	// Returns false if it must be dropped; the first failure from each peer
+	// is logged.
+	bool accept(const std::uint8_t* data, std::size_t len);
+
+	std::uint64_t verified() const { return m_verified; }
+	std::uint64_t failed() const { return m_failed; }
+
+private:
+	struct Peer {
+		Overte::LocalID id;
+		Secret secret;
+		HmacMd5 key;
+		mutable bool reported{false};  // First failure logged
+	};
+
+	Verdict check(const std::uint8_t* data, std::size_t len, const Peer*& peer) const;
+	const Peer* find(Overte::LocalID id) const;
+
+	// A handful of peers per domain: a flat vector, and the last hit cached
+	// since bulk traffic comes in runs from the same source
+	std::vector<Peer> m_peers;
+	mutable const Peer* m_last{nullptr};
+	std::uint64_t m_verified{0};
+	std::uint64_t m_failed{0};
+	bool m_checking{true};
+};
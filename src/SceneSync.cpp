@@ -3,55 +3,383 @@
 #include "OverteClient.hpp"
 #include "StardustBridge.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
 #include <glm/gtc/matrix_transform.hpp>
 
-std::unordered_map<std::uint64_t, std::uint64_t> SceneSync::s_entityNodeMap;
+SceneSync::SceneSync(std::string rootName, const glm::mat4& offset)
+	: m_rootName(std::move(rootName)), m_offset(offset) {
+	if (const char* env = std::getenv("STARWORLD_SYNC_BUDGET_US")) {
+		m_budgetTotal = std::chrono::microseconds(std::max(0, std::atoi(env)));
+	}
+	m_budget = m_budgetTotal;
+	if (const char* env = std::getenv("STARWORLD_LATENCY_REPORT_S")) {
+		m_latencyReportInterval = std::chrono::seconds(std::max(0, std::atoi(env)));
+	}
+	auto& budget = MemoryBudget::instance();
+	m_queueShedder = budget.addShedder("SceneSync queues", MemoryBudget::Pressure::Soft, [this](MemoryBudget::Pressure) {
+		m_scheduler.shrink();
+		releaseSpare(m_slots);
+		releaseSpare(m_batch);
+		releaseSpare(m_inBatch);
+	});
+	// Applied on the next update(), which has the bridge at hand. Best effort:
+	// the models it unbinds live in the compositor, outside every tracked
+	// counter, so relieve() sees nothing freed by it (and backs off).
+	m_detailShedder = budget.addShedder("Far model detail", MemoryBudget::Pressure::Hard,
+	                                    [this](MemoryBudget::Pressure) { m_shedDetail = true; });
+}
+
+SceneSync::~SceneSync() {
+	auto& budget = MemoryBudget::instance();
+	budget.removeShedder(m_queueShedder);
+	budget.removeShedder(m_detailShedder);
+}
+
+void SceneSync::setOffset(const glm::mat4& offset) {
+	m_offset = offset;
+	m_offsetDirty = true;
+}
+
+bool SceneSync::ensureRoot(StardustBridge& stardust) {
+	if (m_root != StardustBridge::InvalidNode) return true;
+	if (!stardust.supportsParenting()) return false;
+	m_root = stardust.createNode(m_rootName, m_offset);
+	if (m_root == StardustBridge::InvalidNode) return false;
+	// Grouping only: no geometry of its own
+	stardust.setNodeEntityType(m_root, 0);
+	stardust.setNodeDimensions(m_root, glm::vec3(0.0f));
+	return true;
+}
+
+void SceneSync::applyOffset(StardustBridge& stardust, const EntityWorld& world) {
+	m_offsetDirty = false;
+	if (m_root != StardustBridge::InvalidNode) {
+		stardust.updateNodeTransform(m_root, m_offset);
+		return;
+	}
+	const auto& store = world.store();
+	for (std::uint32_t slot = 0; slot < m_entityNodes.size(); ++slot) {
+		if (m_entityNodes[slot] == StardustBridge::InvalidNode) continue;
+		stardust.updateNodeTransform(m_entityNodes[slot], m_offset * store.at(slot).worldTransform);
+	}
+}
 
 void SceneSync::update(StardustBridge& stardust, OverteClient& overte) {
-	// Pull only the entities that changed since the last call.
-	auto updated = overte.consumeUpdatedEntities();
-	for (const auto& e : updated) {
-		auto it = s_entityNodeMap.find(e.id);
-		if (it == s_entityNodeMap.end()) {
-			// Create a Stardust node the first time we see this entity.
-			auto nodeId = stardust.createNode(e.name, e.transform);
-			s_entityNodeMap.emplace(e.id, nodeId);
-			
-			// Set visual properties for the newly created node
-			stardust.setNodeEntityType(nodeId, static_cast<uint8_t>(e.type));
-			stardust.setNodeColor(nodeId, e.color, e.alpha);
-			stardust.setNodeDimensions(nodeId, e.dimensions);
-			
-			if (!e.modelUrl.empty()) {
-				stardust.setNodeModel(nodeId, e.modelUrl);
+	if (m_offsetDirty) applyOffset(stardust, overte.world());
+	if (m_assetDomain != overte.domainUrl()) m_assetDomain = overte.domainUrl();
+
+	if (m_latencyReportInterval.count() > 0) {
+		const auto now = std::chrono::steady_clock::now();
+		if (now - m_lastLatencyReport >= m_latencyReportInterval) {
+			m_lastLatencyReport = now;
+			m_latency.report(std::cout);
+		}
+	}
+
+	const auto load = overte.initialLoadProgress();
+	if (load.active) {
+		// Leave everything queued in the client; it is scheduled once the
+		// initial load is complete.
+		auto now = std::chrono::steady_clock::now();
+		if (now - m_lastProgressLog >= std::chrono::seconds(1)) {
+			std::cout << "[SceneSync] Initial load: " << load.entitiesReceived << " entities received ("
+			          << load.elapsedSeconds << "s)" << std::endl;
+			m_lastProgressLog = now;
+		}
+		return;
+	}
+
+	const auto frameStart = Clock::now();
+	if (load.complete && !m_initialLoadQueued) {
+		m_initialLoadQueued = true;
+		m_materializing = true;
+		m_materializeStart = frameStart;
+		std::cout << "[SceneSync] Initial load complete: " << load.entitiesReceived << " entities received in "
+		          << load.elapsedSeconds << "s" << std::endl;
+	}
+
+	const std::size_t created = sync(stardust, overte.world(), overte.avatarPosition(),
+	                                 m_budget.count() > 0 ? frameStart + m_budget : Clock::time_point::max());
+
+	if (m_materializing) {
+		m_materializeCreated += created;
+		++m_materializeFrames;
+		if (m_scheduler.empty()) {
+			m_materializing = false;
+			const auto ms = std::chrono::duration<float, std::milli>(Clock::now() - m_materializeStart).count();
+			std::cout << "[SceneSync] Initial load materialized " << m_materializeCreated << " nodes over "
+			          << m_materializeFrames << " frames in " << ms << " ms" << std::endl;
+		}
+	} else {
+		// Steady-state cost only: the one-off initial load says nothing about
+		// the packet rate we can keep up with.
+		overte.recordSyncCost(Clock::now() - frameStart);
+	}
+	// Work we could not fit counts as backlog against the entity packet rate
+	overte.recordSyncBacklog(m_scheduler.size());
+}
+
+std::size_t SceneSync::sync(StardustBridge& stardust, EntityWorld& world, const glm::vec3& eye,
+                            Clock::time_point deadline) {
+	FrameArena::Scope frame(m_frameArena);
+	// Pull only the entities that changed since the last call, then send as
+	// many as fit this frame's budget and the compositor's backlog.
+	enqueueUpdates(stardust, world);
+	updateThrottle(stardust);
+	const std::size_t created = runScheduled(stardust, world, eye, deadline);
+
+	// Process deletions after updates to avoid create-then-delete thrash.
+	processDeletions(stardust, world);
+	updateDetail(stardust, world, eye);
+	return created;
+}
+
+void SceneSync::updateThrottle(StardustBridge& stardust) {
+	const auto status = stardust.queueStatus();
+	if (!status.valid) {
+		m_updateAllowance = SIZE_MAX;
+		return;
+	}
+	const auto before = m_throttle.level();
+	const auto level = m_throttle.update(status.depth());
+	m_updateAllowance = m_throttle.updateAllowance();
+	if (level == before) return;
+	switch (level) {
+		case SubmitThrottle::Level::Clear:
+			std::cout << "[SceneSync] Compositor caught up (" << status.depth() << " commands queued)" << std::endl;
+			break;
+		case SubmitThrottle::Level::Behind:
+			std::cout << "[SceneSync] Compositor behind (" << status.depth()
+			          << " commands queued); rationing updates of existing nodes" << std::endl;
+			break;
+		case SubmitThrottle::Level::Congested:
+			std::cout << "[SceneSync] Compositor congested (" << status.depth()
+			          << " commands queued); only creating and removing nodes" << std::endl;
+			break;
+	}
+}
+
+void SceneSync::setBudgetShare(double share) {
+	share = std::clamp(share, 0.0, 1.0);
+	m_budget = std::chrono::duration_cast<std::chrono::microseconds>(m_budgetTotal * share);
+}
+
+StardustBridge::NodeId& SceneSync::nodeFor(std::uint32_t slot) {
+	if (slot >= m_entityNodes.size()) {
+		m_entityNodes.resize(slot + 1, StardustBridge::InvalidNode);
+	}
+	return m_entityNodes[slot];
+}
+
+void SceneSync::enqueueUpdates(StardustBridge& stardust, EntityWorld& world) {
+	const auto updated = world.consumeUpdated(m_frameArena.resource());
+	const auto now = Clock::now();
+	for (const OverteEntity& e : updated) m_scheduler.mark(e.slot, now, e.rxTime);
+
+	// With parent links in the compositor a moved parent carries its subtree.
+	// Bridges without them take world transforms, so descendants are re-sent.
+	if (!ensureRoot(stardust)) {
+		const auto& hierarchy = world.hierarchy();
+		m_slots.clear();
+		for (const OverteEntity& e : updated) m_slots.push_back(e.slot);
+		for (std::size_t i = 0; i < m_slots.size(); ++i) {
+			for (auto child : hierarchy.children(m_slots[i])) {
+				if (m_scheduler.queued(child)) continue;
+				m_scheduler.mark(child, now);
+				m_slots.push_back(child);
 			}
-			if (!e.textureUrl.empty()) {
-				stardust.setNodeTexture(nodeId, e.textureUrl);
+		}
+	}
+}
+
+std::size_t SceneSync::runScheduled(StardustBridge& stardust, EntityWorld& world, const glm::vec3& eye,
+                                    Clock::time_point deadline) {
+	if (m_scheduler.empty()) return 0;
+	const bool parenting = ensureRoot(stardust);
+	const auto& store = world.store();
+
+	// Entity positions are in the domain frame: bring the view direction there
+	const glm::mat3 toDomain(glm::inverse(m_offset));
+	const glm::vec3 forward = glm::normalize(toDomain * -glm::vec3(stardust.headPose()[2]));
+	m_scheduler.beginFrame(Clock::now(), eye, forward,
+	                       [&](std::uint32_t slot, glm::vec3& position) {
+		// Erased while queued; processDeletions drops it
+		if (!store.isLive(slot)) return false;
+		position = glm::vec3(store.at(slot).worldTransform[3]);
+		return true;
+	});
+
+	// One createNodes call and one deadline check per chunk
+	constexpr std::size_t kChunk = 64;
+	std::size_t created = 0;
+	do {
+		m_slots.clear();
+		if (m_scheduler.next(kChunk, m_slots) == 0) break;
+		m_batch.clear();
+		for (auto slot : m_slots) m_batch.push_back(&store.at(slot));
+		created += applyBatch(stardust, world, parenting);
+	} while (Clock::now() < deadline);
+	m_scheduler.endFrame();
+	return created;
+}
+
+std::size_t SceneSync::applyBatch(StardustBridge& stardust, EntityWorld& world, bool parenting) {
+	// Existing nodes are updated in place; new ones are created in one call.
+	// A parent created in this batch gets its node before links are set below.
+	// Top-level entities are relative to the session root, i.e. in the domain frame.
+	auto transformFor = [&](const OverteEntity& e) -> glm::mat4 {
+		if (!parenting) return m_offset * e.worldTransform;
+		return e.parentSlot != EntityHierarchy::npos ? e.transform : e.worldTransform;
+	};
+	StringTable& strings = world.strings();
+	std::pmr::vector<StardustBridge::NodeDesc> descs(m_frameArena.resource());
+	std::pmr::vector<const OverteEntity*> fresh(m_frameArena.resource());
+	std::size_t kept = 0;
+	for (const OverteEntity* e : m_batch) {
+		if (nodeFor(e->slot) != StardustBridge::InvalidNode) {
+			if (m_updateAllowance == 0) {
+				// Compositor backlog: wait in the queue, where newer changes coalesce
+				m_scheduler.putBack(e->slot);
+				continue;
 			}
-		} else {
-			// Update existing node's transform and visual properties
-			stardust.updateNodeTransform(it->second, e.transform);
-			stardust.setNodeEntityType(it->second, static_cast<uint8_t>(e.type));
-			stardust.setNodeColor(it->second, e.color, e.alpha);
-			stardust.setNodeDimensions(it->second, e.dimensions);
-			
-			if (!e.modelUrl.empty()) {
-				stardust.setNodeModel(it->second, e.modelUrl);
+			--m_updateAllowance;
+			m_batch[kept++] = e;
+			syncEntity(stardust, strings, *e, transformFor(*e));
+			recordLatency(*e, Clock::now());
+			continue;
+		}
+		descs.push_back({strings.str(e->name), transformFor(*e), e->color, e->alpha, e->dimensions, static_cast<std::uint8_t>(e->type)});
+		fresh.push_back(e);
+		m_batch[kept++] = e;
+	}
+	m_batch.resize(kept);  // Only what was sent gets linked below
+
+	if (!fresh.empty()) {
+		auto nodes = stardust.createNodes(descs);
+		const auto submitted = Clock::now();
+		for (const OverteEntity* e : fresh) recordLatency(*e, submitted);
+		for (std::size_t i = 0; i < fresh.size(); ++i) {
+			const OverteEntity& e = *fresh[i];
+			nodeFor(e.slot) = nodes[i];
+			stardust.setNodeModel(nodes[i], strings.str(modelFor(e)), m_assetDomain);
+			stardust.setNodeTexture(nodes[i], strings.str(e.textureUrl), m_assetDomain);
+		}
+	}
+
+	if (parenting) {
+		for (const OverteEntity* e : m_batch) linkParent(stardust, *e);
+		// Children sent in an earlier batch than their parent sit under the
+		// root in the domain frame; re-link them now that the parent has a node.
+		if (!fresh.empty()) {
+			for (const OverteEntity* e : m_batch) {
+				if (e->slot >= m_inBatch.size()) m_inBatch.resize(e->slot + 1, 0);
+				m_inBatch[e->slot] = 1;
 			}
-			if (!e.textureUrl.empty()) {
-				stardust.setNodeTexture(it->second, e.textureUrl);
+			const auto now = Clock::now();
+			for (const OverteEntity* e : fresh) {
+				for (auto child : world.hierarchy().children(e->slot)) {
+					const bool inBatch = child < m_inBatch.size() && m_inBatch[child];
+					if (!inBatch && nodeFor(child) != StardustBridge::InvalidNode) m_scheduler.mark(child, now);
+				}
 			}
+			for (const OverteEntity* e : m_batch) m_inBatch[e->slot] = 0;
+		}
+	}
+	return fresh.size();
+}
+
+void SceneSync::recordLatency(const OverteEntity& e, Clock::time_point submitted) {
+	// Entities queued without a network change (restored, re-parented) have no rxTime
+	const Clock::time_point rxTime = m_scheduler.takeRxTime(e.slot);
+	if (rxTime == Clock::time_point{}) return;
+	m_latency.record(e.type, submitted - rxTime, e.id);
+}
+
+void SceneSync::linkParent(StardustBridge& stardust, const OverteEntity& e) {
+	const StardustBridge::NodeId node = nodeFor(e.slot);
+	std::optional<StardustBridge::NodeId> parent = m_root;
+	if (e.parentSlot != EntityHierarchy::npos) {
+		const StardustBridge::NodeId p = nodeFor(e.parentSlot);
+		if (p != StardustBridge::InvalidNode) {
+			parent = p;
+		} else {
+			// Parent has no node; place the child in the domain frame until it does
+			stardust.updateNodeTransform(node, e.worldTransform);
 		}
 	}
+	stardust.setNodeParent(node, parent);
+}
 
-	// Process deletions after updates to avoid create-then-delete thrash.
-	auto deleted = overte.consumeDeletedEntities();
-	for (auto entId : deleted) {
-		auto it = s_entityNodeMap.find(entId);
-		if (it != s_entityNodeMap.end()) {
-			stardust.removeNode(it->second);
-			s_entityNodeMap.erase(it);
+void SceneSync::syncEntity(StardustBridge& stardust, StringTable& strings, const OverteEntity& e, const glm::mat4& transform) {
+	// Update existing node's transform and visual properties
+	const StardustBridge::NodeId node = nodeFor(e.slot);
+	stardust.updateNodeTransform(node, transform);
+	stardust.setNodeEntityType(node, static_cast<uint8_t>(e.type));
+	stardust.setNodeColor(node, e.color, e.alpha);
+	stardust.setNodeDimensions(node, e.dimensions);
+	
+	// The bridge remembers the URLs bound to each node (and forgets one
+	// whose download failed), so unchanged assets stop there
+	stardust.setNodeModel(node, strings.str(modelFor(e)), m_assetDomain);
+	stardust.setNodeTexture(node, strings.str(e.textureUrl), m_assetDomain);
+}
+
+StringId SceneSync::modelFor(const OverteEntity& e) const {
+	return e.slot < m_detailShed.size() && m_detailShed[e.slot] ? StringTable::Empty : e.modelUrl;
+}
+
+void SceneSync::updateDetail(StardustBridge& stardust, const EntityWorld& world, const glm::vec3& eye) {
+	const auto& store = world.store();
+	if (m_shedDetail) {
+		m_shedDetail = false;
+		std::size_t shed = 0;
+		for (std::uint32_t slot = 0; slot < m_entityNodes.size(); ++slot) {
+			const StardustBridge::NodeId node = m_entityNodes[slot];
+			if (node == StardustBridge::InvalidNode || !store.isLive(slot)) continue;
+			const OverteEntity& e = store.at(slot);
+			if (modelFor(e) == StringTable::Empty) continue;  // No model, or already shed
+			if (glm::length(glm::vec3(e.worldTransform[3]) - eye) <= kDetailRadius) continue;
+			stardust.setNodeModel(node, "");
+			if (slot >= m_detailShed.size()) m_detailShed.resize(slot + 1, 0);
+			m_detailShed[slot] = 1;
+			m_detailShedSlots.push_back(slot);
+			++shed;
+		}
+		if (shed > 0) {
+			std::cout << "[SceneSync] Memory pressure: unbound " << shed << " models beyond " << kDetailRadius
+			          << " m" << std::endl;
 		}
+		return;
 	}
+	if (m_detailShedSlots.empty() || MemoryBudget::instance().pressure() != MemoryBudget::Pressure::None) return;
+
+	// Pressure is gone: queue the entities again so syncEntity rebinds them
+	const auto now = Clock::now();
+	std::size_t restored = 0;
+	for (std::uint32_t slot : m_detailShedSlots) {
+		if (slot >= m_detailShed.size() || !m_detailShed[slot]) continue;  // Erased meanwhile
+		m_detailShed[slot] = 0;
+		if (store.isLive(slot)) {
+			m_scheduler.mark(slot, now);
+			++restored;
+		}
+	}
+	m_detailShedSlots.clear();
+	std::cout << "[SceneSync] Memory pressure gone: restoring " << restored << " models" << std::endl;
 }
 
+void SceneSync::processDeletions(StardustBridge& stardust, EntityWorld& world) {
+	const auto deleted = world.consumeDeleted(m_frameArena.resource());
+	for (auto slot : deleted) {
+		// Unsent changes of erased entities are dropped; the slot may be reused
+		m_scheduler.drop(slot);
+		if (slot < m_detailShed.size()) m_detailShed[slot] = 0;
+		if (slot < m_entityNodes.size() && m_entityNodes[slot] != StardustBridge::InvalidNode) {
+			stardust.removeNode(m_entityNodes[slot]);
+			m_entityNodes[slot] = StardustBridge::InvalidNode;
+		}
+	}
+}
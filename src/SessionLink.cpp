@@ -0,0 +1,35 @@
+// SessionLink.cpp
+#include "SessionLink.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+SessionLink::Clock::duration SessionLink::timeoutFromEnv() {
+    if (const char* env = std::getenv("STARWORLD_DOMAIN_TIMEOUT_MS")) {
+        return std::chrono::milliseconds(std::max(500, std::atoi(env)));
+    }
+    return std::chrono::seconds(5);
+}
+
+void SessionLink::heard(Clock::time_point now) {
+    m_lastHeard = std::max(m_lastHeard, now);
+}
+
+SessionLink::Join SessionLink::joined(Clock::time_point now, bool newConnection) {
+    heard(now);
+    const State before = m_state;
+    m_state = State::Connected;
+    if (before == State::Connecting) return Join::First;
+    // Replies to handshake retries that crossed the first DomainList
+    if (before == State::Connected) return Join::Resumed;
+    m_lastOutage = now - m_lostSince;
+    return newConnection ? Join::Rejoined : Join::Resumed;
+}
+
+bool SessionLink::checkLost(Clock::time_point now) {
+    if (m_state != State::Connected || now - m_lastHeard < m_timeout) return false;
+    m_state = State::Lost;
+    m_lostSince = m_lastHeard;
+    ++m_outages;
+    return true;
+}
@@ -0,0 +1,61 @@
+// SessionLink.hpp
+// Liveness of the domain session, and what a DomainList means after an outage.
+//
+// The client keeps its session UUID, local ID and connection token for its
+// whole lifetime, so after a network blip the domain server can recognize it
+// and keep the node (and the entity server its per-node send state) instead
+// of starting over. SessionLink only decides:
+//   - when the domain has been silent long enough to call the link lost, so
+//     the handshake is retried right away with the same identity
+//   - whether the DomainList that ends an outage resumed the old node or
+//     created a new one, in which case the server sends the whole world again
+//     and the client has to diff it against the entities it kept
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+class SessionLink {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class State : std::uint8_t {
+		Connecting,  // No DomainList yet
+		Connected,
+		Lost         // Silent for the timeout; handshake being retried
+	};
+
+	enum class Join : std::uint8_t {
+		First,     // First DomainList of this client
+		Resumed,   // Same node on the server: nothing to resync
+		Rejoined   // New node on the server: full resend follows
+	};
+
+	// STARWORLD_DOMAIN_TIMEOUT_MS overrides the default 5 s (Overte's node
+	// silence threshold).
+	static Clock::duration timeoutFromEnv();
+
+	explicit SessionLink(Clock::duration timeout = std::chrono::seconds(5)) : m_timeout(timeout) {}
+
+	// Any packet from the domain server.
+	void heard(Clock::time_point now);
+	// A DomainList was accepted. `newConnection`: the server made a new node
+	// for us (the DomainList flag of that name, or a changed local ID).
+	Join joined(Clock::time_point now, bool newConnection);
+	// Call every poll. True once when the link turns Lost.
+	bool checkLost(Clock::time_point now);
+
+	State state() const { return m_state; }
+	Clock::duration timeout() const { return m_timeout; }
+	std::uint32_t outages() const { return m_outages; }
+	// How long the domain was silent before the last join (zero if never lost)
+	Clock::duration lastOutage() const { return m_lastOutage; }
+
+private:
+	Clock::duration m_timeout;
+	State m_state{State::Connecting};
+	Clock::time_point m_lastHeard{};
+	Clock::time_point m_lostSince{};
+	Clock::duration m_lastOutage{};
+	std::uint32_t m_outages{0};
+};
@@ -82,9 +82,8 @@ bool StardustBridge::connect(const std::string& socketPath) {
             m_connected = true;
             std::cout << "[StardustBridge] Connected via Rust bridge (C-ABI)." << std::endl;
             std::cout.flush();
-            // Don't create root node during connect - it causes deadlock with Rust bridge
-            // We'll create it later when needed
-            // m_overteRoot = createNode("OverteWorld");
+            // Don't create nodes during connect - it causes deadlock with Rust bridge.
+            // Each SceneSync creates its session's root on first update.
             std::cout << "[StardustBridge] Rust bridge fully initialized" << std::endl;
             std::cout.flush();
             return true;
@@ -136,11 +135,7 @@ bool StardustBridge::connect(const std::string& socketPath) {
         m_socketPath = p;
         m_connected = true;
     std::cout << "[StardustBridge] Connected to compositor at " << (isAbstract ? ("abstract:" + p.substr(1)) : p) << std::endl;
-
-        m_overteRoot = createNode("OverteWorld");
-        // Set root node to type 0 (Unknown) with zero dimensions so it doesn't render
-        setNodeEntityType(*m_overteRoot, 0);
-        setNodeDimensions(*m_overteRoot, glm::vec3(0.0f, 0.0f, 0.0f));
+        // Session roots ("OverteWorld") are created by SceneSync
         return true;
     }
 
@@ -150,148 +145,281 @@ bool StardustBridge::connect(const std::string& socketPath) {
     return false;
 }
 
+StardustBridge::Node* StardustBridge::findNode(NodeId id) {
+    if (id >= m_nodes.size() || !m_nodes[id].live) return nullptr;
+    return &m_nodes[id];
+}
+
 StardustBridge::NodeId StardustBridge::createNode(const std::string& name,
                                                   const glm::mat4& transform,
                                                   std::optional<NodeId> parent) {
-    NodeId id = m_nextId++;
-    m_nodes.emplace(id, Node{ name, parent, transform });
+    NodeId id;
+    if (!m_freeNodes.empty()) {
+        id = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    } else {
+        id = static_cast<NodeId>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    Node& node = m_nodes[id];
+    node = Node{};
+    node.name = name;
+    node.parent = parent;
+    node.transform = transform;
+    node.live = true;
     // Forward to Rust bridge if available.
     if (m_fnCreateNode) {
         float m[16];
         // GLM mat4 is column-major; pass as 16 floats as-is
         std::memcpy(m, &transform[0][0], sizeof(m));
-        std::uint64_t rid = m_fnCreateNode(name.c_str(), m);
-        (void)rid; // Could map to NodeId if Rust returns its own id
+        node.remoteId = m_fnCreateNode(name.c_str(), m);
+    }
+    if (parent) {
+        // Recorded above; forward the link now that the node has a bridge id.
+        const Node* p = findNode(*parent);
+        if (!p) {
+            node.parent.reset();
+        } else if (m_fnSetParent && node.remoteId && p->remoteId) {
+            (void)m_fnSetParent(node.remoteId, p->remoteId);
+        }
     }
     return id;
 }
 
+std::vector<StardustBridge::NodeId> StardustBridge::createNodes(std::span<const NodeDesc> descs) {
+    std::vector<NodeId> ids;
+    ids.reserve(descs.size());
+
+    auto createOneByOne = [&] {
+        for (const auto& d : descs) {
+            NodeId id = createNode(d.name, d.transform);
+            setNodeEntityType(id, d.entityType);
+            setNodeColor(id, d.color, d.alpha);
+            setNodeDimensions(id, d.dimensions);
+            ids.push_back(id);
+        }
+        return ids;
+    };
+    if (!m_fnCreateNodes) return createOneByOne();
+
+    std::vector<SdxrNodeDesc> wire(descs.size());
+    for (std::size_t i = 0; i < descs.size(); ++i) {
+        const auto& d = descs[i];
+        auto& w = wire[i];
+        w.name = d.name.c_str();
+        std::memcpy(w.transform, &d.transform[0][0], sizeof(w.transform));
+        w.color[0] = d.color.r; w.color[1] = d.color.g; w.color[2] = d.color.b; w.color[3] = d.alpha;
+        w.dimensions[0] = d.dimensions.x; w.dimensions[1] = d.dimensions.y; w.dimensions[2] = d.dimensions.z;
+        w.entityType = d.entityType;
+    }
+    std::vector<std::uint64_t> remoteIds(descs.size(), 0);
+    if (m_fnCreateNodes(wire.data(), wire.size(), remoteIds.data()) != 0) {
+        // The batch is all-or-nothing on the Rust side; go through the
+        // per-node path so each node still gets a bridge id of its own
+        std::cerr << "[StardustBridge] Batched create of " << descs.size()
+                  << " nodes failed, creating them one by one" << std::endl;
+        return createOneByOne();
+    }
+
+    for (std::size_t i = 0; i < descs.size(); ++i) {
+        NodeId id;
+        if (!m_freeNodes.empty()) {
+            id = m_freeNodes.back();
+            m_freeNodes.pop_back();
+        } else {
+            id = static_cast<NodeId>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+        const auto& d = descs[i];
+        Node& node = m_nodes[id];
+        node = Node{};
+        node.name = d.name;
+        node.transform = d.transform;
+        node.remoteId = remoteIds[i];
+        node.live = true;
+        // The batch carried the visual properties only if it created the node
+        node.sent = node.remoteId ? SentColor | SentDimensions | SentEntityType : 0;
+        node.color = glm::vec4(d.color, d.alpha);
+        node.dimensions = d.dimensions;
+        node.entityType = d.entityType;
+        ids.push_back(id);
+    }
+    return ids;
+}
+
 bool StardustBridge::updateNodeTransform(NodeId id, const glm::mat4& transform) {
-    auto it = m_nodes.find(id);
-    if (it == m_nodes.end()) return false;
-    it->second.transform = transform;
-    if (m_fnUpdateNode) {
+    Node* node = findNode(id);
+    if (!node) return false;
+    if (node->transform == transform) return true;
+    node->transform = transform;
+    if (m_fnUpdateNode && node->remoteId) {
         float m[16];
         std::memcpy(m, &transform[0][0], sizeof(m));
-        (void)m_fnUpdateNode(id, m);
+        (void)m_fnUpdateNode(node->remoteId, m);
     }
     return true;
 }
 
-bool StardustBridge::removeNode(NodeId id) {
-    auto it = m_nodes.find(id);
-    if (it == m_nodes.end()) return false;
-    m_nodes.erase(it);
-    if (m_fnRemoveNode) {
-        (void)m_fnRemoveNode(id);
+bool StardustBridge::setNodeParent(NodeId id, std::optional<NodeId> parent) {
+    Node* node = findNode(id);
+    if (!node) return false;
+    if (node->parent == parent) return true;
+    std::uint64_t parentRemote = 0;
+    if (parent) {
+        const Node* p = findNode(*parent);
+        if (!p || *parent == id) return false;
+        parentRemote = p->remoteId;
+    }
+    node->parent = parent;
+    if (m_fnSetParent && node->remoteId) {
+        (void)m_fnSetParent(node->remoteId, parentRemote);
     }
     return true;
 }
 
-bool StardustBridge::setNodeModel(NodeId id, const std::string& modelUrl) {
-    auto it = m_nodes.find(id);
-    if (it == m_nodes.end()) return false;
-    
-    // Check if URL is HTTP(S) - if so, download via ModelCache
-    if (modelUrl.substr(0, 7) == "http://" || modelUrl.substr(0, 8) == "https://") {
-        // Request download from ModelCache
-        ModelCache::instance().requestModel(
-            modelUrl,
-            [this, id](const std::string& url, bool success, const std::string& localPath) {
-                if (success && m_fnSetModel) {
-                    std::cout << "[StardustBridge] Model downloaded: " << url << " -> " << localPath << std::endl;
-                    m_fnSetModel(id, localPath.c_str());
-                } else if (!success) {
-                    std::cerr << "[StardustBridge] Failed to download model: " << url << std::endl;
-                    // Fall back to primitive based on entity type if download fails
-                    // The Rust bridge will handle this via get_model_path()
-                }
-            },
-            [id](const std::string& url, size_t bytesReceived, size_t bytesTotal) {
-                // Optional: log download progress
-                if (bytesTotal > 0) {
-                    float percent = (bytesReceived * 100.0f) / bytesTotal;
-                    std::cout << "[StardustBridge] Downloading model " << id << ": " 
-                              << percent << "% (" << bytesReceived << "/" << bytesTotal << " bytes)" << std::endl;
-                }
-            }
-        );
-        return true; // Download initiated, will complete asynchronously
-    }
-    
-    // Direct URL (file://, atp://, etc.) - pass through to bridge
-    if (m_fnSetModel) {
-        return m_fnSetModel(id, modelUrl.c_str()) == 0;
+bool StardustBridge::removeNode(NodeId id) {
+    Node* node = findNode(id);
+    if (!node) return false;
+    if (m_fnRemoveNode && node->remoteId) {
+        (void)m_fnRemoveNode(node->remoteId);
     }
+    *node = Node{};
+    m_freeNodes.push_back(id);
     return true;
 }
 
-bool StardustBridge::setNodeTexture(NodeId id, const std::string& textureUrl) {
-    auto it = m_nodes.find(id);
-    if (it == m_nodes.end()) return false;
-    
-    // Check if URL is HTTP(S) - if so, download via ModelCache (also works for textures!)
-    if (textureUrl.substr(0, 7) == "http://" || textureUrl.substr(0, 8) == "https://") {
-        // Request download from ModelCache (cache handles all file types)
+bool StardustBridge::setNodeModel(NodeId id, const std::string& modelUrl, const std::string& assetDomain) {
+    Node* node = findNode(id);
+    if (!node) return false;
+    if (node->modelUrl == modelUrl) return true;
+    // Recorded up front so a completion can tell it is still wanted; a
+    // failed bind clears it again, so the next call retries
+    node->modelUrl = modelUrl;
+    if (bindAsset(id, *node, AssetKind::Model, modelUrl, assetDomain)) return true;
+    node->modelUrl.clear();
+    return false;
+}
+
+bool StardustBridge::setNodeTexture(NodeId id, const std::string& textureUrl, const std::string& assetDomain) {
+    Node* node = findNode(id);
+    if (!node) return false;
+    if (node->textureUrl == textureUrl) return true;
+    node->textureUrl = textureUrl;
+    if (bindAsset(id, *node, AssetKind::Texture, textureUrl, assetDomain)) return true;
+    node->textureUrl.clear();
+    return false;
+}
+
+bool StardustBridge::bindAsset(NodeId id, const Node& node, AssetKind kind, const std::string& url,
+                               const std::string& assetDomain) {
+    const std::uint64_t rid = node.remoteId;
+
+    // HTTP(S) and atp: assets (models and textures alike) go through
+    // ModelCache. Its callback may run on a download thread, so it only posts
+    // the result; applyAssetCompletions() forwards it from poll() on the main
+    // thread.
+    if (url.rfind("http://", 0) == 0 || url.rfind("https://", 0) == 0 || url.rfind("atp:", 0) == 0) {
+        std::weak_ptr<MpscQueue<AssetCompletion>> queue = m_assetCompletions;
         ModelCache::instance().requestModel(
-            textureUrl,
-            [this, id](const std::string& url, bool success, const std::string& localPath) {
-                if (success && m_fnSetTexture) {
-                    std::cout << "[StardustBridge] Texture downloaded: " << url << " -> " << localPath << std::endl;
-                    m_fnSetTexture(id, localPath.c_str());
-                } else if (!success) {
-                    std::cerr << "[StardustBridge] Failed to download texture: " << url << std::endl;
+            url,
+            [queue, id, rid, kind](const std::string& u, bool success, const std::string& localPath) {
+                if (auto q = queue.lock()) {
+                    q->push(AssetCompletion{id, rid, kind, success, u, localPath});
                 }
             },
-            [id](const std::string& url, size_t bytesReceived, size_t bytesTotal) {
-                // Optional: log download progress
-                if (bytesTotal > 0 && bytesReceived % 1024 == 0) { // Log every 1KB to reduce spam
-                    float percent = (bytesReceived * 100.0f) / bytesTotal;
-                    std::cout << "[StardustBridge] Downloading texture for node " << id << ": " 
-                              << percent << "% (" << bytesReceived << "/" << bytesTotal << " bytes)" << std::endl;
-                }
-            }
-        );
+            nullptr, assetDomain);
         return true; // Download initiated, will complete asynchronously
     }
-    
+
     // Direct URL (file://, data:, etc.) - pass through to bridge
-    if (m_fnSetTexture) {
-        return m_fnSetTexture(id, textureUrl.c_str()) == 0;
+    fn_set_model_t fn = kind == AssetKind::Model ? m_fnSetModel : m_fnSetTexture;
+    if (fn && rid) {
+        return fn(rid, url.c_str()) == 0;
     }
     return true;
 }
 
+void StardustBridge::applyAssetCompletions() {
+    // Coalesce per node and kind: only the last result of the frame is sent.
+    m_assetBatch.clear();
+    m_assetCompletions->drain([&](AssetCompletion&& c) {
+        for (auto& pending : m_assetBatch) {
+            if (pending.id == c.id && pending.kind == c.kind) {
+                pending = std::move(c);
+                return;
+            }
+        }
+        m_assetBatch.push_back(std::move(c));
+    });
+
+    for (const auto& c : m_assetBatch) {
+        const char* what = c.kind == AssetKind::Model ? "Model" : "Texture";
+        // Drop results for nodes that were removed (or whose slot was reused)
+        // or rebound to another URL while the download ran.
+        Node* node = findNode(c.id);
+        std::string* bound = node ? (c.kind == AssetKind::Model ? &node->modelUrl : &node->textureUrl) : nullptr;
+        const bool current = node && node->remoteId == c.remoteId && *bound == c.url;
+        if (!c.success) {
+            // The Rust bridge falls back to a primitive via get_model_path().
+            // The node no longer counts as bound, so setting the URL again retries.
+            std::cerr << "[StardustBridge] Failed to download " << (c.kind == AssetKind::Model ? "model" : "texture")
+                      << ": " << c.url << std::endl;
+            if (current) bound->clear();
+            continue;
+        }
+        if (!current) continue;
+
+        fn_set_model_t fn = c.kind == AssetKind::Model ? m_fnSetModel : m_fnSetTexture;
+        if (fn && c.remoteId) {
+            std::cout << "[StardustBridge] " << what << " ready: " << c.url << " -> " << c.localPath << std::endl;
+            (void)fn(c.remoteId, c.localPath.c_str());
+        }
+    }
+}
+
 bool StardustBridge::setNodeColor(NodeId id, const glm::vec3& color, float alpha) {
-    auto it = m_nodes.find(id);
-    if (it == m_nodes.end()) return false;
+    Node* node = findNode(id);
+    if (!node) return false;
+    const glm::vec4 rgba(color, alpha);
+    if ((node->sent & SentColor) && node->color == rgba) return true;
+    node->color = rgba;
+    // Marked sent only once the bridge took it, so a node the runtime has
+    // no id for (or a failed call) is sent again next time
     if (m_fnSetColor) {
-        return m_fnSetColor(id, color.r, color.g, color.b, alpha) == 0;
+        if (!node->remoteId || m_fnSetColor(node->remoteId, color.r, color.g, color.b, alpha) != 0) return false;
     } else {
         std::cerr << "[StardustBridge] Warning: setNodeColor called but m_fnSetColor is null" << std::endl;
     }
+    node->sent |= SentColor;
     return true;
 }
 
 bool StardustBridge::setNodeDimensions(NodeId id, const glm::vec3& dimensions) {
-    auto it = m_nodes.find(id);
-    if (it == m_nodes.end()) return false;
+    Node* node = findNode(id);
+    if (!node) return false;
+    if ((node->sent & SentDimensions) && node->dimensions == dimensions) return true;
+    node->dimensions = dimensions;
     if (m_fnSetDimensions) {
-        return m_fnSetDimensions(id, dimensions.x, dimensions.y, dimensions.z) == 0;
+        if (!node->remoteId || m_fnSetDimensions(node->remoteId, dimensions.x, dimensions.y, dimensions.z) != 0) return false;
     }
+    node->sent |= SentDimensions;
     return true;
 }
 
 bool StardustBridge::setNodeEntityType(NodeId id, uint8_t entityType) {
-    auto it = m_nodes.find(id);
-    if (it == m_nodes.end()) return false;
+    Node* node = findNode(id);
+    if (!node) return false;
+    if ((node->sent & SentEntityType) && node->entityType == entityType) return true;
+    node->entityType = entityType;
     if (m_fnSetEntityType) {
-        return m_fnSetEntityType(id, entityType) == 0;
+        if (!node->remoteId || m_fnSetEntityType(node->remoteId, entityType) != 0) return false;
     }
+    node->sent |= SentEntityType;
     return true;
 }
 
 void StardustBridge::poll() {
+    applyAssetCompletions();
     if (!m_connected) return;
 
     if (m_fnPoll) {
@@ -333,6 +461,36 @@ void StardustBridge::poll() {
     m_headPose = glm::mat4(1.0f);
 }
 
+StardustBridge::FrameTiming StardustBridge::frameTiming() const {
+    FrameTiming timing;
+    SdxrFrameTiming raw{};
+    if (!m_fnFrameTiming || m_fnFrameTiming(&raw) != 0) return timing;
+    // The bridge reports durations relative to the call; anchor them to our clock.
+    const auto now = std::chrono::steady_clock::now();
+    timing.valid = true;
+    timing.frameCount = raw.frameCount;
+    timing.lastFrame = now - std::chrono::nanoseconds(raw.sinceFrameNs);
+    timing.predictedNext = now + std::chrono::nanoseconds(raw.predictedNextNs);
+    timing.delta = raw.delta;
+    return timing;
+}
+
+StardustBridge::QueueStatus StardustBridge::queueStatus() const {
+    QueueStatus status;
+    if (!m_bridgeHandle) {
+        // In-process scene: every call is applied immediately
+        status.valid = true;
+        return status;
+    }
+    SdxrQueueStatus raw{};
+    if (!m_fnQueueStatus || m_fnQueueStatus(&raw) != 0) return status;
+    status.valid = true;
+    status.submitted = raw.submitted;
+    status.applied = raw.applied;
+    status.presented = raw.presented;
+    return status;
+}
+
 void StardustBridge::close() {
     if (m_fnShutdown) m_fnShutdown();
     if (m_socketFd >= 0) {
@@ -342,8 +500,31 @@ void StardustBridge::close() {
     m_connected = false;
 }
 
+StardustBridge::StardustBridge() {
+    m_shedder = MemoryBudget::instance().addShedder("Bridge nodes", MemoryBudget::Pressure::Soft,
+                                                    [this](MemoryBudget::Pressure) { shrink(); });
+}
+
 // Ensure socket is closed on destruction
-StardustBridge::~StardustBridge() { close(); }
+StardustBridge::~StardustBridge() {
+    MemoryBudget::instance().removeShedder(m_shedder);
+    close();
+}
+
+void StardustBridge::shrink() {
+    // Removed nodes at the end of the table are not referenced by any id
+    std::size_t end = m_nodes.size();
+    while (end > 0 && !m_nodes[end - 1].live) --end;
+    if (end < m_nodes.size()) {
+        m_nodes.resize(end);
+        m_freeNodes.erase(std::remove_if(m_freeNodes.begin(), m_freeNodes.end(),
+                                         [end](NodeId id) { return id >= end; }),
+                          m_freeNodes.end());
+    }
+    releaseSpare(m_nodes);
+    releaseSpare(m_freeNodes);
+    decltype(m_assetBatch)().swap(m_assetBatch);
+}
 
 bool StardustBridge::loadBridge() {
     if (m_bridgeHandle) return true;
@@ -380,6 +561,10 @@ bool StardustBridge::loadBridge() {
         m_fnSetColor = reinterpret_cast<fn_set_color_t>(req("sdxr_set_node_color"));
         m_fnSetDimensions = reinterpret_cast<fn_set_dimensions_t>(req("sdxr_set_node_dimensions"));
         m_fnSetEntityType = reinterpret_cast<fn_set_entity_type_t>(req("sdxr_set_node_entity_type"));
+        m_fnCreateNodes = reinterpret_cast<fn_create_nodes_t>(req("sdxr_create_nodes"));
+        m_fnSetParent = reinterpret_cast<fn_set_parent_t>(req("sdxr_set_node_parent"));
+        m_fnFrameTiming = reinterpret_cast<fn_frame_timing_t>(req("sdxr_frame_timing"));
+        m_fnQueueStatus = reinterpret_cast<fn_queue_status_t>(req("sdxr_queue_status"));
         if (m_fnStart && m_fnPoll && m_fnCreateNode && m_fnUpdateNode) {
             m_bridgeHandle = h;
             std::cout << "[StardustBridge] Loaded Rust bridge: " << path << std::endl;
@@ -1,20 +1,30 @@
 // StardustBridge.hpp
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include <functional>
 
 #include <glm/glm.hpp>
 
+#include "MemoryBudget.hpp"
+#include "MpscQueue.hpp"
+
 // A lightweight bridge to the StardustXR compositor.
 // Assumes a C API is available at runtime; this implementation provides a
 // minimal in-process fallback so the app remains testable without the shared lib.
 class StardustBridge {
 public:
-	using NodeId = std::uint64_t;
+	// Dense slot index into the bridge's node table. Slots of removed nodes
+	// are reused, so ids are only meaningful while the node exists.
+	using NodeId = std::uint32_t;
+	static constexpr NodeId InvalidNode = 0xFFFFFFFFu;
 
 	// Connect to the StardustXR compositor via IPC.
 	// Returns true on success. Searches standard socket locations if socketPath is empty.
@@ -26,12 +36,40 @@ public:
 					  const glm::mat4& transform = glm::mat4(1.0f),
 					  std::optional<NodeId> parent = std::nullopt);
 
+	// Initial properties for createNodes().
+	struct NodeDesc {
+		std::string name;
+		glm::mat4 transform{1.0f};
+		glm::vec3 color{1.0f};
+		float alpha{1.0f};
+		glm::vec3 dimensions{0.1f};
+		std::uint8_t entityType{1};
+	};
+
+	// Create many nodes with their visual properties in one call (initial
+	// world load). Uses the bridge's batch entry point when it exports one,
+	// otherwise falls back to per-node calls. Ids are returned in input order.
+	std::vector<NodeId> createNodes(std::span<const NodeDesc> descs);
+
+	// Parent `id` under `parent` (nullopt = root). The node's transform is
+	// then relative to the parent, so moving a parent is one update for the
+	// whole subtree. No-op if unchanged; false if either node doesn't exist.
+	bool setNodeParent(NodeId id, std::optional<NodeId> parent);
+
+	// True if parent links reach the compositor. Older bridges without
+	// sdxr_set_node_parent need world-space transforms for every node.
+	bool supportsParenting() const { return !m_bridgeHandle || m_fnSetParent; }
+
 	// Update a node's transform. Returns false if the node doesn't exist.
+	// Unchanged transforms are not forwarded.
 	bool updateNodeTransform(NodeId id, const glm::mat4& transform);
 	
-	// Set visual properties for a node
-	bool setNodeModel(NodeId id, const std::string& modelUrl);
-	bool setNodeTexture(NodeId id, const std::string& textureUrl);
+	// Set visual properties for a node. Setting a value the node already has
+	// (transform, color, dimensions, type, asset URL) is a no-op: no FFI call,
+	// so the bridge's command queue only sees real changes. `assetDomain`
+	// is the domain whose asset server resolves atp:// URLs.
+	bool setNodeModel(NodeId id, const std::string& modelUrl, const std::string& assetDomain = {});
+	bool setNodeTexture(NodeId id, const std::string& textureUrl, const std::string& assetDomain = {});
 	bool setNodeColor(NodeId id, const glm::vec3& color, float alpha = 1.0f);
 	bool setNodeDimensions(NodeId id, const glm::vec3& dimensions);
 	bool setNodeEntityType(NodeId id, uint8_t entityType);
@@ -39,9 +77,34 @@ public:
 	// Remove a node. Returns false if the node doesn't exist.
 	bool removeNode(NodeId id);
 
-	// Poll compositor events and input. Non-blocking.
+	// Poll compositor events and input, and forward finished asset downloads.
+	// Non-blocking; must be called from the main thread.
 	void poll();
 
+	// Compositor frame timing as last reported by the bridge.
+	struct FrameTiming {
+		bool valid{false};  // false until the first frame (or without the bridge)
+		std::uint64_t frameCount{0};
+		std::chrono::steady_clock::time_point lastFrame{};
+		std::chrono::steady_clock::time_point predictedNext{};
+		float delta{0.0f};  // compositor frame period in seconds
+	};
+	// Queries the bridge (sdxr_frame_timing) on every call; cheap.
+	FrameTiming frameTiming() const;
+
+	// How far the compositor side is behind our submissions, in bridge
+	// commands (one per node call, one per createNodes batch).
+	struct QueueStatus {
+		bool valid{false};  // false with a bridge that can't report it
+		std::uint64_t submitted{0};
+		std::uint64_t applied{0};    // applied to the bridge's scene state
+		std::uint64_t presented{0};  // `applied` as of the last compositor frame
+		std::uint64_t depth() const { return submitted - applied; }
+		std::uint64_t unpresented() const { return applied - presented; }
+	};
+	// sdxr_queue_status; without the runtime nothing is ever queued.
+	QueueStatus queueStatus() const;
+
 	// Lifecycle helpers for the main loop.
 	bool running() const { return m_running; }
 	void requestQuit() { m_running = false; }
@@ -50,20 +113,60 @@ public:
 	glm::vec2 joystick() const { return m_joystick; }   // x,y in [-1, 1]
 	glm::mat4 headPose() const { return m_headPose; }   // world-from-head
 
+	StardustBridge();
 	~StardustBridge();
+	StardustBridge(const StardustBridge&) = delete;
+	StardustBridge& operator=(const StardustBridge&) = delete;
 	// Explicit cleanup
 	void close();
 
+	// Drop removed nodes at the end of the table and spare capacity
+	// (memory pressure).
+	void shrink();
+
 private:
 	struct Node {
 		std::string name;
 		std::optional<NodeId> parent;
 		glm::mat4 transform{1.0f};
+		std::uint64_t remoteId{0}; // Id returned by the Rust bridge (0 = none)
+		bool live{false};
+		// Asset URLs bound to this node, or being downloaded for it (cleared
+		// if the bind or download fails)
+		std::string modelUrl;
+		std::string textureUrl;
+		// Visual properties last sent (valid per bit of `sent`)
+		std::uint8_t sent{0};
+		glm::vec4 color{1.0f};
+		glm::vec3 dimensions{0.1f};
+		std::uint8_t entityType{0};
 	};
+	enum SentBits : std::uint8_t { SentColor = 1, SentDimensions = 2, SentEntityType = 4 };
+
+	enum class AssetKind : std::uint8_t { Model, Texture };
+
+	// Result of a ModelCache download, posted from whichever thread finished it.
+	struct AssetCompletion {
+		NodeId id;
+		std::uint64_t remoteId; // Identifies the node instance if the slot is reused
+		AssetKind kind;
+		bool success;
+		std::string url;
+		std::string localPath;
+	};
+
+	// Live node for `id`, or nullptr.
+	Node* findNode(NodeId id);
 
-	// Fallback in-process scene representation for testing without the runtime.
-	std::unordered_map<NodeId, Node> m_nodes;
-	NodeId m_nextId{1};
+	bool bindAsset(NodeId id, const Node& node, AssetKind kind, const std::string& url, const std::string& assetDomain);
+	// Main thread: validate queued completions against live nodes and send them.
+	void applyAssetCompletions();
+
+	// Node table, indexed by NodeId. Doubles as the in-process scene when
+	// running without the runtime.
+	TrackedVector<Node, MemoryBudget::Subsystem::BridgeNodes> m_nodes;
+	TrackedVector<NodeId, MemoryBudget::Subsystem::BridgeNodes> m_freeNodes;
+	int m_shedder{0};  // MemoryBudget registration
 
 	// Connection and state
 	bool m_connected{false};
@@ -75,8 +178,10 @@ private:
 	glm::vec2 m_joystick{0.0f, 0.0f};
 	glm::mat4 m_headPose{1.0f};
 
-	// Optional root for the Overte world subscene
-	std::optional<NodeId> m_overteRoot;
+	// Download completions. Shared so callbacks firing after the bridge is
+	// destroyed find the queue gone instead of dangling.
+	std::shared_ptr<MpscQueue<AssetCompletion>> m_assetCompletions{std::make_shared<MpscQueue<AssetCompletion>>()};
+	std::vector<AssetCompletion> m_assetBatch; // scratch for applyAssetCompletions()
 
 	// Dynamic Rust bridge (dlopen) function pointers
 	void* m_bridgeHandle{nullptr};
@@ -91,6 +196,32 @@ private:
 	using fn_set_color_t = int(*)(std::uint64_t, float, float, float, float);
 	using fn_set_dimensions_t = int(*)(std::uint64_t, float, float, float);
 	using fn_set_entity_type_t = int(*)(std::uint64_t, std::uint8_t);
+	using fn_set_parent_t = int(*)(std::uint64_t, std::uint64_t);
+	// Layout must match SdxrNodeDesc in bridge/src/lib.rs
+	struct SdxrNodeDesc {
+		const char* name;
+		float transform[16];
+		float color[4];
+		float dimensions[3];
+		std::uint8_t entityType;
+	};
+	using fn_create_nodes_t = int(*)(const SdxrNodeDesc*, std::size_t, std::uint64_t*);
+	// Layout must match SdxrFrameTiming in bridge/src/lib.rs
+	struct SdxrFrameTiming {
+		std::uint64_t frameCount;
+		std::uint64_t sinceFrameNs;
+		std::uint64_t predictedNextNs;
+		float delta;
+		float elapsed;
+	};
+	using fn_frame_timing_t = int(*)(SdxrFrameTiming*);
+	// Layout must match SdxrQueueStatus in bridge/src/lib.rs
+	struct SdxrQueueStatus {
+		std::uint64_t submitted;
+		std::uint64_t applied;
+		std::uint64_t presented;
+	};
+	using fn_queue_status_t = int(*)(SdxrQueueStatus*);
 	
 	fn_start_t m_fnStart{nullptr};
 	fn_poll_t m_fnPoll{nullptr};
@@ -103,6 +234,10 @@ private:
 	fn_set_color_t m_fnSetColor{nullptr};
 	fn_set_dimensions_t m_fnSetDimensions{nullptr};
 	fn_set_entity_type_t m_fnSetEntityType{nullptr};
+	fn_create_nodes_t m_fnCreateNodes{nullptr}; // optional
+	fn_set_parent_t m_fnSetParent{nullptr};     // optional
+	fn_frame_timing_t m_fnFrameTiming{nullptr}; // optional
+	fn_queue_status_t m_fnQueueStatus{nullptr}; // optional
 
 	bool loadBridge();
 };
@@ -0,0 +1,64 @@
+// StringTable.cpp
+#include "StringTable.hpp"
+
+StringTable::StringTable() {
+    m_entries.emplace_back(); // Empty
+}
+
+StringId StringTable::acquire(std::string_view s) {
+    if (s.empty()) return Empty;
+    auto it = m_index.find(s);
+    if (it != m_index.end()) {
+        ++m_entries[it->second].refs;
+        return it->second;
+    }
+
+    StringId id;
+    if (!m_free.empty()) {
+        id = m_free.back();
+        m_free.pop_back();
+    } else {
+        id = static_cast<StringId>(m_entries.size());
+        m_entries.emplace_back();
+    }
+    Entry& e = m_entries[id];
+    e.text.assign(s);
+    e.refs = 1;
+    m_index.emplace(std::string_view(e.text), id);
+    return id;
+}
+
+void StringTable::retain(StringId id) {
+    if (id != Empty) ++m_entries[id].refs;
+}
+
+void StringTable::release(StringId id) {
+    if (id == Empty) return;
+    Entry& e = m_entries[id];
+    if (--e.refs > 0) return;
+    m_index.erase(std::string_view(e.text));
+    std::string().swap(e.text);
+    m_free.push_back(id);
+}
+
+bool StringTable::assign(StringId& field, std::string_view s) {
+    if (str(field) == s) return false;
+    // Acquire first so a shared string is never freed and re-created
+    const StringId id = acquire(s);
+    release(field);
+    field = id;
+    return true;
+}
+
+StringId StringTable::find(std::string_view s) const {
+    if (s.empty()) return Empty;
+    auto it = m_index.find(s);
+    return it != m_index.end() ? it->second : npos;
+}
+
+void StringTable::clear() {
+    m_entries.clear();
+    m_entries.emplace_back();
+    m_free.clear();
+    m_index.clear();
+}
@@ -0,0 +1,55 @@
+// StringTable.hpp
+// Refcounted string interning for entity names and asset URLs.
+//
+// Thousands of entities share a handful of model/texture URLs. The entity
+// store keeps 32-bit ids into this table instead of std::string copies, so
+// copying an entity copies three integers and "did the URL change" is an
+// integer compare. Id 0 is the empty string and is never refcounted.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using StringId = std::uint32_t;
+
+class StringTable {
+public:
+	static constexpr StringId Empty = 0;
+	static constexpr StringId npos = 0xFFFFFFFFu;
+
+	StringTable();
+
+	// Id for `s` with one more reference (Empty for "").
+	StringId acquire(std::string_view s);
+	void retain(StringId id);
+	// Drops one reference; the id is recycled when the count reaches zero.
+	void release(StringId id);
+
+	// Point `field` at `s`, moving its reference. Returns true if it changed.
+	bool assign(StringId& field, std::string_view s);
+
+	// Id for `s` without taking a reference, or npos if not interned.
+	StringId find(std::string_view s) const;
+	const std::string& str(StringId id) const { return m_entries[id].text; }
+	std::uint32_t refs(StringId id) const { return m_entries[id].refs; }
+
+	// Distinct live strings, excluding Empty.
+	std::size_t size() const { return m_index.size(); }
+	void clear();
+
+private:
+	struct Entry {
+		std::string text;
+		std::uint32_t refs{0};
+	};
+
+	// deque: entries never move, so the string_view keys below stay valid
+	std::deque<Entry> m_entries;
+	std::vector<StringId> m_free;
+	std::unordered_map<std::string_view, StringId> m_index;
+};
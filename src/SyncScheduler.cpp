@@ -0,0 +1,109 @@
+// SyncScheduler.cpp
+#include "SyncScheduler.hpp"
+
+void SyncScheduler::mark(std::uint32_t slot, Clock::time_point now, Clock::time_point rxTime) {
+    if (slot >= m_since.size()) {
+        m_since.resize(slot + 1);
+        m_rx.resize(slot + 1);
+    }
+    if (m_rx[slot] == Clock::time_point{}) m_rx[slot] = rxTime;
+    if (m_since[slot] != Clock::time_point{}) return;
+    // A zero time point means "not queued"
+    m_since[slot] = now == Clock::time_point{} ? Clock::time_point{} + Clock::duration(1) : now;
+    m_queue.push_back(slot);
+    ++m_count;
+}
+
+void SyncScheduler::drop(std::uint32_t slot) {
+    if (slot >= m_since.size()) return;
+    m_rx[slot] = {};
+    if (m_since[slot] == Clock::time_point{}) return;
+    m_since[slot] = {};
+    --m_count;
+}
+
+std::size_t SyncScheduler::next(std::size_t n, std::vector<std::uint32_t>& out) {
+    const auto byPriority = [](const Candidate& a, const Candidate& b) { return a.priority < b.priority; };
+    std::size_t appended = 0;
+    while (appended < n && m_cursor < m_candidates.size()) {
+        const std::size_t end = std::min(m_candidates.size(), m_cursor + (n - appended));
+        std::partial_sort(m_candidates.begin() + static_cast<std::ptrdiff_t>(m_cursor),
+                          m_candidates.begin() + static_cast<std::ptrdiff_t>(end),
+                          m_candidates.end(), byPriority);
+        for (; m_cursor < end; ++m_cursor) {
+            const std::uint32_t slot = m_candidates[m_cursor].slot;
+            // Dropped after beginFrame (erased mid-frame)
+            if (!queued(slot)) continue;
+            if (m_takenSince.size() < m_since.size()) m_takenSince.resize(m_since.size());
+            m_takenSince[slot] = m_since[slot];
+            m_since[slot] = {};
+            --m_count;
+            out.push_back(slot);
+            ++appended;
+        }
+    }
+    return appended;
+}
+
+void SyncScheduler::putBack(std::uint32_t slot) {
+    // Re-marked since it was handed out: already queued
+    if (slot >= m_takenSince.size() || queued(slot)) return;
+    m_since[slot] = m_takenSince[slot];
+    m_queue.push_back(slot);
+    ++m_count;
+}
+
+void SyncScheduler::endFrame() {
+    for (; m_cursor < m_candidates.size(); ++m_cursor) {
+        const std::uint32_t slot = m_candidates[m_cursor].slot;
+        if (queued(slot)) m_queue.push_back(slot);
+    }
+    m_candidates.clear();
+    m_cursor = 0;
+}
+
+void SyncScheduler::shrink() {
+    endFrame();
+    // Drop stale entries (dropped slots) before giving the spare room back
+    std::size_t kept = 0;
+    for (std::uint32_t slot : m_queue) {
+        if (queued(slot)) m_queue[kept++] = slot;
+    }
+    m_queue.resize(kept);
+    releaseSpare(m_queue);
+    releaseSpare(m_candidates);
+}
+
+SyncScheduler::Clock::time_point SyncScheduler::takeRxTime(std::uint32_t slot) {
+    if (slot >= m_rx.size()) return {};
+    const Clock::time_point rxTime = m_rx[slot];
+    m_rx[slot] = {};
+    return rxTime;
+}
+
+SubmitThrottle::Level SubmitThrottle::update(std::uint64_t depth) {
+    switch (m_level) {
+        case Level::Clear:
+            if (depth >= m_config.congestedDepth) m_level = Level::Congested;
+            else if (depth >= m_config.behindDepth) m_level = Level::Behind;
+            break;
+        case Level::Behind:
+            if (depth >= m_config.congestedDepth) m_level = Level::Congested;
+            else if (depth < m_config.behindDepth / 2) m_level = Level::Clear;
+            break;
+        case Level::Congested:
+            if (depth < m_config.behindDepth / 2) m_level = Level::Clear;
+            else if (depth < m_config.congestedDepth / 2) m_level = Level::Behind;
+            break;
+    }
+    return m_level;
+}
+
+std::size_t SubmitThrottle::updateAllowance() const {
+    switch (m_level) {
+        case Level::Clear: return SIZE_MAX;
+        case Level::Behind: return m_config.behindUpdates;
+        case Level::Congested: return 0;
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+// SyncScheduler.hpp
+// Carry-over queue of entity slots with changes not yet sent to the compositor.
+//
+// A slot is queued at most once however often it changes; the consumer reads
+// the entity's current state when the slot's turn comes, so the newest state
+// wins and intermediate ones are never replayed. Each frame the queue is
+// scored (distance to the viewer, a penalty outside the view cone, a bonus
+// that grows with time waited so far-away work can't starve) and handed out
+// best first, in chunks, until the caller's time budget runs out. What is
+// left stays queued for the next frame.
+//
+// SubmitThrottle reacts to the compositor's command backlog: while it is
+// behind, updates to nodes that already exist are rationed (creates are not);
+// while congested they stop entirely and simply wait in the queue, where
+// further changes coalesce into them.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MemoryBudget.hpp"
+
+class SyncScheduler {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Queue `slot` unless it already is. Keeps the oldest receive time of the
+	// changes it stands for (Clock::time_point{} = no network change).
+	void mark(std::uint32_t slot, Clock::time_point now, Clock::time_point rxTime = {});
+	// Forget `slot` (entity erased); its slot may be reused afterwards.
+	void drop(std::uint32_t slot);
+	bool queued(std::uint32_t slot) const { return slot < m_since.size() && m_since[slot] != Clock::time_point{}; }
+	std::size_t size() const { return m_count; }
+	bool empty() const { return m_count == 0; }
+
+	// Score every queued slot for this frame. positionOf(slot, out) sets the
+	// entity's position in the viewer's frame, or returns false to leave the
+	// slot queued without handing it out this frame.
+	template <typename PositionFn>
+	void beginFrame(Clock::time_point now, const glm::vec3& eye, const glm::vec3& forward, PositionFn&& positionOf) {
+		endFrame();
+		++m_frame;
+		if (m_stamp.size() < m_since.size()) m_stamp.resize(m_since.size(), 0);
+		m_candidates.clear();
+		std::size_t kept = 0;
+		for (std::uint32_t slot : m_queue) {
+			if (!queued(slot) || m_stamp[slot] == m_frame) continue;  // Dropped or listed twice
+			m_stamp[slot] = m_frame;
+			glm::vec3 position;
+			if (!positionOf(slot, position)) {
+				m_queue[kept++] = slot;
+				continue;
+			}
+			const glm::vec3 d = position - eye;
+			const float distance = glm::length(d);
+			const bool visible = glm::dot(d, forward) >= kViewCos * distance;
+			const float waited = std::chrono::duration<float>(now - m_since[slot]).count();
+			m_candidates.push_back({priority(distance, visible, waited), slot});
+		}
+		m_queue.resize(kept);
+		m_cursor = 0;
+	}
+
+	// Append up to `n` of the best slots not handed out yet this frame to
+	// `out` and unqueue them. Returns how many were appended (0: done).
+	std::size_t next(std::size_t n, std::vector<std::uint32_t>& out);
+	// Re-queue a slot handed out by next() this frame, keeping its wait time
+	// and receive time. It is not handed out again before the next frame.
+	void putBack(std::uint32_t slot);
+
+	// Slots not handed out go back to the queue (beginFrame does this too).
+	void endFrame();
+	// Release spare capacity of the queue and scratch (between frames).
+	void shrink();
+
+	// Oldest receive time recorded for `slot`, then clears it.
+	Clock::time_point takeRxTime(std::uint32_t slot);
+
+	// Lower goes first. Outside the view cone counts kHiddenWeight times
+	// farther; each second waited divides by (1 + kAgeBoost * seconds).
+	static float priority(float distance, bool visible, float waitedSeconds) {
+		return distance * (visible ? 1.0f : kHiddenWeight) / (1.0f + std::max(0.0f, waitedSeconds) * kAgeBoost);
+	}
+
+	static constexpr float kViewCos = 0.5f;      // 120 degree view cone
+	static constexpr float kHiddenWeight = 4.0f;
+	static constexpr float kAgeBoost = 4.0f;     // per second waited
+
+private:
+	struct Candidate {
+		float priority;
+		std::uint32_t slot;
+	};
+
+	template <typename T>
+	using Vec = TrackedVector<T, MemoryBudget::Subsystem::UpdateQueues>;
+
+	Vec<std::uint32_t> m_queue;           // queued, not scored this frame
+	Vec<Clock::time_point> m_since;       // per slot; {} = not queued
+	Vec<Clock::time_point> m_rx;          // per slot
+	Vec<std::uint32_t> m_stamp;           // per slot: last frame scored
+	Vec<Clock::time_point> m_takenSince;  // per slot: m_since when handed out
+	Vec<Candidate> m_candidates;          // this frame, [m_cursor, end) not handed out
+	std::size_t m_cursor{0};
+	std::size_t m_count{0};
+	std::uint32_t m_frame{0};
+};
+
+class SubmitThrottle {
+public:
+	enum class Level : std::uint8_t {
+		Clear,      // No limit
+		Behind,     // Updates of existing nodes rationed per frame
+		Congested   // Only creates and removals
+	};
+
+	struct Config {
+		std::uint64_t behindDepth{1024};     // Queued bridge commands
+		std::uint64_t congestedDepth{4096};
+		std::size_t behindUpdates{128};      // Existing-node updates per frame while Behind
+	};
+
+	SubmitThrottle() : SubmitThrottle(Config{}) {}
+	explicit SubmitThrottle(Config config) : m_config(config) {}
+
+	// Feed the bridge's queue depth once per frame. A level is left only once
+	// the depth has fallen below half its threshold, so it doesn't flap.
+	Level update(std::uint64_t depth);
+	Level level() const { return m_level; }
+
+	// Existing-node updates allowed this frame.
+	std::size_t updateAllowance() const;
+
+private:
+	Config m_config;
+	Level m_level{Level::Clear};
+};
@@ -0,0 +1,371 @@
+// TransformKernels.cpp
+#include "TransformKernels.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STARWORLD_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace TransformKernels {
+
+// glm's default layouts: vec3 = x,y,z; quat = x,y,z,w; mat4 = 4 columns of vec4.
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "unexpected glm::vec3 layout");
+static_assert(sizeof(glm::quat) == 4 * sizeof(float), "unexpected glm::quat layout");
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "unexpected glm::mat4 layout");
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Scalar reference (also handles the tails of the SIMD loops)
+// ---------------------------------------------------------------------------
+
+void composeScalar(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scl,
+                   glm::mat4* out, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        const glm::quat& q = rot[i];
+        const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+        const glm::vec3& s = scl[i];
+        glm::mat4& m = out[i];
+
+        m[0][0] = (1.0f - 2.0f * (yy + zz)) * s.x;
+        m[0][1] = (2.0f * (xy + wz)) * s.x;
+        m[0][2] = (2.0f * (xz - wy)) * s.x;
+        m[0][3] = 0.0f;
+
+        m[1][0] = (2.0f * (xy - wz)) * s.y;
+        m[1][1] = (1.0f - 2.0f * (xx + zz)) * s.y;
+        m[1][2] = (2.0f * (yz + wx)) * s.y;
+        m[1][3] = 0.0f;
+
+        m[2][0] = (2.0f * (xz + wy)) * s.z;
+        m[2][1] = (2.0f * (yz - wx)) * s.z;
+        m[2][2] = (1.0f - 2.0f * (xx + yy)) * s.z;
+        m[2][3] = 0.0f;
+
+        m[3][0] = pos[i].x;
+        m[3][1] = pos[i].y;
+        m[3][2] = pos[i].z;
+        m[3][3] = 1.0f;
+    }
+}
+
+void normalizeScalar(glm::quat* rot, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        glm::quat& q = rot[i];
+        const float len = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        if (len <= 0.0f) {
+            q = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        } else {
+            const float inv = 1.0f / len;
+            q.x *= inv; q.y *= inv; q.z *= inv; q.w *= inv;
+        }
+    }
+}
+
+#ifdef STARWORLD_X86_SIMD
+
+// ---------------------------------------------------------------------------
+// SSE2: 4 entities per iteration
+// ---------------------------------------------------------------------------
+
+inline void storeColumns4(glm::mat4* out, std::size_t i, int col,
+                          __m128 r0, __m128 r1, __m128 r2, __m128 r3) {
+    // r0..r3 hold rows 0..3 of column `col` for 4 entities; transpose so each
+    // register becomes one entity's column.
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(&out[i + 0][col][0], r0);
+    _mm_storeu_ps(&out[i + 1][col][0], r1);
+    _mm_storeu_ps(&out[i + 2][col][0], r2);
+    _mm_storeu_ps(&out[i + 3][col][0], r3);
+}
+
+void composeSSE2(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scl,
+                 glm::mat4* out, std::size_t count) {
+    const float* q = reinterpret_cast<const float*>(rot);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 qx = _mm_loadu_ps(q + (i + 0) * 4);
+        __m128 qy = _mm_loadu_ps(q + (i + 1) * 4);
+        __m128 qz = _mm_loadu_ps(q + (i + 2) * 4);
+        __m128 qw = _mm_loadu_ps(q + (i + 3) * 4);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+        const __m128 sx = _mm_setr_ps(scl[i].x, scl[i + 1].x, scl[i + 2].x, scl[i + 3].x);
+        const __m128 sy = _mm_setr_ps(scl[i].y, scl[i + 1].y, scl[i + 2].y, scl[i + 3].y);
+        const __m128 sz = _mm_setr_ps(scl[i].z, scl[i + 1].z, scl[i + 2].z, scl[i + 3].z);
+        const __m128 tx = _mm_setr_ps(pos[i].x, pos[i + 1].x, pos[i + 2].x, pos[i + 3].x);
+        const __m128 ty = _mm_setr_ps(pos[i].y, pos[i + 1].y, pos[i + 2].y, pos[i + 3].y);
+        const __m128 tz = _mm_setr_ps(pos[i].z, pos[i + 1].z, pos[i + 2].z, pos[i + 3].z);
+
+        const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        const __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+        const __m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        const __m128 m01 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        const __m128 m02 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+
+        const __m128 m10 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        const __m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        const __m128 m12 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+
+        const __m128 m20 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        const __m128 m21 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        const __m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+        storeColumns4(out, i, 0, m00, m01, m02, zero);
+        storeColumns4(out, i, 1, m10, m11, m12, zero);
+        storeColumns4(out, i, 2, m20, m21, m22, zero);
+        storeColumns4(out, i, 3, tx, ty, tz, one);
+    }
+    composeScalar(pos, rot, scl, out, i, count);
+}
+
+void normalizeSSE2(glm::quat* rot, std::size_t count) {
+    float* q = reinterpret_cast<float*>(rot);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 qx = _mm_loadu_ps(q + (i + 0) * 4);
+        __m128 qy = _mm_loadu_ps(q + (i + 1) * 4);
+        __m128 qz = _mm_loadu_ps(q + (i + 2) * 4);
+        __m128 qw = _mm_loadu_ps(q + (i + 3) * 4);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+        const __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+                                       _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+        const __m128 valid = _mm_cmpgt_ps(len2, zero);
+        // Full-precision divide keeps results bit-compatible with the scalar path.
+        const __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+
+        // Zero-length lanes become identity (0,0,0,1).
+        qx = _mm_and_ps(valid, _mm_mul_ps(qx, inv));
+        qy = _mm_and_ps(valid, _mm_mul_ps(qy, inv));
+        qz = _mm_and_ps(valid, _mm_mul_ps(qz, inv));
+        qw = _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(qw, inv)), _mm_andnot_ps(valid, one));
+
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+        _mm_storeu_ps(q + (i + 0) * 4, qx);
+        _mm_storeu_ps(q + (i + 1) * 4, qy);
+        _mm_storeu_ps(q + (i + 2) * 4, qz);
+        _mm_storeu_ps(q + (i + 3) * 4, qw);
+    }
+    normalizeScalar(rot, i, count);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2: 8 entities per iteration
+// ---------------------------------------------------------------------------
+
+// Transpose 8 packed quaternions (AoS) into x/y/z/w registers.
+__attribute__((target("avx2")))
+inline void loadQuats8(const float* q, __m256& qx, __m256& qy, __m256& qz, __m256& qw) {
+    const __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q + 0)), _mm_loadu_ps(q + 16), 1);
+    const __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q + 4)), _mm_loadu_ps(q + 20), 1);
+    const __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q + 8)), _mm_loadu_ps(q + 24), 1);
+    const __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q + 12)), _mm_loadu_ps(q + 28), 1);
+    const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    const __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    const __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    qx = _mm256_shuffle_ps(t0, t2, 0x44);
+    qy = _mm256_shuffle_ps(t0, t2, 0xEE);
+    qz = _mm256_shuffle_ps(t1, t3, 0x44);
+    qw = _mm256_shuffle_ps(t1, t3, 0xEE);
+}
+
+// Inverse of loadQuats8 for four row registers: writes 8 packed vec4s with a
+// stride of `stride` floats (4 for quats, 16 for mat4 columns).
+__attribute__((target("avx2")))
+inline void store8x4(float* dst, std::size_t stride,
+                     __m256 a, __m256 b, __m256 c, __m256 d) {
+    const __m256 t0 = _mm256_unpacklo_ps(a, b);
+    const __m256 t1 = _mm256_unpackhi_ps(a, b);
+    const __m256 t2 = _mm256_unpacklo_ps(c, d);
+    const __m256 t3 = _mm256_unpackhi_ps(c, d);
+    const __m256 o0 = _mm256_shuffle_ps(t0, t2, 0x44); // lanes 0 and 4
+    const __m256 o1 = _mm256_shuffle_ps(t0, t2, 0xEE); // lanes 1 and 5
+    const __m256 o2 = _mm256_shuffle_ps(t1, t3, 0x44); // lanes 2 and 6
+    const __m256 o3 = _mm256_shuffle_ps(t1, t3, 0xEE); // lanes 3 and 7
+    _mm_storeu_ps(dst + 0 * stride, _mm256_castps256_ps128(o0));
+    _mm_storeu_ps(dst + 1 * stride, _mm256_castps256_ps128(o1));
+    _mm_storeu_ps(dst + 2 * stride, _mm256_castps256_ps128(o2));
+    _mm_storeu_ps(dst + 3 * stride, _mm256_castps256_ps128(o3));
+    _mm_storeu_ps(dst + 4 * stride, _mm256_extractf128_ps(o0, 1));
+    _mm_storeu_ps(dst + 5 * stride, _mm256_extractf128_ps(o1, 1));
+    _mm_storeu_ps(dst + 6 * stride, _mm256_extractf128_ps(o2, 1));
+    _mm_storeu_ps(dst + 7 * stride, _mm256_extractf128_ps(o3, 1));
+}
+
+__attribute__((target("avx2")))
+void composeAVX2(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scl,
+                 glm::mat4* out, std::size_t count) {
+    const float* q = reinterpret_cast<const float*>(rot);
+    const float* p = reinterpret_cast<const float*>(pos);
+    const float* s = reinterpret_cast<const float*>(scl);
+    float* o = reinterpret_cast<float*>(out);
+    // vec3 arrays are gathered with a stride of 3 floats so we never read
+    // past the last element.
+    const __m256i vec3Index = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 qx, qy, qz, qw;
+        loadQuats8(q + i * 4, qx, qy, qz, qw);
+
+        const float* pi = p + i * 3;
+        const float* si = s + i * 3;
+        const __m256 tx = _mm256_i32gather_ps(pi + 0, vec3Index, 4);
+        const __m256 ty = _mm256_i32gather_ps(pi + 1, vec3Index, 4);
+        const __m256 tz = _mm256_i32gather_ps(pi + 2, vec3Index, 4);
+        const __m256 sx = _mm256_i32gather_ps(si + 0, vec3Index, 4);
+        const __m256 sy = _mm256_i32gather_ps(si + 1, vec3Index, 4);
+        const __m256 sz = _mm256_i32gather_ps(si + 2, vec3Index, 4);
+
+        const __m256 xx = _mm256_mul_ps(qx, qx), yy = _mm256_mul_ps(qy, qy), zz = _mm256_mul_ps(qz, qz);
+        const __m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+        const __m256 wx = _mm256_mul_ps(qw, qx), wy = _mm256_mul_ps(qw, qy), wz = _mm256_mul_ps(qw, qz);
+
+        // Same operation order as the scalar path (no FMA contraction) so
+        // every level produces identical matrices.
+        const __m256 m00 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+        const __m256 m01 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+        const __m256 m02 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+
+        const __m256 m10 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+        const __m256 m11 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+        const __m256 m12 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+
+        const __m256 m20 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+        const __m256 m21 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+        const __m256 m22 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+
+        float* base = o + i * 16;
+        store8x4(base + 0, 16, m00, m01, m02, zero);
+        store8x4(base + 4, 16, m10, m11, m12, zero);
+        store8x4(base + 8, 16, m20, m21, m22, zero);
+        store8x4(base + 12, 16, tx, ty, tz, one);
+    }
+    // Remaining 0-7 entities: one SSE2 block if possible, then scalar.
+    if (i < count) {
+        composeSSE2(pos + i, rot + i, scl + i, out + i, count - i);
+    }
+}
+
+__attribute__((target("avx2")))
+void normalizeAVX2(glm::quat* rot, std::size_t count) {
+    float* q = reinterpret_cast<float*>(rot);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 qx, qy, qz, qw;
+        loadQuats8(q + i * 4, qx, qy, qz, qw);
+
+        const __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy)),
+                                          _mm256_add_ps(_mm256_mul_ps(qz, qz), _mm256_mul_ps(qw, qw)));
+        const __m256 valid = _mm256_cmp_ps(len2, zero, _CMP_GT_OQ);
+        const __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+
+        qx = _mm256_and_ps(valid, _mm256_mul_ps(qx, inv));
+        qy = _mm256_and_ps(valid, _mm256_mul_ps(qy, inv));
+        qz = _mm256_and_ps(valid, _mm256_mul_ps(qz, inv));
+        qw = _mm256_blendv_ps(one, _mm256_mul_ps(qw, inv), valid);
+
+        store8x4(q + i * 4, 4, qx, qy, qz, qw);
+    }
+    if (i < count) {
+        normalizeSSE2(rot + i, count - i);
+    }
+}
+
+#endif // STARWORLD_X86_SIMD
+
+SimdLevel hardwareLevel() {
+    static const SimdLevel level = [] {
+#ifdef STARWORLD_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        return SimdLevel::SSE2;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }();
+    return level;
+}
+
+SimdLevel clampToSupported(SimdLevel level) {
+    const SimdLevel hw = hardwareLevel();
+    return static_cast<int>(level) > static_cast<int>(hw) ? hw : level;
+}
+
+} // anonymous namespace
+
+SimdLevel detectSimdLevel() {
+    static const SimdLevel level = [] {
+        SimdLevel detected = hardwareLevel();
+        if (const char* env = std::getenv("STARWORLD_SIMD")) {
+            std::string v(env);
+            if (v == "scalar") detected = SimdLevel::Scalar;
+            else if (v == "sse2") detected = clampToSupported(SimdLevel::SSE2);
+            else if (v == "avx2") detected = clampToSupported(SimdLevel::AVX2);
+        }
+        return detected;
+    }();
+    return level;
+}
+
+bool isSupported(SimdLevel level) {
+    return clampToSupported(level) == level;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        case SimdLevel::Scalar: break;
+    }
+    return "scalar";
+}
+
+void composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                glm::mat4* out, std::size_t count, SimdLevel level) {
+    if (count == 0) return;
+    switch (clampToSupported(level)) {
+#ifdef STARWORLD_X86_SIMD
+        case SimdLevel::AVX2: composeAVX2(positions, rotations, scales, out, count); return;
+        case SimdLevel::SSE2: composeSSE2(positions, rotations, scales, out, count); return;
+#endif
+        default: composeScalar(positions, rotations, scales, out, 0, count); return;
+    }
+}
+
+void normalizeQuats(glm::quat* rotations, std::size_t count, SimdLevel level) {
+    if (count == 0) return;
+    switch (clampToSupported(level)) {
+#ifdef STARWORLD_X86_SIMD
+        case SimdLevel::AVX2: normalizeAVX2(rotations, count); return;
+        case SimdLevel::SSE2: normalizeSSE2(rotations, count); return;
+#endif
+        default: normalizeScalar(rotations, 0, count); return;
+    }
+}
+
+} // namespace TransformKernels
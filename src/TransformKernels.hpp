@@ -0,0 +1,43 @@
+// TransformKernels.hpp
+// Batch kernels for entity transform math (TRS -> mat4, quaternion normalize).
+// Operate on contiguous arrays so initial loads and mass edits can rebuild
+// thousands of transforms per call. x86 builds dispatch at runtime between
+// AVX2 (8 per iteration), SSE2 (4 per iteration) and a scalar fallback.
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace TransformKernels {
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Highest level supported by this CPU. Cached after the first call.
+// STARWORLD_SIMD=scalar|sse2|avx2 can lower it for debugging/benchmarking.
+SimdLevel detectSimdLevel();
+bool isSupported(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
+
+// out[i] = translate(positions[i]) * mat4_cast(rotations[i]) * scale(scales[i])
+// Rotations are expected to be normalized (see normalizeQuats).
+// Levels the CPU does not support fall back to the best supported one.
+void composeTRS(const glm::vec3* positions,
+                const glm::quat* rotations,
+                const glm::vec3* scales,
+                glm::mat4* out,
+                std::size_t count,
+                SimdLevel level = detectSimdLevel());
+
+// Normalize rotations in place. Zero-length quaternions become identity,
+// matching glm::normalize.
+void normalizeQuats(glm::quat* rotations,
+                    std::size_t count,
+                    SimdLevel level = detectSimdLevel());
+
+} // namespace TransformKernels
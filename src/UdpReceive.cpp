@@ -0,0 +1,70 @@
+// UdpReceive.cpp
+#include "UdpReceive.hpp"
+
+#include <cstring>
+
+namespace UdpReceive {
+
+bool enableTimestamps(int fd) {
+    int on = 1;
+    return ::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+}
+
+bool enableDropCounter(int fd) {
+#ifdef SO_RXQ_OVFL
+    int on = 1;
+    return ::setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) == 0;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+std::chrono::steady_clock::time_point fromRealtime(const timespec& ts) {
+    timespec now{};
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    const auto steadyNow = std::chrono::steady_clock::now();
+    const auto age = std::chrono::seconds(now.tv_sec - ts.tv_sec) + std::chrono::nanoseconds(now.tv_nsec - ts.tv_nsec);
+    // A timestamp "from the future" means the wall clock stepped; don't go negative.
+    return age.count() > 0 ? steadyNow - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age) : steadyNow;
+}
+
+void readControl(msghdr& msg, Meta& meta) {
+    meta.kernelTimestamp = false;
+    meta.hasDropCount = false;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            meta.rxTime = fromRealtime(ts);
+            meta.kernelTimestamp = true;
+        }
+#ifdef SO_RXQ_OVFL
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+            std::memcpy(&meta.dropCount, CMSG_DATA(c), sizeof(meta.dropCount));
+            meta.hasDropCount = true;
+        }
+#endif
+    }
+    if (!meta.kernelTimestamp) meta.rxTime = std::chrono::steady_clock::now();
+}
+
+ssize_t receive(int fd, char* buf, std::size_t cap, sockaddr_storage* from, Meta& meta) {
+    iovec iov{buf, cap};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(std::uint32_t))];
+    msghdr msg{};
+    msg.msg_name = from;
+    msg.msg_namelen = from ? sizeof(sockaddr_storage) : 0;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    const ssize_t r = ::recvmsg(fd, &msg, 0);
+    if (r < 0) return r;
+
+    readControl(msg, meta);
+    return r;
+}
+
+} // namespace UdpReceive
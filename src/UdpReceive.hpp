@@ -0,0 +1,45 @@
+// UdpReceive.hpp
+// recvmsg() wrapper that also returns the kernel receive timestamp of each
+// datagram (SO_TIMESTAMPNS), mapped onto std::chrono::steady_clock so it can
+// be compared with timestamps taken anywhere else in the client, and the
+// socket's receive-queue overflow counter (SO_RXQ_OVFL).
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+
+namespace UdpReceive {
+
+struct Meta {
+	// When the datagram hit the socket: the kernel timestamp if available,
+	// otherwise the time receive() returned.
+	std::chrono::steady_clock::time_point rxTime{};
+	bool kernelTimestamp{false};
+	// SO_RXQ_OVFL: datagrams the socket had dropped (buffer full) when this
+	// one was queued. The kernel only reports it once it is non-zero.
+	bool hasDropCount{false};
+	std::uint32_t dropCount{0};
+};
+
+// Ask the kernel to timestamp incoming datagrams. Returns false if unsupported.
+bool enableTimestamps(int fd);
+
+// Report receive-queue overflows with each datagram. Returns false if unsupported.
+bool enableDropCounter(int fd);
+
+// One recvmsg(). Returns bytes received, or -1 with errno set.
+ssize_t receive(int fd, char* buf, std::size_t cap, sockaddr_storage* from, Meta& meta);
+
+// Fill `meta` from the control messages of a received `msg` (timestamp and
+// drop counter); falls back to now() when there is no kernel timestamp.
+void readControl(msghdr& msg, Meta& meta);
+
+// Map a CLOCK_REALTIME timestamp onto steady_clock (via the current offset).
+std::chrono::steady_clock::time_point fromRealtime(const timespec& ts);
+
+} // namespace UdpReceive
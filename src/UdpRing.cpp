@@ -0,0 +1,340 @@
+// UdpRing.cpp
+#include "UdpRing.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if HAVE_IO_URING
+
+#include <algorithm>
+#include <atomic>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr unsigned kSqEntries = 64;
+constexpr unsigned kCqEntries = 4096;
+constexpr unsigned kRecvBuffers = 512;           // Power of two (buffer ring size)
+constexpr std::size_t kRecvBufferSize = 2048;    // recvmsg_out + address + cmsgs + MTU payload
+constexpr unsigned kSendSlots = 64;
+constexpr std::size_t kSendSlotSize = 1500;
+constexpr std::uint16_t kBufferGroup = 0;
+constexpr std::uint64_t kRecvTag = ~0ull;        // user_data of the multishot recvmsg
+constexpr std::size_t kControlSpace = CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(std::uint32_t));
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int ringFd, unsigned op, void* arg, unsigned count) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, ringFd, op, arg, count));
+}
+
+template <typename T>
+T loadAcquire(T* p) {
+    return std::atomic_ref<T>(*p).load(std::memory_order_acquire);
+}
+
+template <typename T>
+void storeRelease(T* p, T v) {
+    std::atomic_ref<T>(*p).store(v, std::memory_order_release);
+}
+
+} // anonymous namespace
+
+// Mapped submission/completion rings (IORING_FEAT_SINGLE_MMAP: one mapping)
+struct UdpRing::Rings {
+    int ringFd{-1};
+    void* ringMap{MAP_FAILED};
+    std::size_t ringBytes{0};
+    io_uring_sqe* sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+    std::size_t sqesBytes{0};
+
+    unsigned* sqHead{nullptr};
+    unsigned* sqTail{nullptr};
+    unsigned sqMask{0};
+    unsigned sqEntries{0};
+    unsigned* sqFlags{nullptr};
+    unsigned* sqArray{nullptr};
+
+    unsigned* cqHead{nullptr};
+    unsigned* cqTail{nullptr};
+    unsigned cqMask{0};
+    io_uring_cqe* cqes{nullptr};
+
+    ~Rings() {
+        if (sqes != MAP_FAILED) ::munmap(sqes, sqesBytes);
+        if (ringMap != MAP_FAILED) ::munmap(ringMap, ringBytes);
+        if (ringFd >= 0) ::close(ringFd);
+    }
+
+    // Next free SQE (zeroed), or nullptr if the queue is full.
+    io_uring_sqe* acquire() {
+        const unsigned tail = *sqTail;
+        if (tail - loadAcquire(sqHead) >= sqEntries) return nullptr;
+        io_uring_sqe* sqe = &sqes[tail & sqMask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Publish the SQE returned by acquire().
+    void commit() {
+        const unsigned tail = *sqTail;
+        sqArray[tail & sqMask] = tail & sqMask;
+        storeRelease(sqTail, tail + 1);
+    }
+};
+
+bool UdpRing::enabled() {
+    const char* env = std::getenv("STARWORLD_IO_URING");
+    return !env || std::string(env) != "0";
+}
+
+std::unique_ptr<UdpRing> UdpRing::create(int fd) {
+    std::unique_ptr<UdpRing> ring(new UdpRing());
+    if (!ring->init(fd)) return nullptr;
+    return ring;
+}
+
+UdpRing::~UdpRing() {
+    // Closing the ring cancels the multishot receive and in-flight sends
+    m_rings.reset();
+    if (m_bufRing) ::munmap(m_bufRing, m_bufRingBytes);
+}
+
+bool UdpRing::init(int fd) {
+    m_fd = fd;
+    m_rings = std::make_unique<Rings>();
+    Rings& r = *m_rings;
+
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = kCqEntries;
+    r.ringFd = ioUringSetup(kSqEntries, &params);
+    if (r.ringFd < 0) return false;
+    // Older kernels need separate ring mappings or can drop completions
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) return false;
+
+    r.ringBytes = std::max<std::size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    r.ringMap = ::mmap(nullptr, r.ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r.ringFd, IORING_OFF_SQ_RING);
+    if (r.ringMap == MAP_FAILED) return false;
+    r.sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    r.sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, r.sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                               r.ringFd, IORING_OFF_SQES));
+    if (r.sqes == MAP_FAILED) return false;
+
+    char* base = static_cast<char*>(r.ringMap);
+    r.sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    r.sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    r.sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    r.sqEntries = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_entries);
+    r.sqFlags = reinterpret_cast<unsigned*>(base + params.sq_off.flags);
+    r.sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    r.cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    r.cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    r.cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    r.cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+    // Which opcodes does this kernel have?
+    std::vector<char> probeBytes(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeBytes.data());
+    if (ioUringRegister(r.ringFd, IORING_REGISTER_PROBE, probe, 256) < 0) return false;
+    auto supported = [&](unsigned op) {
+        return op <= probe->last_op && op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    };
+    if (!supported(IORING_OP_RECVMSG)) return false;
+
+    // Provided-buffer ring: the kernel picks a receive buffer per datagram
+    m_bufRingBytes = kRecvBuffers * sizeof(io_uring_buf);
+    m_bufRing = ::mmap(nullptr, m_bufRingBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m_bufRing == MAP_FAILED) {
+        m_bufRing = nullptr;
+        return false;
+    }
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<std::uint64_t>(m_bufRing);
+    reg.ring_entries = kRecvBuffers;
+    reg.bgid = kBufferGroup;
+    if (ioUringRegister(r.ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return false;
+    m_recvBuffers.resize(kRecvBuffers * kRecvBufferSize);
+    for (unsigned i = 0; i < kRecvBuffers; ++i) recycle(static_cast<std::uint16_t>(i));
+
+    // Registered send buffers (zero-copy send needs 6.0+; otherwise sendto)
+    m_sendBuffers.resize(kSendSlots * kSendSlotSize);
+    m_sendTo.resize(kSendSlots);
+    std::vector<iovec> iovs(kSendSlots);
+    for (unsigned i = 0; i < kSendSlots; ++i) {
+        iovs[i] = iovec{m_sendBuffers.data() + i * kSendSlotSize, kSendSlotSize};
+        m_freeSlots.push_back(static_cast<std::uint16_t>(kSendSlots - 1 - i));
+    }
+    m_sendZc = supported(IORING_OP_SEND_ZC) &&
+               ioUringRegister(r.ringFd, IORING_REGISTER_BUFFERS, iovs.data(), kSendSlots) == 0;
+
+    m_recvMsg.msg_namelen = sizeof(sockaddr_storage);
+    m_recvMsg.msg_controllen = kControlSpace;
+    return armReceive();
+}
+
+void UdpRing::recycle(std::uint16_t bid) {
+    auto* bufs = static_cast<io_uring_buf*>(m_bufRing);
+    io_uring_buf& b = bufs[m_bufTail & (kRecvBuffers - 1)];
+    b.addr = reinterpret_cast<std::uint64_t>(m_recvBuffers.data() + bid * kRecvBufferSize);
+    b.len = kRecvBufferSize;
+    b.bid = bid;
+    // The ring tail overlays bufs[0].resv
+    storeRelease(&bufs[0].resv, ++m_bufTail);
+}
+
+bool UdpRing::armReceive() {
+    io_uring_sqe* sqe = m_rings->acquire();
+    if (!sqe) {
+        flush();
+        sqe = m_rings->acquire();
+        if (!sqe) return false;
+    }
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = m_fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&m_recvMsg);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = kRecvTag;
+    m_rings->commit();
+    ++m_queued;
+    m_armed = true;
+    flush();
+    return true;
+}
+
+void UdpRing::flush() {
+    if (m_queued == 0 || !m_rings) return;
+    const int n = ioUringEnter(m_rings->ringFd, m_queued, 0, 0);
+    if (n > 0) m_queued -= std::min<unsigned>(m_queued, static_cast<unsigned>(n));
+}
+
+void UdpRing::sendCompleted(std::uint64_t slot, std::uint32_t flags, std::int32_t res) {
+    // A zero-copy send posts its result, then a notification once the
+    // buffer is no longer referenced; the last CQE lacks F_MORE. Only the
+    // result carries an error.
+    if (!(flags & IORING_CQE_F_NOTIF) && res < 0) {
+        ++m_sendFailures;
+        m_lastSendError = -res;
+    }
+    if (!(flags & IORING_CQE_F_MORE) && slot < m_sendTo.size()) m_freeSlots.push_back(static_cast<std::uint16_t>(slot));
+}
+
+ssize_t UdpRing::receive(char* buf, std::size_t cap, sockaddr_storage* from, UdpReceive::Meta& meta) {
+    Rings& r = *m_rings;
+    while (!m_failed) {
+        const unsigned head = *r.cqHead;
+        if (head == loadAcquire(r.cqTail)) {
+            // Completions the CQ had no room for are flushed by entering the kernel
+            if (loadAcquire(r.sqFlags) & IORING_SQ_CQ_OVERFLOW) {
+                ioUringEnter(r.ringFd, 0, 0, IORING_ENTER_GETEVENTS);
+                if (head != loadAcquire(r.cqTail)) continue;
+            }
+            if (!m_armed) armReceive();
+            break;
+        }
+        const io_uring_cqe cqe = r.cqes[head & r.cqMask];
+        storeRelease(r.cqHead, head + 1);
+
+        if (cqe.user_data != kRecvTag) {
+            sendCompleted(cqe.user_data, cqe.flags, cqe.res);
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) m_armed = false;
+        if (cqe.res < 0) {
+            // Out of buffers (re-armed once the CQ is drained) or a socket
+            // error; anything else means multishot recvmsg is unsupported.
+            if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP || cqe.res == -EBADF) m_failed = true;
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_BUFFER)) continue;
+
+        const auto bid = static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        char* b = m_recvBuffers.data() + bid * kRecvBufferSize;
+        io_uring_recvmsg_out out;
+        std::memcpy(&out, b, sizeof(out));
+        char* name = b + sizeof(io_uring_recvmsg_out);
+        char* control = name + m_recvMsg.msg_namelen;
+        const char* payload = control + m_recvMsg.msg_controllen;
+
+        if (from) {
+            *from = sockaddr_storage{};
+            std::memcpy(from, name, std::min<std::size_t>(out.namelen, sizeof(sockaddr_storage)));
+        }
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = out.controllen;
+        UdpReceive::readControl(msg, meta);
+
+        const std::size_t n = std::min<std::size_t>(out.payloadlen, cap);
+        std::memcpy(buf, payload, n);
+        recycle(bid);
+        return static_cast<ssize_t>(n);
+    }
+    errno = EAGAIN;
+    return -1;
+}
+
+bool UdpRing::send(const void* data, std::size_t len, const sockaddr_storage& to, socklen_t toLen) {
+    if (!m_sendZc || m_failed || len > kSendSlotSize || m_freeSlots.empty()) return false;
+    io_uring_sqe* sqe = m_rings->acquire();
+    if (!sqe) {
+        flush();
+        sqe = m_rings->acquire();
+        if (!sqe) return false;
+    }
+    const std::uint16_t slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    char* dst = m_sendBuffers.data() + slot * kSendSlotSize;
+    std::memcpy(dst, data, len);
+    m_sendTo[slot] = to;
+
+    sqe->opcode = IORING_OP_SEND_ZC;
+    sqe->fd = m_fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(dst);
+    sqe->len = static_cast<std::uint32_t>(len);
+    sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+    sqe->buf_index = slot;
+    sqe->addr2 = reinterpret_cast<std::uint64_t>(&m_sendTo[slot]);
+    sqe->addr_len = static_cast<std::uint16_t>(toLen);
+    sqe->user_data = slot;
+    m_rings->commit();
+    ++m_queued;
+    return true;
+}
+
+#else // !HAVE_IO_URING
+
+struct UdpRing::Rings {};
+
+bool UdpRing::enabled() { return false; }
+std::unique_ptr<UdpRing> UdpRing::create(int) { return nullptr; }
+UdpRing::~UdpRing() = default;
+bool UdpRing::init(int) { return false; }
+bool UdpRing::armReceive() { return false; }
+void UdpRing::recycle(std::uint16_t) {}
+void UdpRing::flush() {}
+void UdpRing::sendCompleted(std::uint64_t, std::uint32_t, std::int32_t) {}
+ssize_t UdpRing::receive(char*, std::size_t, sockaddr_storage*, UdpReceive::Meta&) {
+    errno = EAGAIN;
+    return -1;
+}
+bool UdpRing::send(const void*, std::size_t, const sockaddr_storage&, socklen_t) { return false; }
+
+#endif // HAVE_IO_URING
@@ -0,0 +1,88 @@
+// UdpRing.hpp
+// io_uring receive/send backend for one UDP socket (Linux, optional).
+//
+// Receiving uses a single multishot recvmsg over a provided-buffer ring: the
+// kernel picks a buffer per datagram and posts a completion, and receive()
+// only reads the mmapped completion queue and hands the buffer back. No
+// syscall per packet; one is made only to re-arm the request when the kernel
+// ends it (e.g. it ran out of buffers during a flood). Sends are copied into
+// registered buffers and issued as zero-copy sends; flush() submits all that
+// were queued with one syscall.
+//
+// create() returns nullptr when the build or the kernel lacks what is needed
+// (or STARWORLD_IO_URING=0); callers then keep using UdpReceive/sendto.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include "UdpReceive.hpp"
+
+class UdpRing {
+public:
+	// `fd` must stay open for the ring's lifetime. Timestamp and drop-counter
+	// options already enabled on it are reported through receive() as well.
+	static std::unique_ptr<UdpRing> create(int fd);
+	~UdpRing();
+
+	UdpRing(const UdpRing&) = delete;
+	UdpRing& operator=(const UdpRing&) = delete;
+
+	// Same contract as UdpReceive::receive(): bytes copied into `buf`, or -1
+	// with errno EAGAIN when nothing is ready. After failed() turns true it
+	// always returns -1; the caller should drop the ring and fall back.
+	ssize_t receive(char* buf, std::size_t cap, sockaddr_storage* from, UdpReceive::Meta& meta);
+
+	// Queue a datagram. Returns false if it can't go through the ring (no
+	// zero-copy send support, all send buffers in flight, too large); the
+	// caller sends it directly instead. True only means queued: the send's
+	// result arrives later as a completion, and failed ones are counted in
+	// sendFailures().
+	bool send(const void* data, std::size_t len, const sockaddr_storage& to, socklen_t toLen);
+	// Submit everything queued since the last flush.
+	void flush();
+
+	bool failed() const { return m_failed; }
+	bool canSend() const { return m_sendZc; }
+	// Queued sends whose completion reported an error, and the last errno
+	std::uint64_t sendFailures() const { return m_sendFailures; }
+	int lastSendError() const { return m_lastSendError; }
+
+	// Runtime switch: STARWORLD_IO_URING=0 disables the backend.
+	static bool enabled();
+
+private:
+	UdpRing() = default;
+	bool init(int fd);
+	bool armReceive();
+	void recycle(std::uint16_t bid);
+	void sendCompleted(std::uint64_t slot, std::uint32_t flags, std::int32_t res);
+
+	struct Rings;
+	std::unique_ptr<Rings> m_rings;
+	int m_fd{-1};
+	bool m_failed{false};
+	bool m_armed{false};
+	bool m_sendZc{false};
+
+	// Provided receive buffers
+	void* m_bufRing{nullptr};
+	std::size_t m_bufRingBytes{0};
+	std::vector<char> m_recvBuffers;
+	std::uint16_t m_bufTail{0};
+
+	// Registered send buffers and their destinations
+	std::vector<char> m_sendBuffers;
+	std::vector<sockaddr_storage> m_sendTo;
+	std::vector<std::uint16_t> m_freeSlots;
+	unsigned m_queued{0};  // SQEs not yet submitted
+	std::uint64_t m_sendFailures{0};
+	int m_lastSendError{0};
+
+	msghdr m_recvMsg{};  // Template for the multishot recvmsg
+};
@@ -0,0 +1,130 @@
+// UdtConnection.cpp
+#include "UdtConnection.hpp"
+
+#include <algorithm>
+
+namespace {
+
+constexpr std::uint32_t kControlBit = 0x80000000;
+
+void putU32(std::uint8_t* out, std::uint32_t value) {
+    out[0] = static_cast<std::uint8_t>(value >> 24);
+    out[1] = static_cast<std::uint8_t>(value >> 16);
+    out[2] = static_cast<std::uint8_t>(value >> 8);
+    out[3] = static_cast<std::uint8_t>(value);
+}
+
+std::uint32_t getU32(const std::uint8_t* p) {
+    return static_cast<std::uint32_t>(p[0]) << 24 | static_cast<std::uint32_t>(p[1]) << 16 |
+           static_cast<std::uint32_t>(p[2]) << 8 | p[3];
+}
+
+} // namespace
+
+std::size_t UdtConnection::write(const Control& control, std::uint8_t* out) {
+    putU32(out, kControlBit | static_cast<std::uint32_t>(control.type) << 16);
+    if (control.type == ControlType::HandshakeRequest) return 4;
+    putU32(out + 4, control.value & kSequenceMask);
+    return 8;
+}
+
+bool UdtConnection::parse(const std::uint8_t* data, std::size_t len, Control& control) {
+    if (len < 4) return false;
+    const std::uint32_t first = getU32(data);
+    if ((first & kControlBit) == 0) return false;
+    const auto type = static_cast<std::uint16_t>((first >> 16) & 0x7FFF);
+    if (type > static_cast<std::uint16_t>(ControlType::HandshakeRequest)) return false;
+    control.type = static_cast<ControlType>(type);
+    control.value = 0;
+    if (control.type == ControlType::HandshakeRequest) return true;
+    if (len < 8) return false;
+    control.value = getU32(data + 4) & kSequenceMask;
+    return true;
+}
+
+UdtConnection::UdtConnection(std::uint32_t initialSequence)
+    : m_initial(initialSequence & kSequenceMask),
+      m_next(m_initial),
+      m_lastAcked((m_initial - 1) & kSequenceMask),
+      m_seen(kReceiveWindow / 64) {}
+
+bool UdtConnection::handshakeDue(Clock::time_point now) {
+    if (m_handshakeAcked) return false;
+    if (m_lastHandshake != Clock::time_point{} && now - m_lastHandshake < kHandshakeInterval) return false;
+    m_lastHandshake = now;
+    return true;
+}
+
+std::uint32_t UdtConnection::nextSequence() {
+    const std::uint32_t sequence = m_next;
+    m_next = (m_next + 1) & kSequenceMask;
+    return sequence;
+}
+
+UdtConnection::Receive UdtConnection::receive(std::uint32_t sequence) {
+    if (!m_peerHandshake) return Receive::NoHandshake;
+    sequence &= kSequenceMask;
+    // Distance past the next expected number; the upper half of the
+    // sequence space is behind it
+    const std::uint32_t ahead = (sequence - m_lastReceived - 1) & kSequenceMask;
+    if (ahead > kSequenceMask / 2) return Receive::Duplicate;
+    if (ahead >= kReceiveWindow) return Receive::New;
+    if (seen(sequence)) return Receive::Duplicate;
+    setSeen(sequence, true);
+    // Close the gap up to the first number still missing
+    std::uint32_t next = (m_lastReceived + 1) & kSequenceMask;
+    while (seen(next)) {
+        setSeen(next, false);
+        m_lastReceived = next;
+        next = (next + 1) & kSequenceMask;
+    }
+    return Receive::New;
+}
+
+std::optional<UdtConnection::Control> UdtConnection::handle(const Control& control) {
+    switch (control.type) {
+        case ControlType::ACK:
+            m_lastAcked = control.value & kSequenceMask;
+            return std::nullopt;
+
+        case ControlType::Handshake:
+            // A new initial number is a new connection from the peer (it
+            // restarted); a resent one keeps what we have received
+            if (!m_peerHandshake || control.value != m_peerInitial) {
+                m_peerHandshake = true;
+                m_peerInitial = control.value & kSequenceMask;
+                m_lastReceived = (m_peerInitial - 1) & kSequenceMask;
+                std::fill(m_seen.begin(), m_seen.end(), 0);
+            }
+            return Control{ControlType::HandshakeACK, m_peerInitial};
+
+        case ControlType::HandshakeACK:
+            if ((control.value & kSequenceMask) == m_initial) m_handshakeAcked = true;
+            return std::nullopt;
+
+        case ControlType::HandshakeRequest:
+            // The peer lost our connection: announce a new one that starts
+            // where our numbering is, and handshake again right away
+            m_initial = m_next;
+            m_lastAcked = (m_initial - 1) & kSequenceMask;
+            m_handshakeAcked = false;
+            m_lastHandshake = {};
+            return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+bool UdtConnection::seen(std::uint32_t sequence) const {
+    const std::uint32_t bit = sequence % kReceiveWindow;
+    return (m_seen[bit / 64] >> (bit % 64)) & 1;
+}
+
+void UdtConnection::setSeen(std::uint32_t sequence, bool value) {
+    const std::uint32_t bit = sequence % kReceiveWindow;
+    const std::uint64_t mask = std::uint64_t{1} << (bit % 64);
+    if (value) {
+        m_seen[bit / 64] |= mask;
+    } else {
+        m_seen[bit / 64] &= ~mask;
+    }
+}
@@ -0,0 +1,98 @@
+// UdtConnection.hpp
+// Per-peer sequence space and handshake of Overte's reliable transport
+// (udt::Connection), for the peers we exchange reliable packets with.
+//
+// Reliable packets are numbered per connection, not from one counter for the
+// whole socket. Before its first one the sender sends Handshake(initial)
+// every 100 ms until the peer answers HandshakeACK(initial); its packets
+// then count up from `initial`. The receiver answers a Handshake with
+// HandshakeACK, asks for one (HandshakeRequest) when a reliable packet comes
+// without it, and ACKs the last sequence number received without a gap.
+//
+// One instance holds both directions with one peer. It only keeps state and
+// builds control packets; the owner sends them.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+class UdtConnection {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class ControlType : std::uint16_t {
+		ACK = 0,
+		Handshake = 1,
+		HandshakeACK = 2,
+		HandshakeRequest = 3
+	};
+
+	struct Control {
+		ControlType type{ControlType::ACK};
+		std::uint32_t value{0};  // Sequence number; unused by HandshakeRequest
+	};
+
+	static constexpr std::uint32_t kSequenceMask = 0x07FFFFFF;  // 27 bits
+	static constexpr std::size_t kMaxControlSize = 8;
+	static constexpr Clock::duration kHandshakeInterval = std::chrono::milliseconds(100);
+	// Sequence numbers ahead of the last in-order one that are remembered;
+	// packets further ahead are delivered but not tracked
+	static constexpr std::uint32_t kReceiveWindow = 8192;
+
+	// [u32: control bit | type << 16][u32 value], header big-endian like
+	// NLPacket's. Returns the bytes written (at most kMaxControlSize).
+	static std::size_t write(const Control& control, std::uint8_t* out);
+	// False if `data` is not a control packet of a known type.
+	static bool parse(const std::uint8_t* data, std::size_t len, Control& control);
+
+	// `initialSequence` should be random, so a peer can tell a new
+	// connection from a resent handshake.
+	explicit UdtConnection(std::uint32_t initialSequence);
+
+	// --- Our reliable packets
+
+	// The peer acknowledged our handshake; numbered packets may go out.
+	bool established() const { return m_handshakeAcked; }
+	// True when a Handshake should be sent now (not yet acknowledged, none
+	// sent within kHandshakeInterval); marks it sent.
+	bool handshakeDue(Clock::time_point now);
+	Control handshake() const { return {ControlType::Handshake, m_initial}; }
+	// Sequence number for the next reliable packet
+	std::uint32_t nextSequence();
+	// Highest sequence number the peer has acknowledged
+	std::uint32_t lastAcked() const { return m_lastAcked; }
+
+	// --- The peer's reliable packets
+
+	enum class Receive : std::uint8_t {
+		New,
+		Duplicate,
+		NoHandshake  // Before the peer's Handshake: reply HandshakeRequest, don't ACK
+	};
+	Receive receive(std::uint32_t sequence);
+	// ACK for everything received so far
+	Control ack() const { return {ControlType::ACK, m_lastReceived}; }
+
+	// A control packet from the peer; returns the reply to send, if any.
+	std::optional<Control> handle(const Control& control);
+
+private:
+	bool seen(std::uint32_t sequence) const;
+	void setSeen(std::uint32_t sequence, bool value);
+
+	// Send side
+	std::uint32_t m_initial;
+	std::uint32_t m_next;
+	std::uint32_t m_lastAcked;
+	bool m_handshakeAcked{false};
+	Clock::time_point m_lastHandshake{};
+
+	// Receive side
+	bool m_peerHandshake{false};
+	std::uint32_t m_peerInitial{0};
+	std::uint32_t m_lastReceived{0};
+	std::vector<std::uint64_t> m_seen;  // Bit per sequence number, ring of kReceiveWindow
+};
@@ -0,0 +1,368 @@
+// WireSchema.hpp
+// Compile-time descriptions of packet layouts.
+//
+// A packet (or a section of one) is declared as a Schema of field codecs:
+//
+//   using PingReply = Wire::Schema<Wire::U8, Wire::U64LE, Wire::U64LE>;  // type, our clock, theirs
+//
+// and the schema provides what the hand-written readers and writers used to
+// spell out byte by byte:
+//   - size(values...): bytes on the wire; fixedSize is the same as a
+//     constant when every field has a fixed size
+//   - encode(out, values...) into a buffer the caller sized, or
+//     append(sink, values...) onto an NLPacket or byte vector
+//   - decode(data, len, outs...): strings and byte arrays come back as views
+//     into the packet, nothing is copied
+// Fixed layouts are checked for length once and then read and written
+// without branches.
+//
+// Optional sections (trailing fields, flag-gated groups) are read with a
+// Reader: read<Fields...>() takes a whole group or leaves the position and
+// the outputs of fixed groups untouched.
+//
+// Qt types follow QDataStream: big-endian, QByteArray as a quint32 length
+// and the bytes, QString as a quint32 length and UTF-16BE code units.
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace Wire {
+
+namespace detail {
+
+template <std::size_t N> struct UInt;
+template <> struct UInt<1> { using type = std::uint8_t; };
+template <> struct UInt<2> { using type = std::uint16_t; };
+template <> struct UInt<4> { using type = std::uint32_t; };
+template <> struct UInt<8> { using type = std::uint64_t; };
+
+template <typename U>
+constexpr U byteswap(U v) {
+	U out = 0;
+	for (std::size_t i = 0; i < sizeof(U); ++i) {
+		out = static_cast<U>((out << 8) | ((v >> (i * 8)) & 0xFF));
+	}
+	return out;
+}
+
+} // namespace detail
+
+// Field codecs. Each one has
+//   value_type  what encode() takes
+//   view_type   what decode() produces (a view for variable-size data)
+//   fixedSize   bytes on the wire, or 0 if that depends on the value
+//   size(v), encode(out, v) -> end of the field,
+//   decode(in, end, out) -> past the field, nullptr if truncated (fixed-size
+//   fields are only decoded once the length has been checked)
+
+template <typename T, std::endian E>
+struct Scalar {
+	static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "use Wire::Bool");
+	using value_type = T;
+	using view_type = T;
+	using Bits = typename detail::UInt<sizeof(T)>::type;
+	static constexpr std::size_t fixedSize = sizeof(T);
+
+	static constexpr std::size_t size(const T&) { return sizeof(T); }
+	static std::uint8_t* encode(std::uint8_t* out, const T& v) {
+		Bits bits = std::bit_cast<Bits>(v);
+		if constexpr (E != std::endian::native) bits = detail::byteswap(bits);
+		std::memcpy(out, &bits, sizeof(bits));
+		return out + sizeof(bits);
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t*, T& out) {
+		Bits bits;
+		std::memcpy(&bits, in, sizeof(bits));
+		if constexpr (E != std::endian::native) bits = detail::byteswap(bits);
+		out = std::bit_cast<T>(bits);
+		return in + sizeof(bits);
+	}
+};
+
+// Network / QDataStream byte order
+using U8 = Scalar<std::uint8_t, std::endian::big>;
+using U16 = Scalar<std::uint16_t, std::endian::big>;
+using U32 = Scalar<std::uint32_t, std::endian::big>;
+using U64 = Scalar<std::uint64_t, std::endian::big>;
+using I32 = Scalar<std::int32_t, std::endian::big>;
+using F32 = Scalar<float, std::endian::big>;
+// Little-endian fields (source IDs, entity packets)
+using U16LE = Scalar<std::uint16_t, std::endian::little>;
+using U32LE = Scalar<std::uint32_t, std::endian::little>;
+using U64LE = Scalar<std::uint64_t, std::endian::little>;
+using I64LE = Scalar<std::int64_t, std::endian::little>;
+using F32LE = Scalar<float, std::endian::little>;
+
+// One byte, nonzero = true
+struct Bool {
+	using value_type = bool;
+	using view_type = bool;
+	static constexpr std::size_t fixedSize = 1;
+
+	static constexpr std::size_t size(const bool&) { return 1; }
+	static std::uint8_t* encode(std::uint8_t* out, const bool& v) {
+		*out = v ? 1 : 0;
+		return out + 1;
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t*, bool& out) {
+		out = *in != 0;
+		return in + 1;
+	}
+};
+
+template <typename S>
+struct Vec3 {
+	using value_type = glm::vec3;
+	using view_type = glm::vec3;
+	static constexpr std::size_t fixedSize = 3 * S::fixedSize;
+
+	static constexpr std::size_t size(const glm::vec3&) { return fixedSize; }
+	static std::uint8_t* encode(std::uint8_t* out, const glm::vec3& v) {
+		return S::encode(S::encode(S::encode(out, v.x), v.y), v.z);
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t* end, glm::vec3& out) {
+		return S::decode(S::decode(S::decode(in, end, out.x), end, out.y), end, out.z);
+	}
+};
+
+// Quaternion in x, y, z, w order (glm::quat is constructed w first)
+template <typename S>
+struct QuatXYZW {
+	using value_type = glm::quat;
+	using view_type = glm::quat;
+	static constexpr std::size_t fixedSize = 4 * S::fixedSize;
+
+	static constexpr std::size_t size(const glm::quat&) { return fixedSize; }
+	static std::uint8_t* encode(std::uint8_t* out, const glm::quat& q) {
+		return S::encode(S::encode(S::encode(S::encode(out, q.x), q.y), q.z), q.w);
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t* end, glm::quat& out) {
+		float x, y, z, w;
+		in = S::decode(S::decode(S::decode(S::decode(in, end, x), end, y), end, z), end, w);
+		out = glm::quat(w, x, y, z);
+		return in;
+	}
+};
+
+// 16 raw bytes (QUuid in RFC 4122 byte order)
+struct Uuid {
+	using value_type = std::array<std::uint8_t, 16>;
+	using view_type = value_type;
+	static constexpr std::size_t fixedSize = 16;
+
+	static constexpr std::size_t size(const value_type&) { return 16; }
+	static std::uint8_t* encode(std::uint8_t* out, const value_type& v) {
+		std::memcpy(out, v.data(), 16);
+		return out + 16;
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t*, value_type& out) {
+		std::memcpy(out.data(), in, 16);
+		return in + 16;
+	}
+};
+
+// Byte array after a `Len` byte count. With a quint32 count Qt's null marker
+// (0xFFFFFFFF) reads as empty.
+template <typename Len>
+struct Bytes {
+	using value_type = std::span<const std::uint8_t>;
+	using view_type = value_type;
+	static constexpr std::size_t fixedSize = 0;
+
+	static constexpr std::size_t size(const value_type& v) { return Len::fixedSize + v.size(); }
+	static std::uint8_t* encode(std::uint8_t* out, const value_type& v) {
+		out = Len::encode(out, static_cast<typename Len::value_type>(v.size()));
+		if (!v.empty()) std::memcpy(out, v.data(), v.size());
+		return out + v.size();
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t* end, value_type& out) {
+		if (static_cast<std::size_t>(end - in) < Len::fixedSize) return nullptr;
+		typename Len::value_type n;
+		in = Len::decode(in, end, n);
+		if constexpr (std::is_same_v<Len, U32>) {
+			if (n == 0xFFFFFFFFu) n = 0;
+		}
+		if (static_cast<std::size_t>(end - in) < n) return nullptr;
+		out = value_type(in, n);
+		return in + n;
+	}
+};
+
+// Text after a `Len` byte count, as is (UTF-8)
+template <typename Len>
+struct Utf8 {
+	using value_type = std::string_view;
+	using view_type = value_type;
+	static constexpr std::size_t fixedSize = 0;
+
+	static constexpr std::size_t size(const value_type& v) { return Len::fixedSize + v.size(); }
+	static std::uint8_t* encode(std::uint8_t* out, const value_type& v) {
+		return Bytes<Len>::encode(out, std::span(reinterpret_cast<const std::uint8_t*>(v.data()), v.size()));
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t* end, value_type& out) {
+		std::span<const std::uint8_t> bytes;
+		in = Bytes<Len>::decode(in, end, bytes);
+		if (in) out = value_type(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		return in;
+	}
+};
+
+using QByteArray = Bytes<U32>;
+
+// QString from Latin-1 text: quint32 length, then one UTF-16BE code unit per
+// character. Decoding gives the raw UTF-16BE bytes.
+struct QString {
+	using value_type = std::string_view;
+	using view_type = std::span<const std::uint8_t>;
+	static constexpr std::size_t fixedSize = 0;
+
+	static constexpr std::size_t size(const value_type& v) { return 4 + 2 * v.size(); }
+	static std::uint8_t* encode(std::uint8_t* out, const value_type& v) {
+		out = U32::encode(out, static_cast<std::uint32_t>(v.size()));
+		for (unsigned char c : v) {
+			*out++ = 0;
+			*out++ = c;
+		}
+		return out;
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t* end, view_type& out) {
+		if (end - in < 4) return nullptr;
+		std::uint32_t chars;
+		in = U32::decode(in, end, chars);
+		if (chars == 0xFFFFFFFFu) chars = 0;
+		if (static_cast<std::size_t>(end - in) / 2 < chars) return nullptr;
+		out = view_type(in, 2 * static_cast<std::size_t>(chars));
+		return in + 2 * static_cast<std::size_t>(chars);
+	}
+};
+
+// NUL-terminated text. A missing terminator ends the string at the end of
+// the packet.
+struct CString {
+	using value_type = std::string_view;
+	using view_type = value_type;
+	static constexpr std::size_t fixedSize = 0;
+
+	static constexpr std::size_t size(const value_type& v) { return v.size() + 1; }
+	static std::uint8_t* encode(std::uint8_t* out, const value_type& v) {
+		if (!v.empty()) std::memcpy(out, v.data(), v.size());
+		out[v.size()] = 0;
+		return out + v.size() + 1;
+	}
+	static const std::uint8_t* decode(const std::uint8_t* in, const std::uint8_t* end, view_type& out) {
+		const void* nul = std::memchr(in, 0, static_cast<std::size_t>(end - in));
+		const auto* stop = nul ? static_cast<const std::uint8_t*>(nul) : end;
+		out = view_type(reinterpret_cast<const char*>(in), static_cast<std::size_t>(stop - in));
+		return nul ? stop + 1 : end;
+	}
+};
+
+// Room for `n` more bytes at the end of `sink`: an NLPacket (extend()) or a
+// byte vector.
+template <typename Sink>
+std::uint8_t* extend(Sink& sink, std::size_t n) {
+	if constexpr (requires { sink.extend(n); }) {
+		return sink.extend(n);
+	} else {
+		const std::size_t at = sink.size();
+		sink.resize(at + n);
+		return reinterpret_cast<std::uint8_t*>(sink.data()) + at;
+	}
+}
+
+class Reader {
+public:
+	Reader(const void* data, std::size_t len)
+		: m_begin(static_cast<const std::uint8_t*>(data)), m_pos(m_begin), m_end(m_begin + len) {}
+
+	// Read a group of fields, all or nothing: on failure the position is
+	// unchanged (as are the outputs, if every field has a fixed size).
+	template <typename... F>
+	bool read(typename F::view_type&... out) {
+		if constexpr (((F::fixedSize > 0) && ...)) {
+			if (remaining() < (F::fixedSize + ... + 0)) return false;
+			const std::uint8_t* p = m_pos;
+			((p = F::decode(p, m_end, out)), ...);
+			m_pos = p;
+			return true;
+		} else {
+			const std::uint8_t* p = m_pos;
+			if (!((p = readOne<F>(p, out)) && ...)) return false;
+			m_pos = p;
+			return true;
+		}
+	}
+
+	bool skip(std::size_t n) {
+		if (remaining() < n) return false;
+		m_pos += n;
+		return true;
+	}
+
+	std::size_t remaining() const { return static_cast<std::size_t>(m_end - m_pos); }
+	std::size_t offset() const { return static_cast<std::size_t>(m_pos - m_begin); }
+	const std::uint8_t* position() const { return m_pos; }
+
+private:
+	template <typename F>
+	const std::uint8_t* readOne(const std::uint8_t* p, typename F::view_type& out) const {
+		if constexpr (F::fixedSize > 0) {
+			if (static_cast<std::size_t>(m_end - p) < F::fixedSize) return nullptr;
+		}
+		return F::decode(p, m_end, out);
+	}
+
+	const std::uint8_t* m_begin;
+	const std::uint8_t* m_pos;
+	const std::uint8_t* m_end;
+};
+
+template <typename... F>
+struct Schema {
+	static constexpr bool isFixed = ((F::fixedSize > 0) && ...);
+	// Exact size of a fixed layout (0 if any field is variable)
+	static constexpr std::size_t fixedSize = isFixed ? (F::fixedSize + ... + 0) : 0;
+
+	static constexpr std::size_t size(const typename F::value_type&... v) {
+		if constexpr (isFixed) {
+			return fixedSize;
+		} else {
+			return (F::size(v) + ... + 0);
+		}
+	}
+
+	// Write the fields at `out`, which must have size(v...) bytes. Returns
+	// the end of what was written.
+	static std::uint8_t* encode(std::uint8_t* out, const typename F::value_type&... v) {
+		((out = F::encode(out, v)), ...);
+		return out;
+	}
+
+	template <typename Sink>
+	static void append(Sink& sink, const typename F::value_type&... v) {
+		encode(extend(sink, size(v...)), v...);
+	}
+
+	// Decode from the start of `data`; bytes past the schema are ignored.
+	static bool decode(const void* data, std::size_t len, typename F::view_type&... out) {
+		Reader reader(data, len);
+		return reader.read<F...>(out...);
+	}
+
+	// Read the next group from `reader`, all or nothing
+	static bool read(Reader& reader, typename F::view_type&... out) {
+		return reader.read<F...>(out...);
+	}
+};
+
+} // namespace Wire
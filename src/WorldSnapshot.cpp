@@ -0,0 +1,296 @@
+// WorldSnapshot.cpp
+#include "WorldSnapshot.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+namespace WorldSnapshot {
+
+namespace {
+
+constexpr std::size_t kHeaderCrcBytes = offsetof(Header, headerCrc);
+
+std::uint32_t crc32Of(const void* data, std::size_t len) {
+    uLong crc = ::crc32(0L, Z_NULL, 0);
+    const auto* bytes = static_cast<const Bytef*>(data);
+    // zlib takes uInt lengths; feed large buffers in chunks
+    while (len > 0) {
+        const uInt chunk = static_cast<uInt>(std::min<std::size_t>(len, 1u << 30));
+        crc = ::crc32(crc, bytes, chunk);
+        bytes += chunk;
+        len -= chunk;
+    }
+    return static_cast<std::uint32_t>(crc);
+}
+
+} // anonymous namespace
+
+fs::path pathForDomain(const std::string& domainKey) {
+    fs::path dir;
+    if (const char* home = std::getenv("HOME")) {
+        dir = fs::path(home) / ".cache" / "starworld" / "snapshots";
+    } else {
+        dir = fs::path("/tmp") / "starworld" / "snapshots";
+    }
+    std::string name;
+    name.reserve(domainKey.size());
+    for (char c : domainKey) {
+        const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '-';
+        name.push_back(safe ? c : '_');
+    }
+    if (name.empty()) name = "default";
+    return dir / (name + ".snap");
+}
+
+// ============================================================================
+// Builder
+// ============================================================================
+
+std::uint32_t Builder::intern(const std::string& s) {
+    if (s.empty()) return 0;
+    auto it = m_stringOffsets.find(s);
+    if (it != m_stringOffsets.end()) return it->second;
+    const auto offset = static_cast<std::uint32_t>(m_strings.size());
+    m_strings.insert(m_strings.end(), s.begin(), s.end());
+    m_strings.push_back('\0');
+    m_stringOffsets.emplace(s, offset);
+    return offset;
+}
+
+void Builder::update(const OverteEntity& e, const StringTable& strings) {
+    if (e.slot >= m_records.size()) {
+        m_records.resize(e.slot + 1);
+        m_live.resize(e.slot + 1, 0);
+    }
+    Record& r = m_records[e.slot];
+    std::memcpy(r.uuid, e.id.bytes.data(), 16);
+    r.position[0] = e.position.x; r.position[1] = e.position.y; r.position[2] = e.position.z;
+    r.rotation[0] = e.rotation.x; r.rotation[1] = e.rotation.y; r.rotation[2] = e.rotation.z; r.rotation[3] = e.rotation.w;
+    r.scale[0] = e.scale.x; r.scale[1] = e.scale.y; r.scale[2] = e.scale.z;
+    r.dimensions[0] = e.dimensions.x; r.dimensions[1] = e.dimensions.y; r.dimensions[2] = e.dimensions.z;
+    r.color[0] = e.color.r; r.color[1] = e.color.g; r.color[2] = e.color.b; r.color[3] = e.alpha;
+    r.nameOffset = intern(strings.str(e.name));
+    r.modelUrlOffset = intern(strings.str(e.modelUrl));
+    r.textureUrlOffset = intern(strings.str(e.textureUrl));
+    std::memcpy(r.parentUuid, e.parentId.bytes.data(), 16);
+    r.parentJoint = e.parentJoint;
+    r.type = static_cast<std::uint8_t>(e.type);
+    std::memset(r.reserved, 0, sizeof(r.reserved));
+    if (!m_live[e.slot]) {
+        m_live[e.slot] = 1;
+        ++m_liveCount;
+    }
+}
+
+void Builder::remove(std::uint32_t slot) {
+    if (slot < m_live.size() && m_live[slot]) {
+        m_live[slot] = 0;
+        --m_liveCount;
+    }
+}
+
+void Builder::clear() {
+    m_records.clear();
+    m_live.clear();
+    m_liveCount = 0;
+    m_strings.assign(1, '\0');
+    m_stringOffsets.clear();
+}
+
+void Builder::compactStrings() {
+    std::vector<char> old;
+    old.swap(m_strings);
+    m_strings.assign(1, '\0');
+    m_stringOffsets.clear();
+    for (std::size_t i = 0; i < m_records.size(); ++i) {
+        if (!m_live[i]) continue;
+        Record& r = m_records[i];
+        r.nameOffset = intern(old.data() + r.nameOffset);
+        r.modelUrlOffset = intern(old.data() + r.modelUrlOffset);
+        r.textureUrlOffset = intern(old.data() + r.textureUrlOffset);
+    }
+}
+
+void Builder::build(std::vector<Record>& records, std::vector<char>& strings) {
+    // Strings of erased/edited entities are never reclaimed in place; rebuild
+    // the table once most of it is garbage.
+    if (m_strings.size() > 64 * 1024) {
+        std::vector<std::uint8_t> used(m_strings.size(), 0);
+        std::size_t usedBytes = 0;
+        for (std::size_t i = 0; i < m_records.size(); ++i) {
+            if (!m_live[i]) continue;
+            for (std::uint32_t off : {m_records[i].nameOffset, m_records[i].modelUrlOffset, m_records[i].textureUrlOffset}) {
+                if (off == 0 || used[off]) continue;
+                used[off] = 1;
+                usedBytes += std::strlen(m_strings.data() + off) + 1;
+            }
+        }
+        if (usedBytes * 2 < m_strings.size()) compactStrings();
+    }
+
+    records.clear();
+    records.reserve(m_liveCount);
+    for (std::size_t i = 0; i < m_records.size(); ++i) {
+        if (m_live[i]) records.push_back(m_records[i]);
+    }
+    strings = m_strings;
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+bool writeFile(const fs::path& path, const std::vector<Record>& records, const std::vector<char>& strings) {
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.recordCount = static_cast<std::uint32_t>(records.size());
+    header.stringBytes = static_cast<std::uint32_t>(strings.size());
+    header.recordsCrc = crc32Of(records.data(), records.size() * sizeof(Record));
+    header.stringsCrc = crc32Of(strings.data(), strings.size());
+    header.headerCrc = crc32Of(&header, kHeaderCrcBytes);
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    const fs::path tmp = path.string() + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+        out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+        if (!out) return false;
+    }
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+Writer::Writer() : m_thread([this] { run(); }) {}
+
+Writer::~Writer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void Writer::submit(fs::path path, std::vector<Record> records, std::vector<char> strings) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = Job{std::move(path), std::move(records), std::move(strings)};
+        m_hasJob = true;
+    }
+    m_wake.notify_one();
+}
+
+void Writer::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [&] { return m_stop || m_hasJob; });
+        if (!m_hasJob) return; // stop requested, nothing pending
+        Job job = std::move(m_job);
+        m_hasJob = false;
+        lock.unlock();
+
+        if (!writeFile(job.path, job.records, job.strings)) {
+            std::cerr << "[WorldSnapshot] Failed to write " << job.path << std::endl;
+        }
+
+        lock.lock();
+    }
+}
+
+// ============================================================================
+// MappedFile
+// ============================================================================
+
+MappedFile::~MappedFile() { close(); }
+
+void MappedFile::close() {
+    if (m_map) ::munmap(m_map, m_mapSize);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_records = nullptr;
+    m_recordCount = 0;
+    m_strings = nullptr;
+    m_stringBytes = 0;
+}
+
+bool MappedFile::open(const fs::path& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+    m_map = map;
+    m_mapSize = size;
+
+    const auto* base = static_cast<const char*>(map);
+    Header header;
+    std::memcpy(&header, base, sizeof(header));
+    const std::size_t recordBytes = static_cast<std::size_t>(header.recordCount) * sizeof(Record);
+    const bool valid =
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+        header.version == kVersion &&
+        header.headerCrc == crc32Of(&header, kHeaderCrcBytes) &&
+        header.stringBytes >= 1 &&
+        size == sizeof(Header) + recordBytes + header.stringBytes &&
+        base[size - 1] == '\0' &&
+        header.recordsCrc == crc32Of(base + sizeof(Header), recordBytes) &&
+        header.stringsCrc == crc32Of(base + sizeof(Header) + recordBytes, header.stringBytes);
+    if (!valid) {
+        std::cerr << "[WorldSnapshot] Ignoring invalid snapshot " << path << std::endl;
+        close();
+        return false;
+    }
+
+    m_records = reinterpret_cast<const Record*>(base + sizeof(Header));
+    m_recordCount = header.recordCount;
+    m_strings = base + sizeof(Header) + recordBytes;
+    m_stringBytes = header.stringBytes;
+    return true;
+}
+
+const char* MappedFile::string(std::uint32_t offset) const {
+    return offset < m_stringBytes ? m_strings + offset : "";
+}
+
+void MappedFile::decode(std::size_t i, OverteEntity& out, StringTable& strings) const {
+    const Record& r = m_records[i];
+    out.id = EntityUuid::fromBytes(r.uuid);
+    out.name = strings.acquire(string(r.nameOffset));
+    out.position = glm::vec3(r.position[0], r.position[1], r.position[2]);
+    out.rotation = glm::quat(r.rotation[3], r.rotation[0], r.rotation[1], r.rotation[2]);
+    out.scale = glm::vec3(r.scale[0], r.scale[1], r.scale[2]);
+    out.dimensions = glm::vec3(r.dimensions[0], r.dimensions[1], r.dimensions[2]);
+    out.color = glm::vec3(r.color[0], r.color[1], r.color[2]);
+    out.alpha = r.color[3];
+    out.modelUrl = strings.acquire(string(r.modelUrlOffset));
+    out.textureUrl = strings.acquire(string(r.textureUrlOffset));
+    out.parentId = EntityUuid::fromBytes(r.parentUuid);
+    out.parentJoint = r.parentJoint;
+    out.type = r.type <= static_cast<std::uint8_t>(EntityType::Material) ? static_cast<EntityType>(r.type) : EntityType::Unknown;
+}
+
+} // namespace WorldSnapshot
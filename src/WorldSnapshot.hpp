@@ -0,0 +1,152 @@
+// WorldSnapshot.hpp
+// Per-domain binary snapshot of the entity store for warm startup.
+//
+// File layout (little-endian, mmap-able):
+//   Header   (64 bytes, CRC32 over its first 28 bytes)
+//   Record[] (fixed 116-byte POD records, CRC32 over the array)
+//   Strings  (NUL-terminated, deduplicated; offset 0 is the empty string)
+//
+// Snapshots live in ~/.cache/starworld/snapshots/<domain>.snap. They are
+// written to a temp file by a background thread and renamed into place, so a
+// reader always sees either the previous or the new complete file. Only the
+// records touched since the last capture are re-encoded (Builder), but each
+// capture writes the whole file: 116 bytes per live entity plus the strings,
+// off the main thread.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "EntityStore.hpp"
+
+namespace WorldSnapshot {
+
+constexpr char kMagic[8] = {'S', 'W', 'S', 'N', 'A', 'P', '0', '1'};
+constexpr std::uint32_t kVersion = 2; // 2: parent link
+
+struct Header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t recordCount;
+	std::uint32_t stringBytes;
+	std::uint32_t recordsCrc;
+	std::uint32_t stringsCrc;
+	std::uint32_t headerCrc;   // CRC32 of all preceding header bytes
+	std::uint8_t reserved[32];
+};
+static_assert(sizeof(Header) == 64, "snapshot header layout");
+
+struct Record {
+	std::uint8_t uuid[16];
+	float position[3];
+	float rotation[4];   // x, y, z, w
+	float scale[3];
+	float dimensions[3];
+	float color[4];      // r, g, b, alpha
+	std::uint32_t nameOffset;
+	std::uint32_t modelUrlOffset;
+	std::uint32_t textureUrlOffset;
+	std::uint8_t parentUuid[16]; // all zero = no parent
+	std::uint16_t parentJoint;
+	std::uint8_t type;
+	std::uint8_t reserved[1];
+};
+static_assert(sizeof(Record) == 116, "snapshot record layout");
+
+// ~/.cache/starworld/snapshots/<sanitized domain key>.snap
+std::filesystem::path pathForDomain(const std::string& domainKey);
+
+// Incrementally maintained image of the store, indexed by EntityStore slot.
+// Only slots touched since the last capture are re-encoded.
+class Builder {
+public:
+	void update(const OverteEntity& entity, const StringTable& strings);
+	void remove(std::uint32_t slot);
+	void clear();
+
+	// Pack live records and the string table for writing. Compacts the
+	// string table when more than half of it is unreferenced.
+	void build(std::vector<Record>& records, std::vector<char>& strings);
+
+	std::size_t liveCount() const { return m_liveCount; }
+
+private:
+	std::uint32_t intern(const std::string& s);
+	void compactStrings();
+
+	std::vector<Record> m_records;
+	std::vector<std::uint8_t> m_live;
+	std::size_t m_liveCount{0};
+	std::vector<char> m_strings{'\0'};
+	std::unordered_map<std::string, std::uint32_t> m_stringOffsets;
+};
+
+// Background writer. submit() replaces any not-yet-written image.
+class Writer {
+public:
+	Writer();
+	~Writer(); // writes any pending image before returning
+
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+
+	void submit(std::filesystem::path path, std::vector<Record> records, std::vector<char> strings);
+
+private:
+	struct Job {
+		std::filesystem::path path;
+		std::vector<Record> records;
+		std::vector<char> strings;
+	};
+
+	void run();
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_hasJob{false};
+	bool m_stop{false};
+	Job m_job;
+	std::thread m_thread;
+};
+
+// Synchronous write (used by Writer and tests). Returns false on I/O error.
+bool writeFile(const std::filesystem::path& path, const std::vector<Record>& records, const std::vector<char>& strings);
+
+// Read-only mapping of a snapshot file. open() validates magic, version,
+// sizes and all checksums; a file failing any check is rejected whole.
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::filesystem::path& path);
+	void close();
+
+	std::size_t size() const { return m_recordCount; }
+	const Record& record(std::size_t i) const { return m_records[i]; }
+	const char* string(std::uint32_t offset) const;
+
+	// Decode record `i` into an entity (id, parent link and visual state;
+	// slot and parentSlot untouched). Names and URLs are acquired from
+	// `strings`; the caller owns those references.
+	void decode(std::size_t i, OverteEntity& out, StringTable& strings) const;
+
+private:
+	void* m_map{nullptr};
+	std::size_t m_mapSize{0};
+	const Record* m_records{nullptr};
+	std::size_t m_recordCount{0};
+	const char* m_strings{nullptr};
+	std::size_t m_stringBytes{0};
+};
+
+} // namespace WorldSnapshot
@@ -4,11 +4,32 @@
 #include "SceneSync.Hpp"
 #include "InputHandler.hpp"
 #include "DomainDiscovery.hpp"
+#include "FramePacer.hpp"
+#include "MemoryBudget.hpp"
 #include "OverteAuth.hpp"
 
+#include <cstdio>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <thread>
 #include <chrono>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+// Sessions without an explicit --overte-offset are lined up along +X this far apart (m)
+constexpr float kDomainSpacing = 100.0f;
+
+struct DomainSession {
+    std::unique_ptr<OverteClient> client;
+    std::unique_ptr<SceneSync> sceneSync;
+    std::unique_ptr<InputHandler> input;
+};
+
+} // anonymous namespace
 
 int main(int argc, char** argv) {
     // Simple CLI: --socket=/path/to.sock or --abstract=name
@@ -84,19 +105,35 @@ int main(int argc, char** argv) {
     std::cout << "[main] StardustXR connected, continuing to Overte setup..." << std::endl;
     std::cout.flush();  // Force flush to ensure message appears
 
-    // Overte localhost default assumption (can override via OVERTE_URL env or --overte=ws://host:port)
-    std::string overteUrl = "ws://127.0.0.1:40102";
+    // Overte localhost default assumption (can override via OVERTE_URL env or --overte=ws://host:port).
+    // Every --overte= (or comma-separated OVERTE_URL entry) is a concurrent domain session;
+    // the n-th --overte-offset=x,y,z places the n-th domain in Stardust space.
+    std::vector<std::string> overteUrls;
+    std::vector<glm::vec3> overteOffsets;
     bool useDiscovery = false;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         const std::string ov = "--overte=";
+        const std::string off = "--overte-offset=";
         const std::string disc = "--discover";
-        if (arg.rfind(ov, 0) == 0) overteUrl = arg.substr(ov.size());
+        if (arg.rfind(ov, 0) == 0) overteUrls.push_back(arg.substr(ov.size()));
+        else if (arg.rfind(off, 0) == 0) {
+            glm::vec3 v{0.0f};
+            if (std::sscanf(arg.c_str() + off.size(), "%f,%f,%f", &v.x, &v.y, &v.z) != 3) {
+                std::cerr << "[main] Ignoring malformed " << arg << " (expected x,y,z)" << std::endl;
+            }
+            overteOffsets.push_back(v);
+        }
         else if (arg == disc) useDiscovery = true;
     }
     if (const char* envOv = std::getenv("OVERTE_URL")) {
-        overteUrl = envOv;
+        overteUrls.clear();
+        std::stringstream list(envOv);
+        for (std::string url; std::getline(list, url, ',');) {
+            if (!url.empty()) overteUrls.push_back(url);
+        }
     }
+    if (overteUrls.empty()) overteUrls.push_back("ws://127.0.0.1:40102");
     if (const char* envDisc = std::getenv("OVERTE_DISCOVER")) {
         if (std::string(envDisc) == "1" || std::string(envDisc) == "true") useDiscovery = true;
     }
@@ -171,44 +208,73 @@ int main(int argc, char** argv) {
             if (choice < 0 || choice >= (int)domains.size()) choice = 0;
             
             const auto& pick = domains[choice];
-            overteUrl = std::string("ws://") + pick.networkHost + ":" + std::to_string(pick.httpPort);
+            const std::string overteUrl = std::string("ws://") + pick.networkHost + ":" + std::to_string(pick.httpPort);
+            overteUrls.assign(1, overteUrl);
             // Pass UDP override via env for this process lifetime
             setenv("OVERTE_UDP_PORT", std::to_string(pick.udpPort).c_str(), 1);
             std::cout << "[Discovery] Selected: " << overteUrl << std::endl;
         }
     }
     
-    std::cout << "[main] Connecting to Overte domain: " << overteUrl << std::endl;
-    OverteClient overte(overteUrl);
-    
-    // Pass authentication to OverteClient if we authenticated with metaverse
-    if (useAuth && auth.isAuthenticated()) {
-        overte.setAuth(&auth);
+    // One network session per domain. They share the compositor connection,
+    // the entity decoder threads and ModelCache, and split the per-frame budgets.
+    auto parseWorkers = std::make_shared<EntityParsePipeline::WorkerPool>();
+    std::vector<DomainSession> sessions;
+    for (std::size_t i = 0; i < overteUrls.size(); ++i) {
+        const std::string& overteUrl = overteUrls[i];
+        const glm::vec3 offset = i < overteOffsets.size() ? overteOffsets[i]
+                                                          : glm::vec3(kDomainSpacing * static_cast<float>(i), 0.0f, 0.0f);
+        std::cout << "[main] Connecting to Overte domain: " << overteUrl << std::endl;
+        DomainSession session;
+        session.client = std::make_unique<OverteClient>(overteUrl, parseWorkers);
+        OverteClient& overte = *session.client;
+        overte.setBudgetShare(1.0 / static_cast<double>(overteUrls.size()));
+
+        // Pass authentication to OverteClient if we authenticated with metaverse
+        if (useAuth && auth.isAuthenticated()) {
+            overte.setAuth(&auth);
+        }
+
+        // Overte is optional; warn if unreachable but continue in offline mode.
+        if (!overte.connect()) {
+            std::cerr << "[main] Overte domain " << overteUrl << " unreachable; running in offline mode." << std::endl;
+            std::cerr << "[main] Tip: Use --overte=host:port to specify a domain, or set STARWORLD_SIMULATE=1" << std::endl;
+        } else {
+            std::cout << "[main] Overte connection established" << std::endl;
+        }
+
+        session.sceneSync = std::make_unique<SceneSync>(i == 0 ? std::string("OverteWorld") : "OverteWorld " + overteUrl,
+                                                        glm::translate(glm::mat4(1.0f), offset));
+        session.sceneSync->setBudgetShare(1.0 / static_cast<double>(overteUrls.size()));
+        // Offsets are translations, so the same movement input applies in every domain
+        session.input = std::make_unique<InputHandler>(stardust, overte);
+        sessions.push_back(std::move(session));
     }
-    
-    // Overte is optional; warn if unreachable but continue in offline mode.
-    if (!overte.connect()) {
-        std::cerr << "[main] Overte domain unreachable; running in offline mode." << std::endl;
-        std::cerr << "[main] Tip: Use --overte=host:port to specify a domain, or set STARWORLD_SIMULATE=1" << std::endl;
-    } else {
-        std::cout << "[main] Overte connection established" << std::endl;
+    if (sessions.size() > 1) {
+        std::cout << "[main] " << sessions.size() << " concurrent domain sessions, "
+                  << parseWorkers->size() << " shared parse workers" << std::endl;
     }
 
-    InputHandler input(stardust, overte);
+    FramePacer pacer;
 
-    // Main loop
+    // Main loop: wake just before each compositor frame so the entity state we
+    // submit is as fresh as possible.
     while (stardust.running()) {
-    overte.poll();
+        const float dt = pacer.waitForFrame(stardust.frameTiming());
+
+        for (auto& session : sessions) session.client->poll();
         stardust.poll();
 
-        // Sync avatars/entities
-        SceneSync::update(stardust, overte);
+        // Sync avatars/entities, then simple input mapping
+        for (auto& session : sessions) {
+            session.sceneSync->update(stardust, *session.client);
+            session.input->update(dt);
+        }
 
-        // Simple input mapping
-        input.update(1.0f / 90.0f);
+        // Over the memory budget: shed between frames, when nothing is mid-update
+        MemoryBudget::instance().relieve(std::chrono::steady_clock::now());
 
-        // Small sleep to avoid busy-spin in the stub
-        std::this_thread::sleep_for(std::chrono::milliseconds(11));
+        pacer.endFrame();
     }
 
     return 0;
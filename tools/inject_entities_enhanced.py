@@ -11,6 +11,7 @@ Enhanced entity injection script with full property support:
 
 import socket
 import struct
+import uuid
 import time
 import argparse
 
@@ -19,12 +20,16 @@ PACKET_TYPE_ENTITY_ADD = 0x10
 PACKET_TYPE_ENTITY_EDIT = 0x11
 PACKET_TYPE_ENTITY_ERASE = 0x12
 
+def uuid_bytes(entity_id):
+    """Entity ids are 16-byte UUIDs on the wire; small ints map to UUID(int=n)."""
+    return uuid.UUID(int=entity_id).bytes
+
 def send_entity_add_full(sock, addr, entity_id, name, position, rotation, dimensions, model_url="", texture_url="", color=(1.0, 1.0, 1.0)):
     """
     Send a full EntityAdd packet with all properties
     
     Args:
-        entity_id: uint64
+        entity_id: int (sent as UUID(int=entity_id))
         name: string
         position: (x, y, z) tuple of floats
         rotation: (x, y, z, w) quaternion tuple of floats
@@ -34,9 +39,9 @@ def send_entity_add_full(sock, addr, entity_id, name, position, rotation, dimens
         color: (r, g, b) tuple of floats 0-1 (optional)
     """
     # Packet structure:
-    # [type:u8][id:u64][name:null-terminated][position:3xf32][rotation:4xf32][dimensions:3xf32][model_url:null-terminated][texture_url:null-terminated][color:3xf32]
+    # [type:u8][id:uuid(16)][name:null-terminated][position:3xf32][rotation:4xf32][dimensions:3xf32][model_url:null-terminated][texture_url:null-terminated][color:3xf32]
     
-    packet = struct.pack('<BQ', PACKET_TYPE_ENTITY_ADD, entity_id)
+    packet = struct.pack('<B', PACKET_TYPE_ENTITY_ADD) + uuid_bytes(entity_id)
     
     # Name (null-terminated string)
     packet += name.encode('utf-8') + b'\x00'
@@ -75,7 +80,7 @@ def send_entity_edit_transform(sock, addr, entity_id, position=None, rotation=No
     Send an EntityEdit packet to update transform properties
     
     Args:
-        entity_id: uint64
+        entity_id: int (sent as UUID(int=entity_id))
         position: (x, y, z) tuple or None
         rotation: (x, y, z, w) quaternion tuple or None  
         dimensions: (x, y, z) tuple or None
@@ -100,8 +105,8 @@ def send_entity_edit_transform(sock, addr, entity_id, position=None, rotation=No
         flags |= HAS_DIMENSIONS
         data += struct.pack('<fff', dimensions[0], dimensions[1], dimensions[2])
     
-    # Packet: [type:u8][id:u64][flags:u8][property data...]
-    packet = struct.pack('<BQB', PACKET_TYPE_ENTITY_EDIT, entity_id, flags)
+    # Packet: [type:u8][id:uuid(16)][flags:u8][property data...]
+    packet = struct.pack('<B', PACKET_TYPE_ENTITY_EDIT) + uuid_bytes(entity_id) + struct.pack('<B', flags)
     packet += data
     
     sock.sendto(packet, addr)
@@ -109,7 +114,7 @@ def send_entity_edit_transform(sock, addr, entity_id, position=None, rotation=No
 
 def send_entity_erase(sock, addr, entity_id):
     """Send an EntityErase packet"""
-    packet = struct.pack('<BQ', PACKET_TYPE_ENTITY_ERASE, entity_id)
+    packet = struct.pack('<B', PACKET_TYPE_ENTITY_ERASE) + uuid_bytes(entity_id)
     sock.sendto(packet, addr)
     print(f"✓ Sent EntityErase: id={entity_id}")
 
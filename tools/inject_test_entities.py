@@ -6,6 +6,7 @@ This simulates what the EntityServer would send.
 
 import socket
 import struct
+import uuid
 import time
 
 # Overte packet types (as defined in your C++ code)
@@ -13,10 +14,14 @@ PACKET_TYPE_ENTITY_ADD = 0x10
 PACKET_TYPE_ENTITY_EDIT = 0x11
 PACKET_TYPE_ENTITY_ERASE = 0x12
 
+def uuid_bytes(entity_id):
+    """Entity ids are 16-byte UUIDs on the wire; small ints map to UUID(int=n)."""
+    return uuid.UUID(int=entity_id).bytes
+
 def send_entity_add(sock, addr, entity_id, name):
     """Send an EntityAdd packet"""
-    # Packet structure: [type:u8][id:u64][name:null-terminated string]
-    packet = struct.pack('<BQ', PACKET_TYPE_ENTITY_ADD, entity_id)
+    # Packet structure: [type:u8][id:uuid(16)][name:null-terminated string]
+    packet = struct.pack('<B', PACKET_TYPE_ENTITY_ADD) + uuid_bytes(entity_id)
     packet += name.encode('utf-8') + b'\x00'
     
     sock.sendto(packet, addr)
@@ -24,16 +29,16 @@ def send_entity_add(sock, addr, entity_id, name):
 
 def send_entity_edit(sock, addr, entity_id):
     """Send an EntityEdit packet (simplified)"""
-    # Packet structure: [type:u8][id:u64][property flags...]
-    packet = struct.pack('<BQ', PACKET_TYPE_ENTITY_EDIT, entity_id)
+    # Packet structure: [type:u8][id:uuid(16)][flags:u8] (no properties)
+    packet = struct.pack('<B', PACKET_TYPE_ENTITY_EDIT) + uuid_bytes(entity_id) + b'\x00'
     
     sock.sendto(packet, addr)
     print(f"Sent EntityEdit: id={entity_id}")
 
 def send_entity_erase(sock, addr, entity_id):
     """Send an EntityErase packet"""
-    # Packet structure: [type:u8][id:u64]
-    packet = struct.pack('<BQ', PACKET_TYPE_ENTITY_ERASE, entity_id)
+    # Packet structure: [type:u8][id:uuid(16)]
+    packet = struct.pack('<B', PACKET_TYPE_ENTITY_ERASE) + uuid_bytes(entity_id)
     
     sock.sendto(packet, addr)
     print(f"Sent EntityErase: id={entity_id}")